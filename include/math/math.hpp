@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cmath>
+
 #include <platform/types.hpp>
 
 namespace hm {
@@ -38,6 +40,14 @@ inline auto max(i32 a, i32 b) -> i32 {
     return a > b ? a : b;
 }
 
+inline auto min(i32 a, i32 b, i32 c) -> i32 {
+    return a > b ? min(b, c) : min(a, c);
+}
+
+inline auto max(i32 a, i32 b, i32 c) -> i32 {
+    return a > b ? max(a, c) : max(b, c);
+}
+
 inline auto f32_abs(f32 val) -> f32 {
     return val < 0.0f ? -val : val;
 }
@@ -3,6 +3,8 @@
 #include <platform/platform.hpp>
 #include <platform/types.hpp>
 
+#include <core/color.hpp>
+
 // Reverse of _MM_SHUFFLE_, as I find that more intuitive
 #define SHUFFLE_MASK(a, b, c, d) (((d) << 6) | ((c) << 4) | ((b) << 2) | (a))
 
@@ -96,22 +98,19 @@ inline auto pack4x8_linear1_to_srgb255(color_v8 color) -> __m256i {
     return result;
 }
 
-auto inline blend_color_v8(color_v8 dest, color_v8 src) -> color_v8 {
-    // Cout = (A * A.a) + (B * (1 - A.a))
-    color_v8 blended;
-    blended.r = _mm256_mul_ps(src.r, src.a);
-    blended.g = _mm256_mul_ps(src.g, src.a);
-    blended.b = _mm256_mul_ps(src.b, src.a);
-    blended.a = _mm256_mul_ps(src.a, src.a);
+auto inline blend_premultiplied_v8(color_v8 dest, color_v8 src) -> color_v8 {
+    // Cout = Cs + Cd * (1 - As), src is premultiplied by its alpha
     __m256 one_minus_a = _mm256_sub_ps(_mm256_set1_ps(1.0f), src.a);
 
-    blended.r = _mm256_add_ps(blended.r, _mm256_mul_ps(dest.r, one_minus_a));
-    blended.g = _mm256_add_ps(blended.g, _mm256_mul_ps(dest.g, one_minus_a));
-    blended.b = _mm256_add_ps(blended.b, _mm256_mul_ps(dest.b, one_minus_a));
-    blended.a = _mm256_add_ps(blended.a, _mm256_mul_ps(dest.a, one_minus_a));
+    color_v8 blended;
+    blended.r = _mm256_fmadd_ps(dest.r, one_minus_a, src.r);
+    blended.g = _mm256_fmadd_ps(dest.g, one_minus_a, src.g);
+    blended.b = _mm256_fmadd_ps(dest.b, one_minus_a, src.b);
+    blended.a = _mm256_fmadd_ps(dest.a, one_minus_a, src.a);
 
     return blended;
 }
+
 auto inline get_color(__m256i packed_color_v8) -> color_v8 {
     const __m256i maskFF = _mm256_set1_epi32(0xFF);
     const __m256 inv255 = _mm256_set1_ps(1.0f / 255.0f);
@@ -128,3 +127,69 @@ auto inline get_color(__m256i packed_color_v8) -> color_v8 {
     result.a = a; // alpha is linear
     return result;
 }
+
+// The lookup table versions of get_color and pack4x8_linear1_to_srgb255. Same tables and rounding as
+// unpack4x8_srgb255_to_linear1 and linear1_to_packed8x4_srgb255, so they give the scalar path's pixels exactly.
+auto inline unpack4x8_srgb255_to_linear1_v8(__m256i packed_v8) -> color_v8 {
+    const __m256i maskFF = _mm256_set1_epi32(0xFF);
+
+    color_v8 result;
+    result.r = _mm256_i32gather_ps(srgb255_to_linear_lut, _mm256_and_si256(_mm256_srli_epi32(packed_v8, 16), maskFF), 4);
+    result.g = _mm256_i32gather_ps(srgb255_to_linear_lut, _mm256_and_si256(_mm256_srli_epi32(packed_v8, 8), maskFF), 4);
+    result.b = _mm256_i32gather_ps(srgb255_to_linear_lut, _mm256_and_si256(packed_v8, maskFF), 4);
+    result.a = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(packed_v8, 24)), _mm256_set1_ps(255.0f));
+    return result;
+}
+
+auto inline linear1_to_packed8x4_srgb255_v8(color_v8 color) -> __m256i {
+    const __m256 n255 = _mm256_set1_ps(255.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const i32* lut = (const i32*)linear1_to_srgb255_lut;
+
+    // Clamped, the scalar version trusts its input to be in [0, 1]
+    __m256i r_idx = _mm256_cvttps_epi32(_mm256_fmadd_ps(clamp_f32_v8(0.0f, color.r, 1.0f), n255, half));
+    __m256i g_idx = _mm256_cvttps_epi32(_mm256_fmadd_ps(clamp_f32_v8(0.0f, color.g, 1.0f), n255, half));
+    __m256i b_idx = _mm256_cvttps_epi32(_mm256_fmadd_ps(clamp_f32_v8(0.0f, color.b, 1.0f), n255, half));
+    __m256i ai = _mm256_cvttps_epi32(_mm256_fmadd_ps(clamp_f32_v8(0.0f, color.a, 1.0f), n255, half));
+
+    __m256i result = _mm256_or_si256(                                                                 //
+        _mm256_or_si256(_mm256_slli_epi32(ai, 24), _mm256_slli_epi32(_mm256_i32gather_epi32(lut, r_idx, 4), 16)), //
+        _mm256_or_si256(_mm256_slli_epi32(_mm256_i32gather_epi32(lut, g_idx, 4), 8), _mm256_i32gather_epi32(lut, b_idx, 4)));
+    return result;
+}
+
+struct color_v16 {
+    __m512 r;
+    __m512 g;
+    __m512 b;
+    __m512 a;
+};
+
+auto inline unpack4x8_srgb255_to_linear1_v16(__m512i packed_v16) -> color_v16 {
+    const __m512i maskFF = _mm512_set1_epi32(0xFF);
+
+    color_v16 result;
+    result.r = _mm512_i32gather_ps(_mm512_and_si512(_mm512_srli_epi32(packed_v16, 16), maskFF), srgb255_to_linear_lut, 4);
+    result.g = _mm512_i32gather_ps(_mm512_and_si512(_mm512_srli_epi32(packed_v16, 8), maskFF), srgb255_to_linear_lut, 4);
+    result.b = _mm512_i32gather_ps(_mm512_and_si512(packed_v16, maskFF), srgb255_to_linear_lut, 4);
+    result.a = _mm512_div_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(packed_v16, 24)), _mm512_set1_ps(255.0f));
+    return result;
+}
+
+auto inline linear1_to_packed8x4_srgb255_v16(color_v16 color) -> __m512i {
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512 n255 = _mm512_set1_ps(255.0f);
+    const __m512 half = _mm512_set1_ps(0.5f);
+
+    __m512i r_idx = _mm512_cvttps_epi32(_mm512_fmadd_ps(_mm512_min_ps(_mm512_max_ps(color.r, zero), one), n255, half));
+    __m512i g_idx = _mm512_cvttps_epi32(_mm512_fmadd_ps(_mm512_min_ps(_mm512_max_ps(color.g, zero), one), n255, half));
+    __m512i b_idx = _mm512_cvttps_epi32(_mm512_fmadd_ps(_mm512_min_ps(_mm512_max_ps(color.b, zero), one), n255, half));
+    __m512i ai = _mm512_cvttps_epi32(_mm512_fmadd_ps(_mm512_min_ps(_mm512_max_ps(color.a, zero), one), n255, half));
+
+    __m512i result = _mm512_or_si512(                                                                                  //
+        _mm512_or_si512(_mm512_slli_epi32(ai, 24), _mm512_slli_epi32(_mm512_i32gather_epi32(r_idx, linear1_to_srgb255_lut, 4), 16)), //
+        _mm512_or_si512(_mm512_slli_epi32(_mm512_i32gather_epi32(g_idx, linear1_to_srgb255_lut, 4), 8),                          //
+            _mm512_i32gather_epi32(b_idx, linear1_to_srgb255_lut, 4)));
+    return result;
+}
@@ -52,7 +52,7 @@ typedef struct {
 #undef COMPILER_MSVC
 #define COMPILER_MSVC 1
 #else
-#unsed COMPILER_LLVM
+#undef COMPILER_LLVM
 #define COMPILER_LLVM 1
 #endif
 #endif
@@ -199,6 +199,27 @@ inline auto get_thread_id() -> u32 {
 
     return (ThreadID);
 }
+#elif COMPILER_LLVM
+#include <sys/syscall.h>
+#include <unistd.h>
+
+inline auto atomic_add_u64(u64 volatile* value, u64 addend) -> u64 {
+    u64 original_value = __atomic_fetch_add(value, addend, __ATOMIC_SEQ_CST);
+    return original_value;
+}
+
+inline auto atomic_exchange_u64(u64 volatile* value, u64 exchange) -> u64 {
+    u64 orignal_value = __atomic_exchange_n(value, exchange, __ATOMIC_SEQ_CST);
+    return orignal_value;
+}
+
+inline auto get_thread_id() -> u32 {
+    return (u32)syscall(SYS_gettid);
+}
 #else
 #error Unsupported architecture
 #endif
+
+inline auto memory_barrier() -> void {
+    _mm_mfence();
+}
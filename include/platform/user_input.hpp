@@ -6,10 +6,9 @@
 
 #define ArrayCount(Array) (sizeof(Array) / sizeof((Array)[0]))
 
+// No constructor: anonymous structs in unions may only hold trivial types outside of MSVC.
+// Zero initialize instead.
 struct ButtonState {
-    ButtonState() : half_transition_count(0), ended_down(false) {
-    }
-
     i32 half_transition_count; // How many times it flipped between up and down
     bool ended_down;
 
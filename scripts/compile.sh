@@ -0,0 +1,45 @@
+#!/bin/bash
+# Linux counterpart of compile.bat, for the targets that do not need a window.
+# -march=native: the renderer calls AVX-512 intrinsics behind runtime checks, which clang only
+# compiles when the target has them. The perf farm builds on the machine it runs on.
+set -e
+
+CommonCompilerFlags="-O0 -g -std=c++20 -march=native -ffast-math -fno-rtti -fno-exceptions"
+CommonCompilerFlags="-DHOMEMADE_DEBUG=1 -DHOMEMADE_SLOW=1 -DHOMEMADE_LINUX=1 $CommonCompilerFlags"
+CommonLinkerFlags="-lpthread"
+CommonInclude="-I../src/ -I../include/"
+CXX=${CXX:-clang++}
+
+mkdir -p build
+pushd build > /dev/null
+
+headless_renderer() {
+    CompileCmd="$CXX $CommonCompilerFlags $CommonInclude -shared -fPIC ../src/renderers/headless_software_renderer.cpp -o libheadless_software_renderer.so $CommonLinkerFlags"
+    echo $CompileCmd
+    $CompileCmd
+}
+
+renderer_benchmark() {
+    # Optimized, the numbers are meaningless otherwise. Asserts stay on, like in the game.
+    CompileCmd="$CXX ${CommonCompilerFlags/-O0/-O2} $CommonInclude ../src/renderer_benchmark_main.cpp -o renderer_benchmark $CommonLinkerFlags"
+    echo $CompileCmd
+    $CompileCmd
+}
+
+software_renderer_tests() {
+    # Optimized, the members of Array's extern templates only link when they are inlined.
+    CompileCmd="$CXX ${CommonCompilerFlags/-O0/-O2} -DENGINE_TEST -DDOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS $CommonInclude ../tests/test_software_renderer_main.cpp -o software_renderer_tests $CommonLinkerFlags"
+    echo $CompileCmd
+    $CompileCmd
+}
+
+for target in "$@"; do
+    case "$target" in
+    headless_renderer) headless_renderer ;;
+    renderer_benchmark) renderer_benchmark ;;
+    software_renderer_tests) software_renderer_tests ;;
+    *) echo "Unknown target: $target" && exit 1 ;;
+    esac
+done
+
+popd > /dev/null
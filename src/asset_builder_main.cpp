@@ -11,6 +11,8 @@
 
 #include <math/vec2.hpp>
 
+#include <renderers/texture_format.hpp>
+
 #include <core/lib.cpp>
 #include <third-party/stb_image.cpp>
 #include <third-party/stb_image_write.cpp>
@@ -54,6 +56,24 @@ struct AssetSource {
     };
 };
 
+// Bitmaps and font atlases are baked in the software renderer's layout, so loading them is a plain read.
+// The OpenGL renderer converts them back when they are uploaded.
+const PixelFormat Bitmap_Pixel_Format = PixelFormat_SoftwareNative;
+
+/// @brief: Writes width x height RGBA8 texels in Bitmap_Pixel_Format.
+static auto write_texels(FILE* out, u32* rgba, i32 width, i32 height) -> void {
+    if (Bitmap_Pixel_Format == PixelFormat_RGBA8) {
+        fwrite(rgba, sizeof(u32), width * height, out);
+    }
+    else {
+        u64 size = pixel_format_size(Bitmap_Pixel_Format, width, height);
+        u32* native = (u32*)malloc(size);
+        convert_rgba8_to_software_native(rgba, width, height, native);
+        fwrite(native, size, 1, out);
+        free(native);
+    }
+}
+
 const u32 MAX_ASSETS_COUNT = 4096;
 const u32 MAX_TAGS_COUNT = 4096;
 struct GameAssetsWrite {
@@ -426,9 +446,10 @@ static auto write_asset_file(GameAssetsWrite* assets, const char* file_name) ->
                 Bitmap bitmap = load_bitmap_stbi(source->bitmap.file_name);
                 meta->bitmap.dim[0] = bitmap.width;
                 meta->bitmap.dim[1] = bitmap.height;
+                meta->bitmap.pixel_format = Bitmap_Pixel_Format;
 
                 Assert((bitmap.width * 4) == bitmap.pitch);
-                fwrite(bitmap.data, bitmap.pitch * bitmap.height, 1, out);
+                write_texels(out, (u32*)bitmap.data, bitmap.width, bitmap.height);
 
                 free(bitmap.data);
             } break;
@@ -456,9 +477,14 @@ static auto write_asset_file(GameAssetsWrite* assets, const char* file_name) ->
                 meta->font.bitmap_height = font.bitmap_height;
                 meta->font.bitmap_size_per_pixel = font.bitmap_bytes_per_pixel;
                 meta->font.font_height = font.font_height;
+                meta->font.bitmap_pixel_format = Bitmap_Pixel_Format;
 
                 fwrite(font.code_points, sizeof(CodePoint), font.code_point_count, out);
-                fwrite(font.bitmap, font.bitmap_bytes_per_pixel, font.bitmap_width * font.bitmap_height, out);
+                // Padding up to the atlas
+                u64 padding = font_bitmap_offset(&meta->font) - font.code_point_count * sizeof(CodePoint);
+                u8 zeroes[64] = {};
+                fwrite(zeroes, 1, padding, out);
+                write_texels(out, font.bitmap, font.bitmap_width, font.bitmap_height);
 
             } break;
             case AssetType_Invalid:
@@ -96,6 +96,11 @@ inline vec4 srgb_to_linear1(vec4 color) {
     return result;
 }
 
+/// @brief: Straight to premultiplied alpha. color is linear, premultiplying sRGB values is wrong.
+inline auto premultiply_alpha(vec4 color) -> vec4 {
+    return vec4(color.r * color.a, color.g * color.a, color.b * color.a, color.a);
+}
+
 inline auto unpack4x8_srgb255_to_linear1(u32 packed) -> vec4 {
     u8 r = (packed >> 16) & 0xFF;
     u8 g = (packed >> 8) & 0xFF;
@@ -33,6 +33,19 @@ auto inline fnv_1a_64bit(string8 s) -> u64 {
     return hash;
 }
 
+auto inline fnv_1a_64bit(const void* data, u64 size) -> u64 {
+    const u64 FNV_offset_basis = 0xcbf29ce484222325;
+    const u64 FNV_prime = 0x00000100000001b3;
+
+    u64 hash = FNV_offset_basis;
+    const u8* bytes = (const u8*)data;
+    for (u64 i = 0; i < size; i++) {
+        hash = hash XOR bytes[i];
+        hash = hash * FNV_prime;
+    }
+    return hash;
+}
+
 auto inline hash32(string8 s) {
     return fnv_1a_32bit(s);
 }
@@ -41,6 +54,15 @@ auto inline hash64(string8 s) {
     return fnv_1a_64bit(s);
 }
 
+auto inline hash64(const void* data, u64 size) {
+    return fnv_1a_64bit(data, size);
+}
+
+/// @brief: Order dependent combination of two hashes.
+auto inline hash64_combine(u64 seed, u64 value) -> u64 {
+    return seed XOR (value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2));
+}
+
 // TODO: Testing
 //
 /*Test a hash function in terms of properties and invariants, not “correctness” in the cryptographic sense (unless you have official test vectors).*/
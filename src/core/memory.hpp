@@ -30,9 +30,15 @@ typedef void (*set_memory_u32_fn)(u32*, u32, i64);
 void set_memory_u32_init(u32* dest, u32 value, i64 count);
 void set_memory_u32_scalar(u32* dest, u32 value, i64 count);
 void set_memory_u32_avx512(u32* dest, u32 value, i64 count);
-void set_memory_u32_avx512_stream(u32* dest, u32 value, i64 count);
 global_variable set_memory_u32_fn set_memory_u32 = set_memory_u32_init;
 
+// Non-temporal variants, for memory nothing reads back soon. The stores bypass the cache and are weakly
+// ordered: call _mm_sfence() before another thread may read dest.
+void set_memory_u32_stream_init(u32* dest, u32 value, i64 count);
+void set_memory_u32_avx2_stream(u32* dest, u32 value, i64 count);
+void set_memory_u32_avx512_stream(u32* dest, u32 value, i64 count);
+global_variable set_memory_u32_fn set_memory_u32_stream = set_memory_u32_stream_init;
+
 void clear_memory(void* memory, u64 size);
 
 void DEBUG_print_memory_as_hex(void* memory, u64 size);
@@ -27,21 +27,65 @@ auto inline calculate_face_normals(Array<vec4> vertices, Array<ivec3> triangles,
     return normals;
 }
 
+auto inline create_vertex_positions(Array<vec4> vertices, MemoryArena& arena) -> VertexPositions {
+    u32 padded_count = vertex_batch_padded_count(vertices.count());
+    VertexPositions positions = {};
+    positions.x = Array<f32>::create(padded_count, arena);
+    positions.y = Array<f32>::create(padded_count, arena);
+    positions.z = Array<f32>::create(padded_count, arena);
+    for (u32 i = 0; i < vertices.count(); i++) {
+        positions.x[i] = vertices[i].x;
+        positions.y[i] = vertices[i].y;
+        positions.z[i] = vertices[i].z;
+    }
+    return positions;
+}
+
+/// @brief: Sums the normals of the faces around each vertex, weighted by their area, and normalizes the sum.
+auto inline calculate_vertex_normals(Array<vec4> vertices, Array<ivec3> triangles, MemoryArena& arena) -> VertexNormals {
+    auto sums = Array<vec3>::create(vertices.count(), arena);
+    for (auto triangle : triangles) {
+        vec3 a = vertices[triangle.x].xyz();
+        vec3 b = vertices[triangle.y].xyz();
+        vec3 c = vertices[triangle.z].xyz();
+        // Same winding as calculate_face_normals, twice the area long
+        vec3 normal = cross(b - a, c - b);
+        sums[triangle.x] = sums[triangle.x] + normal;
+        sums[triangle.y] = sums[triangle.y] + normal;
+        sums[triangle.z] = sums[triangle.z] + normal;
+    }
+
+    u32 padded_count = vertex_batch_padded_count(vertices.count());
+    VertexNormals normals = {};
+    normals.x = Array<f32>::create(padded_count, arena);
+    normals.y = Array<f32>::create(padded_count, arena);
+    normals.z = Array<f32>::create(padded_count, arena);
+    for (u32 i = 0; i < vertices.count(); i++) {
+        vec3 normal = normalized(sums[i]);
+        normals.x[i] = normal.x;
+        normals.y[i] = normal.y;
+        normals.z[i] = normal.z;
+    }
+    return normals;
+}
+
 auto inline generate_cube_mesh(TriMesh* cube, MemoryArena* arena) -> void {
-    cube->vertices = Array<vec4>::create(8, arena);
+    // Only read to build the mesh, which keeps them as positions
+    vec4 vertex_data[8];
+    Array<vec4> vertices = Array<vec4>(vertex_data, ArrayCount(vertex_data));
     cube->triangles = Array<ivec3>::create(12, arena);
 
     // front
-    cube->vertices[0] = vec4(1.0f, 1.0f, 1.0f, 1.0f);
-    cube->vertices[1] = vec4(-1.0f, 1.0f, 1.0f, 1.0f);
-    cube->vertices[2] = vec4(-1.0f, -1.0f, 1.0f, 1.0f);
-    cube->vertices[3] = vec4(1.0f, -1.0f, 1.0f, 1.0f);
+    vertices[0] = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    vertices[1] = vec4(-1.0f, 1.0f, 1.0f, 1.0f);
+    vertices[2] = vec4(-1.0f, -1.0f, 1.0f, 1.0f);
+    vertices[3] = vec4(1.0f, -1.0f, 1.0f, 1.0f);
 
     // back
-    cube->vertices[4] = vec4(1.0f, 1.0f, -1.0f, 1.0f);
-    cube->vertices[5] = vec4(-1.0f, 1.0f, -1.0f, 1.0f);
-    cube->vertices[6] = vec4(-1.0f, -1.0f, -1.0f, 1.0f);
-    cube->vertices[7] = vec4(1.0f, -1.0f, -1.0f, 1.0f);
+    vertices[4] = vec4(1.0f, 1.0f, -1.0f, 1.0f);
+    vertices[5] = vec4(-1.0f, 1.0f, -1.0f, 1.0f);
+    vertices[6] = vec4(-1.0f, -1.0f, -1.0f, 1.0f);
+    vertices[7] = vec4(1.0f, -1.0f, -1.0f, 1.0f);
 
     cube->triangles[0] = ivec3(0, 1, 2);
     cube->triangles[1] = ivec3(0, 2, 3);
@@ -56,5 +100,10 @@ auto inline generate_cube_mesh(TriMesh* cube, MemoryArena* arena) -> void {
     cube->triangles[10] = ivec3(2, 6, 7);
     cube->triangles[11] = ivec3(2, 7, 3);
 
-    cube->normals = calculate_face_normals(cube->vertices, cube->triangles, *g_transient);
+    cube->normals = calculate_face_normals(vertices, cube->triangles, *arena);
+    cube->positions = create_vertex_positions(vertices, *arena);
+    cube->vertex_count = vertices.count();
+    cube->vertex_normals = calculate_vertex_normals(vertices, cube->triangles, *arena);
+    cube->bounds = AABB_create_empty();
+    AABB_set_points(cube->bounds, vertices);
 }
@@ -81,3 +81,78 @@ auto inline merge_sort_indices(i32* values, i32 count, MemoryArena* arena) -> i3
 
     return dest_indices;
 }
+
+/// @brief: Stable LSD radix sort of i32 keys, one byte per pass. Same contract as merge_sort_indices: values are
+/// sorted in place and the returned array holds the original index of every sorted value.
+/// Already sorted input, e.g. when every key is the same, only costs one pass over the keys.
+auto inline radix_sort_indices(i32* values, i32 count, MemoryArena* arena) -> i32* {
+    Assert(values);
+    i32* indices = allocate<i32>(arena, count, DoNotClearArenaParams());
+    for (i32 i = 0; i < count; i++) {
+        indices[i] = i;
+    }
+
+    bool is_sorted = true;
+    for (i32 i = 1; i < count && is_sorted; i++) {
+        is_sorted = values[i - 1] <= values[i];
+    }
+    if (is_sorted) {
+        return indices;
+    }
+
+    // Flipping the sign bit makes the unsigned byte order match the signed order.
+    const u32 sign_bit = 0x80000000;
+    const i32 radix = 256;
+    const i32 pass_count = 4;
+    u32 histograms[pass_count][radix] = {};
+    for (i32 i = 0; i < count; i++) {
+        u32 key = (u32)values[i] ^ sign_bit;
+        for (i32 pass = 0; pass < pass_count; pass++) {
+            histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    u32* src = (u32*)values;
+    u32* dest = allocate<u32>(arena, count, DoNotClearArenaParams());
+    i32* src_indices = indices;
+    i32* dest_indices = allocate<i32>(arena, count, DoNotClearArenaParams());
+    for (i32 i = 0; i < count; i++) {
+        src[i] ^= sign_bit;
+    }
+
+    for (i32 pass = 0; pass < pass_count; pass++) {
+        u32* histogram = histograms[pass];
+        u32 shift = pass * 8;
+
+        // Every key has the same byte, this pass would not move anything.
+        if (histogram[(src[0] >> shift) & 0xFF] == (u32)count) {
+            continue;
+        }
+
+        u32 offset = 0;
+        for (i32 i = 0; i < radix; i++) {
+            u32 bucket_count = histogram[i];
+            histogram[i] = offset;
+            offset += bucket_count;
+        }
+
+        for (i32 i = 0; i < count; i++) {
+            u32 key = src[i];
+            u32 dest_idx = histogram[(key >> shift) & 0xFF]++;
+            dest[dest_idx] = key;
+            dest_indices[dest_idx] = src_indices[i];
+        }
+
+        u32* temp = src;
+        src = dest;
+        dest = temp;
+        i32* temp_indices = src_indices;
+        src_indices = dest_indices;
+        dest_indices = temp_indices;
+    }
+
+    for (i32 i = 0; i < count; i++) {
+        values[i] = (i32)(src[i] ^ sign_bit);
+    }
+    return src_indices;
+}
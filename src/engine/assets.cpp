@@ -13,6 +13,7 @@
 #include "engine/hugin_file_formats.hpp"
 #include "math/math.hpp"
 #include "platform/types.hpp"
+#include "renderers/texture_format.hpp"
 
 struct LoadAssetWork {
     PlatformFileHandle handle;
@@ -117,8 +118,10 @@ auto load_bitmap(GameAssets* game_assets, BitmapId id) -> void {
             asset->asset_memory->bitmap.width = meta->bitmap.dim[0];
             asset->asset_memory->bitmap.height = meta->bitmap.dim[1];
             asset->asset_memory->bitmap.align_percentage = meta->bitmap.align_percentage;
-            auto size = meta->bitmap.dim[0] * meta->bitmap.dim[1] * BitmapBytePerPixel;
-            asset->asset_memory->bitmap.data = allocate<u8>(game_assets->memory, size);
+            asset->asset_memory->bitmap.pixel_format = meta->bitmap.pixel_format;
+            auto size = pixel_format_size(meta->bitmap.pixel_format, meta->bitmap.dim[0], meta->bitmap.dim[1]);
+            // Cache line aligned, the software renderer samples the texels where they are loaded
+            asset->asset_memory->bitmap.data = game_assets->memory->allocate(size, { .alignment = 64, .flags = 0 });
 
             LoadAssetWork* work = allocate<LoadAssetWork>(task->memory);
             work->size = size;
@@ -157,6 +160,7 @@ auto load_font(GameAssets* game_assets, FontId id) -> void {
             asset->asset_memory->font.bitmap_width = meta->font.bitmap_width;
             asset->asset_memory->font.bitmap_height = meta->font.bitmap_height;
             asset->asset_memory->font.bitmap_size_per_pixel = meta->font.bitmap_size_per_pixel;
+            asset->asset_memory->font.bitmap_pixel_format = meta->font.bitmap_pixel_format;
 
             asset->asset_memory->font.font_height = meta->font.font_height;
             asset->asset_memory->font.ascent = meta->font.ascent;
@@ -166,13 +170,15 @@ auto load_font(GameAssets* game_assets, FontId id) -> void {
             asset->asset_memory->font.code_point_last = meta->font.code_point_last;
             asset->asset_memory->font.code_point_count = meta->font.code_point_count;
 
-            const u64 bitmap_size = meta->font.bitmap_width * meta->font.bitmap_height * meta->font.bitmap_size_per_pixel;
-            const u64 code_points_size = meta->font.code_point_count * sizeof(CodePoint);
-            const u64 size = code_points_size + bitmap_size;
+            Assert(meta->font.bitmap_size_per_pixel == sizeof(u32));
+            const u64 bitmap_size =
+                pixel_format_size(meta->font.bitmap_pixel_format, meta->font.bitmap_width, meta->font.bitmap_height);
+            const u64 bitmap_offset = font_bitmap_offset(&meta->font);
+            const u64 size = bitmap_offset + bitmap_size;
 
-            u8* buffer = allocate<u8>(game_assets->memory, code_points_size + bitmap_size);
+            u8* buffer = (u8*)game_assets->memory->allocate(size, { .alignment = 64, .flags = 0 });
             asset->asset_memory->font.code_points = (CodePoint*)buffer;
-            asset->asset_memory->font.bitmap = buffer + code_points_size;
+            asset->asset_memory->font.bitmap = buffer + bitmap_offset;
 
             LoadAssetWork* work = allocate<LoadAssetWork>(task->memory);
             work->size = size;
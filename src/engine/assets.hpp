@@ -18,6 +18,7 @@ struct LoadedBitmap {
 
     vec2 align_percentage;
 
+    PixelFormat pixel_format;
     void* data;
 };
 
@@ -42,6 +43,7 @@ struct LoadedFont {
     i32 bitmap_width;
     i32 bitmap_height;
     i32 bitmap_size_per_pixel;
+    PixelFormat bitmap_pixel_format;
     void* bitmap;
 };
 
@@ -173,7 +173,8 @@ ENGINE_UPDATE_AND_RENDER(update_and_render) {
             state->ui_context = UI_CreateContext(&state->permanent);
             UI_SetContext(state->ui_context);
             UI_SetFont(font_id.value, font);
-            renderer->add_texture(font_id.value, font->bitmap, font->bitmap_width, font->bitmap_height, font->bitmap_size_per_pixel);
+            renderer->add_texture(font_id.value, font->bitmap, font->bitmap_width, font->bitmap_height, //
+                font->bitmap_size_per_pixel, font->bitmap_pixel_format);
             UI_SetContext(nullptr);
         }
     }
@@ -223,6 +224,10 @@ ENGINE_UPDATE_AND_RENDER(update_and_render) {
             if (input.tab.is_pressed_this_frame()) {
                 state->show_profile_window = !state->show_profile_window;
             }
+            if (input.f.is_pressed_this_frame()) {
+                state->is_pipelined = !state->is_pipelined;
+            }
+            renderer->set_pipelined(state->is_pipelined);
         }
         // Update based on input
         {
@@ -406,12 +411,9 @@ ENGINE_UPDATE_AND_RENDER(update_and_render) {
         group.push_buffer_size = 0;
         group.max_push_buffer_size = MegaBytes(4);
         group.push_buffer = allocate<u8>(*g_transient, group.max_push_buffer_size);
-        group.sort_keys.init(g_transient, 1024);
-        group.sort_entries_offset.init(g_transient, 1024);
+        init_render_group_commands(&group, g_transient, 1024);
 
-        auto* clear = PushRenderElement(&group, RenderEntryClearCheckPattern, 0);
-        clear->color1 = REALLY_DARK_GREY;
-        clear->color2 = DARK_GREY;
+        push_clear_check_pattern(&group, { .color1 = REALLY_DARK_GREY, .color2 = DARK_GREY }, 0);
 
         if (false) {
             vec3 center = vec3(app_input->client_width / 2.0f, app_input->client_height / 2.0f, 0.0f);
@@ -439,81 +441,86 @@ ENGINE_UPDATE_AND_RENDER(update_and_render) {
             Assert(global_color_palette.count() >= ArrayCount(end_points));
 
             for (u32 i = 0; i < ArrayCount(end_points); i++) {
-                auto* line = PushRenderElement(&group, RenderEntryLine, 0);
-                line->start = center;
-                line->end = end_points[i];
-                line->color = global_color_palette[i];
+                push_line(&group, { .start = center, .end = end_points[i], .color = global_color_palette[i] }, 0);
             }
         }
 
         const f32 size = 100.0f;
         if (false) {
             vec2 center = vec2(app_input->client_width / 2.0f, app_input->client_height / 2.0f);
-            auto* circle = PushRenderElement(&group, RenderEntryCircle, 0);
-            circle->P = center;
-            circle->radius = 16.0f;
-            circle->color = global_color_palette[0];
+            push_circle(&group, { .P = center, .radius = 16.0f, .color = global_color_palette[0] }, 0);
         }
 
         if (false) {
             vec2 center = vec2(app_input->client_width / 2.0f, app_input->client_height / 2.0f);
-            auto* circle = PushRenderElement(&group, RenderEntryFilledCircle, 0);
-            circle->P = center;
-            circle->radius = 16.0f;
-            circle->color = global_color_palette[0];
+            push_filled_circle(&group, { .P = center, .radius = 16.0f, .color = global_color_palette[0] }, 0);
         }
         if (false) {
             vec3 center = { app_input->client_width / 16.0f, app_input->client_height / 16.0f, 0.0f };
-            auto* triangle = PushRenderElement(&group, RenderEntryFilledTriangle, 0);
+            RenderEntryFilledTriangle triangle = {};
             f32 t = (f32)app_input->t;
-            triangle->vertices[0] = center;
-            triangle->vertices[1] = (vec3(cosf(t), sinf(t), 0.0f) * 10) + center;
-            triangle->vertices[2] = vec3(10.0f, 0.0f, 0.0f) + center;
-            triangle->color = global_color_palette[0];
+            triangle.vertices[0] = center;
+            triangle.vertices[1] = (vec3(cosf(t), sinf(t), 0.0f) * 10) + center;
+            triangle.vertices[2] = vec3(10.0f, 0.0f, 0.0f) + center;
+            triangle.color = global_color_palette[0];
+            push_filled_triangle(&group, triangle, 0);
         }
         if (false) {
             vec2 center = vec2(app_input->client_width / 2.0f, app_input->client_height / 2.0f);
-            auto* triangle = PushRenderElement(&group, RenderEntryShadedTriangle, 0);
+            RenderEntryShadedTriangle triangle = {};
             f32 t = (f32)app_input->t;
             // t = PI + 0.1;
-            triangle->vertices[0] = center;
-            triangle->vertices[1] = (vec2(cosf(t), sinf(t)) * size) + center;
-            triangle->vertices[2] = vec2(size, 0.0f) + center;
-            triangle->h0 = 0.0;
-            triangle->h1 = 0.0;
-            triangle->h2 = 1.0;
-            triangle->color = global_color_palette[0];
+            triangle.vertices[0] = center;
+            triangle.vertices[1] = (vec2(cosf(t), sinf(t)) * size) + center;
+            triangle.vertices[2] = vec2(size, 0.0f) + center;
+            triangle.h0 = 0.0;
+            triangle.h1 = 0.0;
+            triangle.h2 = 1.0;
+            triangle.color = global_color_palette[0];
+            push_shaded_triangle(&group, triangle, 0);
         }
 
         if (true) {
             vec2 center = vec2(app_input->client_width / 2.0f, app_input->client_height / 2.0f);
-            auto* mesh = PushRenderElement(&group, RenderEntryTriMesh, 0);
+            RenderEntryTriMesh mesh = {};
 
-            generate_cube_mesh(&mesh->model, g_transient);
+            generate_cube_mesh(&mesh.model, g_transient);
 
-            mesh->instances = Array<MeshInstance>::create(3, g_transient);
+            mesh.instances = Array<MeshInstance>::create(3, g_transient);
 
             const vec3 up(0.0f, 1.0f, 0.0f);
-            mesh->instances[0].transform.scale = vec3(1.0f, 1.0f, 1.0f);
-            mesh->instances[0].transform.position = vec3(-1.5, 0, 4);
-            mesh->instances[0].transform.rotation = angle_axis((f32)app_input->t * 0.5f, up);
-            mesh->instances[0].colors = global_color_palette.to_array();
+            mesh.instances[0].transform.scale = vec3(1.0f, 1.0f, 1.0f);
+            mesh.instances[0].transform.position = vec3(-1.5, 0, 4);
+            mesh.instances[0].transform.rotation = angle_axis((f32)app_input->t * 0.5f, up);
+            mesh.instances[0].colors = global_color_palette.to_array();
 
-            mesh->instances[1].transform.scale = vec3(1.0f, 1.0f, 1.0f);
-            mesh->instances[1].transform.position = vec3(1.5f, 1.0f, 4.0f);
-            mesh->instances[1].transform.rotation = angle_axis(0, up);
-            mesh->instances[1].colors = global_color_palette.to_array();
+            mesh.instances[1].transform.scale = vec3(1.0f, 1.0f, 1.0f);
+            mesh.instances[1].transform.position = vec3(1.5f, 1.0f, 4.0f);
+            mesh.instances[1].transform.rotation = angle_axis(0, up);
+            mesh.instances[1].colors = global_color_palette.to_array();
 
             auto colors = Array<vec4>::create(1, *g_transient);
             colors[0] = WHITE;
-            mesh->instances[2].transform.scale = vec3(0.1f, 0.1f, 0.1f);
-            mesh->instances[2].transform.position = vec3(-3.0f, 2.0f, 2.0f);
-            mesh->instances[2].transform.rotation = angle_axis(0, up);
-            mesh->instances[2].colors = colors;
-
-            mesh->world_to_view = camera_get_view(state->camera);
-            mesh->view_to_clip = perspective(60.0f, aspect_ratio, 0.1, 1000.0);
-            mesh->camera_position = vec4(state->camera.m_position, 1.0f);
+            mesh.instances[2].transform.scale = vec3(0.1f, 0.1f, 0.1f);
+            mesh.instances[2].transform.position = vec3(-3.0f, 2.0f, 2.0f);
+            mesh.instances[2].transform.rotation = angle_axis(0, up);
+            mesh.instances[2].colors = colors;
+
+            mesh.world_to_view = camera_get_view(state->camera);
+            mesh.view_to_clip = perspective(60.0f, aspect_ratio, 0.1, 1000.0);
+            mesh.camera_position = vec4(state->camera.m_position, 1.0f);
+
+            mesh.is_lit = true;
+            mesh.lights.ambient.color = vec4(0.15f, 0.15f, 0.15f, 1.0f);
+            mesh.lights.directional = Array<DirectionalLight>::create(1, g_transient);
+            vec3 L = normalized(vec3(0.5f, 1.0f, -0.75f));
+            mesh.lights.directional[0].L = vec4(L.x, L.y, L.z, 0.0f);
+            mesh.lights.directional[0].color = vec4(0.6f, 0.6f, 0.55f, 1.0f);
+            // At the white marker
+            mesh.lights.point = Array<PointLight>::create(1, g_transient);
+            mesh.lights.point[0].P = vec4(-3.0f, 2.0f, 2.0f, 1.0f);
+            mesh.lights.point[0].color = vec4(0.5f, 0.5f, 0.5f, 1.0f);
+            push_tri_mesh(&group, mesh, 0);
         }
 
         { renderer->render(thread_context, false, &group, state->handle_3D); }
@@ -524,11 +531,9 @@ ENGINE_UPDATE_AND_RENDER(update_and_render) {
         group.push_buffer_size = 0;
         group.max_push_buffer_size = MegaBytes(4);
         group.push_buffer = allocate<u8>(*g_transient, group.max_push_buffer_size);
-        group.sort_keys.init(g_transient, 1024);
-        group.sort_entries_offset.init(g_transient, 1024);
+        init_render_group_commands(&group, g_transient, 1024);
 
-        auto* clear = PushRenderElement(&group, RenderEntryClear, 0);
-        clear->color = vec4(0.0f, 0.0f, 0.0, 0.0);
+        push_clear(&group, { .color = vec4(0.0f, 0.0f, 0.0, 0.0) }, 0);
 
         {
             f32 direction = clamp(state->player.speed.x, -1.0, 1.0);
@@ -543,20 +548,22 @@ ENGINE_UPDATE_AND_RENDER(update_and_render) {
                 i32 width = bitmap->width;
                 i32 height = bitmap->height;
                 void* data = bitmap->data;
-                renderer->add_texture(bitmap_id.value, data, width, height, sizeof(u32));
+                renderer->add_texture(bitmap_id.value, data, width, height, sizeof(u32), bitmap->pixel_format);
 
                 auto& player = state->player;
-                auto* render_bm = PushRenderElement(&group, RenderEntryBitmap, 0);
-                render_bm->quad = {
+                RenderEntryBitmap render_bm = {};
+                render_bm.quad = {
                     .bl = player.vertices[0],
                     .tl = player.vertices[1],
                     .tr = player.vertices[2],
                     .br = player.vertices[3],
                 };
-                render_bm->offset = player.P;
-                render_bm->scale = player.scale;
-                render_bm->rotation = player.rotation;
-                render_bm->texture_id = bitmap_id.value;
+                render_bm.offset = player.P;
+                render_bm.scale = player.scale;
+                render_bm.rotation = player.rotation;
+                render_bm.color = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+                render_bm.texture_id = bitmap_id.value;
+                push_bitmap(&group, render_bm, 0);
             }
         }
 
@@ -565,25 +572,32 @@ ENGINE_UPDATE_AND_RENDER(update_and_render) {
             auto bitmap_id = get_first_bitmap_id(state->assets, AssetGroupId_EnemySpaceShip);
             auto bitmap = get_bitmap(state->assets, bitmap_id);
 
-            if (bitmap) {
+            if (bitmap && state->enemies.size() != 0) {
                 i32 width = bitmap->width;
                 i32 height = bitmap->height;
                 void* data = bitmap->data;
-                renderer->add_texture(bitmap_id.value, data, width, height, sizeof(u32));
-
+                renderer->add_texture(bitmap_id.value, data, width, height, sizeof(u32), bitmap->pixel_format);
+
+                // One bitmap, so they all share its quad
+                auto meta = get_bitmap_meta(state->assets, bitmap_id);
+                auto bbox = get_bbox(&meta);
+                RenderEntryBitmapBatch entry = {};
+                entry.quad = { .bl = bbox.bl, .tl = bbox.tl, .tr = bbox.tr, .br = bbox.br };
+                entry.texture_id = bitmap_id.value;
+                entry.count = (i32)state->enemies.size();
+                auto* batch = push_bitmap_batch(&group, entry, 0);
+                BitmapBatchInstances instances = get_bitmap_batch_instances(batch);
+                i32 i = 0;
                 for (auto& enemy : state->enemies) {
-                    auto* render_el = PushRenderElement(&group, RenderEntryBitmap, 0);
-                    render_el->quad = {
-                        .bl = enemy.vertices[0],
-                        .tl = enemy.vertices[1],
-                        .tr = enemy.vertices[2],
-                        .br = enemy.vertices[3],
-                    };
-                    render_el->offset = enemy.P;
-                    render_el->scale = enemy.scale;
-                    render_el->rotation = enemy.rotation;
-                    render_el->texture_id = bitmap_id.value;
+                    instances.offset_x[i] = enemy.P.x;
+                    instances.offset_y[i] = enemy.P.y;
+                    instances.scale_x[i] = enemy.scale.x;
+                    instances.scale_y[i] = enemy.scale.y;
+                    instances.rotation[i] = enemy.rotation;
+                    instances.color[i] = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+                    i++;
                 }
+                end_bitmap_batch(&group, batch);
             }
         }
 
@@ -595,22 +609,28 @@ ENGINE_UPDATE_AND_RENDER(update_and_render) {
                     i32 width = bitmap->width;
                     i32 height = bitmap->height;
                     void* data = bitmap->data;
-                    renderer->add_texture(bitmap_id.value, data, width, height, sizeof(u32));
-                }
-                for (auto& proj : state->player_projectiles) {
-                    if (bitmap) {
-                        auto* rendel_el = PushRenderElement(&group, RenderEntryBitmap, 0);
-                        rendel_el->quad = {
-                            .bl = proj.vertices[0],
-                            .tl = proj.vertices[1],
-                            .tr = proj.vertices[2],
-                            .br = proj.vertices[3],
-                        };
-                        rendel_el->offset = proj.P;
-                        rendel_el->scale = proj.scale;
-                        rendel_el->rotation = proj.rotation;
-                        rendel_el->texture_id = bitmap_id.value;
+                    renderer->add_texture(bitmap_id.value, data, width, height, sizeof(u32), bitmap->pixel_format);
+
+                    // One bitmap, so they all share its quad
+                    auto meta = get_bitmap_meta(state->assets, bitmap_id);
+                    auto bbox = get_bbox(&meta);
+                    RenderEntryBitmapBatch entry = {};
+                    entry.quad = { .bl = bbox.bl, .tl = bbox.tl, .tr = bbox.tr, .br = bbox.br };
+                    entry.texture_id = bitmap_id.value;
+                    entry.count = (i32)state->player_projectiles.size();
+                    auto* batch = push_bitmap_batch(&group, entry, 0);
+                    BitmapBatchInstances instances = get_bitmap_batch_instances(batch);
+                    i32 i = 0;
+                    for (auto& proj : state->player_projectiles) {
+                        instances.offset_x[i] = proj.P.x;
+                        instances.offset_y[i] = proj.P.y;
+                        instances.scale_x[i] = proj.scale.x;
+                        instances.scale_y[i] = proj.scale.y;
+                        instances.rotation[i] = proj.rotation;
+                        instances.color[i] = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+                        i++;
                     }
+                    end_bitmap_batch(&group, batch);
                 }
             }
         }
@@ -627,15 +647,17 @@ ENGINE_UPDATE_AND_RENDER(update_and_render) {
                         i32 width = bitmap->width;
                         i32 height = bitmap->height;
                         void* data = bitmap->data;
-                        renderer->add_texture(bitmap_id.value, data, width, height, sizeof(u32));
+                        renderer->add_texture(bitmap_id.value, data, width, height, sizeof(u32), bitmap->pixel_format);
                     }
                     if (bitmap) {
-                        auto* rendel_el = PushRenderElement(&group, RenderEntryBitmap, 0);
-                        rendel_el->quad = { .bl = bbox.bl, .tl = bbox.tl, .tr = bbox.tr, .br = bbox.br };
-                        rendel_el->offset = ex.P;
-                        rendel_el->scale = ex.scale;
-                        rendel_el->rotation = ex.rotation;
-                        rendel_el->texture_id = bitmap_id.value;
+                        RenderEntryBitmap rendel_el = {};
+                        rendel_el.quad = { .bl = bbox.bl, .tl = bbox.tl, .tr = bbox.tr, .br = bbox.br };
+                        rendel_el.offset = ex.P;
+                        rendel_el.scale = ex.scale;
+                        rendel_el.rotation = ex.rotation;
+                        rendel_el.color = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+                        rendel_el.texture_id = bitmap_id.value;
+                        push_bitmap(&group, rendel_el, 0);
                     }
                 }
             }
@@ -663,10 +685,8 @@ ENGINE_UPDATE_AND_RENDER(update_and_render) {
             ui_render_group.push_buffer_size = 0;
             ui_render_group.max_push_buffer_size = MegaBytes(64);
             ui_render_group.push_buffer = allocate<u8>(*g_transient, ui_render_group.max_push_buffer_size);
-            ui_render_group.sort_keys.init(g_transient, 2 * 2048);
-            ui_render_group.sort_entries_offset.init(g_transient, 2 * 2048);
-            auto* clear = PushRenderElement(&ui_render_group, RenderEntryClear, -1);
-            clear->color = vec4(0.0f, 0.0f, 0.0, 0.0);
+            init_render_group_commands(&ui_render_group, g_transient, 2 * 2048);
+            push_clear(&ui_render_group, { .color = vec4(0.0f, 0.0f, 0.0, 0.0) }, -1);
 
             UI_Generate_Render_Commands(&ui_render_group);
             BEGIN_BLOCK("gui_render");
@@ -926,10 +946,8 @@ ENGINE_UPDATE_AND_RENDER(update_and_render) {
             ui_render_group.max_push_buffer_size = MegaBytes(1);
             ui_render_group.push_buffer =
                 allocate<u8>(*g_transient, ui_render_group.max_push_buffer_size, DoNotClearArenaParams());
-            ui_render_group.sort_keys.init(g_transient, 2048);
-            ui_render_group.sort_entries_offset.init(g_transient, 2048);
-            auto* clear = PushRenderElement(&ui_render_group, RenderEntryClear, -1);
-            clear->color = vec4(0.0f, 0.0f, 0.0, 0.0);
+            init_render_group_commands(&ui_render_group, g_transient, 2048);
+            push_clear(&ui_render_group, { .color = vec4(0.0f, 0.0f, 0.0, 0.0) }, -1);
 
             UI_Generate_Render_Commands(&ui_render_group);
             END_BLOCK();
@@ -946,10 +964,8 @@ ENGINE_UPDATE_AND_RENDER(update_and_render) {
     //     background_group.push_buffer_size = 0;
     //     background_group.max_push_buffer_size = MegaBytes(1);
     //     background_group.push_buffer = allocate<u8>(*g_transient, background_group.max_push_buffer_size);
-    //     background_group.sort_keys.init(g_transient, 1);
-    //     background_group.sort_entries_offset.init(g_transient, 1);
-    //     auto* clear = PushRenderElement(&background_group, RenderEntryClear, 0);
-    //     clear->color = vec4(0.0f, 0.0f, 0.0, 1.0);
+    //     init_render_group_commands(&background_group, g_transient, 1);
+    //     push_clear(&background_group, { .color = vec4(0.0f, 0.0f, 0.0, 1.0) }, 0);
     //     renderer->render(thread_context, true, &background_group, state->handle_background);
     // }
 
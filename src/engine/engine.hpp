@@ -190,6 +190,7 @@ struct EngineState {
 
     UI_Context* ui_context;
     bool show_profile_window;
+    bool is_pipelined;
 };
 
 extern "C" __declspec(dllexport) ENGINE_UPDATE_AND_RENDER(update_and_render);
@@ -494,46 +494,58 @@ auto UI_Generate_Render_Commands(RenderGroup* render_group) -> void {
 
         // render_el->color = entity->background_color;
         if (entity->flags & UI_WidgetFlag_DrawBackground) {
-            auto* render_el = PushRenderElement(render_group, RenderEntryQuad, entity->z_index);
-            render_el->quad.min_x = bl.x;
-            render_el->quad.min_y = bl.y;
-            render_el->quad.max_x = tr.x;
-            render_el->quad.max_y = tr.y;
-            render_el->color = entity->background_color;
-            render_el->border_thickness = entity->border_thickness;
-            render_el->border_color = entity->border_color;
+            RenderEntryQuad render_el = {};
+            render_el.quad.min_x = bl.x;
+            render_el.quad.min_y = bl.y;
+            render_el.quad.max_x = tr.x;
+            render_el.quad.max_y = tr.y;
+            render_el.color = entity->background_color;
+            render_el.border_thickness = entity->border_thickness;
+            render_el.border_color = entity->border_color;
+            push_quad(render_group, render_el, entity->z_index);
         }
 
         if (entity->flags & UI_WidgetFlag_DrawText) {
             LoadedFont* font = global_context->font;
             y = y - (entity->computed_size[Axis2_Y] - font->font_height) * 0.5f - font->ascent;
+
+            i32 glyph_count = 0;
+            for (const CodePoint& cp : entity->text) {
+                glyph_count += cp.c != ' ';
+            }
+
+            // One command for the whole text. The glyphs are copied to whole pixels, so they stay sharp.
+            RenderEntryGlyphRun* run = nullptr;
+            GlyphRunGlyph* glyph = nullptr;
+            if (glyph_count > 0) {
+                // The atlas is white and is drawn as is
+                RenderEntryGlyphRun entry = {
+                    .color = WHITE, .texture_id = global_context->texture_id, .count = glyph_count };
+                run = push_glyph_run(render_group, entry, entity->z_index + 1);
+                glyph = get_glyph_run_glyphs(run);
+            }
             for (const CodePoint& cp : entity->text) {
                 if (cp.c == ' ') {
                     x += Space_Width;
                     continue;
                 }
 
-                ivec2 uv_min = ivec2(cp.x0, cp.y0);
-                ivec2 uv_max = ivec2(cp.x1, cp.y1);
-                auto glyph_width = uv_max.x - uv_min.x;
-                auto glyph_height = uv_max.y - uv_min.y;
-
-                auto* char_el = PushRenderElement(render_group, RenderEntryBitmap, entity->z_index + 1);
-                char_el->uv_min = uv_min;
-                char_el->uv_max = uv_max;
-
-                char_el->quad = { .bl = vec2(-0.5f, -0.5f), .tl = vec2(-0.5f, 0.5f), .tr = vec2(0.5f, 0.5f), .br = vec2(0.5f, -0.5f) };
-                // Offset with 0.5f to not make the bilinear interpolation not make the font blurry.
-                char_el->offset = vec2((glyph_width) / 2.0f + x + cp.xoff + 0.5f,
-                    (glyph_height / 2.0f) + y - (glyph_height + cp.yoff) + 0.5f);
-                char_el->scale = vec2((f32)glyph_width, (f32)glyph_height);
-                char_el->rotation = 0.0f;
-                char_el->color = RED;
-                char_el->texture_id = global_context->texture_id;
-
-                // Offset with 0.5f to not make the bilinear interpolation not make the font blurry.
+                // The pixels a unit quad scaled to the glyph, offset by 0.5f, would cover
+                i32 glyph_height = cp.y1 - cp.y0;
+                glyph->x = round_f32_to_i32(x + cp.xoff + 0.5f);
+                glyph->y = round_f32_to_i32(y - (glyph_height + cp.yoff) + 0.5f);
+                glyph->u_min = cp.x0;
+                glyph->v_min = cp.y0;
+                glyph->u_max = cp.x1;
+                glyph->v_max = cp.y1;
+                glyph++;
+
+                // If you update this, check UI_GetCodePointsTotalLength
                 x += floorf(cp.xadvance + 0.5f);
             }
+            if (run) {
+                end_glyph_run(render_group, run);
+            }
         }
 
         if (entity->first) {
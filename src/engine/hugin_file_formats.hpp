@@ -69,6 +69,15 @@ struct AssetGroup {
     u32 one_past_last_asset_tag_index;
 };
 
+// How the texels of bitmaps and font atlases are stored
+enum PixelFormat : u32 {
+    // Straight alpha, R G B A bytes, rows bottom up
+    PixelFormat_RGBA8 = 0,
+    // What the software renderer samples, so it can use the loaded bytes as they are: ARGB words, alpha premultiplied
+    // in linear space, in 4x4 texel blocks with partial blocks padded. See renderers/texture_format.hpp.
+    PixelFormat_SoftwareNative,
+};
+
 struct CodePoint {
     u16 x0, y0, x1, y1;
     f32 xoff, yoff, xadvance;
@@ -87,11 +96,19 @@ struct FontMeta {
     i32 bitmap_width;
     i32 bitmap_height;
     i32 bitmap_size_per_pixel;
+    PixelFormat bitmap_pixel_format;
 };
 
+// The atlas starts on a cache line after the code points, so it can be sampled where it is loaded
+inline auto font_bitmap_offset(FontMeta* meta) -> u64 {
+    u64 code_points_size = meta->code_point_count * sizeof(CodePoint);
+    return (code_points_size + 63) & ~63ull;
+}
+
 struct BitmapMeta {
     u32 dim[2];
     vec2 align_percentage;
+    PixelFormat pixel_format;
 };
 
 struct AudioMeta {
@@ -114,7 +131,7 @@ struct AssetMeta {
 struct HafHeader {
 #define HAF_MAGIC_VALUE HAF_CODE('h', 'a', 'f', 'c')
     u32 magic_value;
-#define HAF_VERSION 1
+#define HAF_VERSION 2
     u32 version;
 
     u32 asset_group_count;
@@ -0,0 +1,128 @@
+#pragma once
+
+// The Linux version of the win32_main.cpp work queue, for hosts without a window, like the headless renderer.
+#include <execinfo.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <unistd.h>
+
+#include <core/array.hpp>
+#include <platform/platform.hpp>
+#include <platform/types.hpp>
+
+struct platform_work_queue_entry {
+    platform_work_queue_callback* Callback;
+    void* Data;
+};
+
+struct PlatformWorkQueue {
+    u32 volatile completion_goal;
+    u32 volatile completion_count;
+
+    u32 volatile NextEntryToWrite;
+    u32 volatile NextEntryToRead;
+
+    sem_t semaphore;
+
+    platform_work_queue_entry entries[256];
+};
+
+internal void linux_add_work_queue_entry(PlatformWorkQueue* queue, platform_work_queue_callback* callback, void* data) {
+    // NOTE: This function assumes only a single thread writes to it.
+    u32 new_next_entry_to_write = (queue->NextEntryToWrite + 1) % ArrayCount(queue->entries);
+    // Means the work queue is full
+    Assert(new_next_entry_to_write != queue->NextEntryToRead);
+    platform_work_queue_entry* entry = queue->entries + queue->NextEntryToWrite;
+    entry->Callback = callback;
+    entry->Data = data;
+    queue->completion_goal = queue->completion_goal + 1;
+
+    memory_barrier();
+
+    queue->NextEntryToWrite = new_next_entry_to_write;
+    sem_post(&queue->semaphore);
+}
+
+/// @return: true if there was no work to do
+internal bool linux_do_next_work_entry(ThreadContext* context) {
+    PlatformWorkQueue* queue = context->queue;
+    bool we_should_sleep = false;
+
+    u32 original_next_entry_to_read = queue->NextEntryToRead;
+    u32 new_next_entry_to_read = (original_next_entry_to_read + 1) % ArrayCount(queue->entries);
+    if (original_next_entry_to_read != queue->NextEntryToWrite) {
+        bool is_taken = __sync_bool_compare_and_swap( //
+            &queue->NextEntryToRead,                  //
+            original_next_entry_to_read, new_next_entry_to_read);
+
+        if (is_taken) {
+            platform_work_queue_entry entry = queue->entries[original_next_entry_to_read];
+            context->scratch.clear();
+            entry.Callback(context, entry.Data);
+            __sync_fetch_and_add(&queue->completion_count, 1);
+        }
+    }
+    else {
+        we_should_sleep = true;
+    }
+
+    return we_should_sleep;
+}
+
+internal void linux_complete_all_work(ThreadContext* thread_context) {
+    while (thread_context->queue->completion_count != thread_context->queue->completion_goal) {
+        if (linux_do_next_work_entry(thread_context)) {
+            sched_yield();
+        }
+    }
+
+    thread_context->queue->completion_goal = 0;
+    thread_context->queue->completion_count = 0;
+}
+
+internal void* linux_worker_proc(void* parameter) {
+    ThreadContext* context = (ThreadContext*)parameter;
+    context->thread_id = get_thread_id();
+    while (true) {
+        if (linux_do_next_work_entry(context)) {
+            sem_wait(&context->queue->semaphore);
+        }
+    }
+    return nullptr;
+}
+
+/// @brief: Thread 0 is the calling thread, every other context gets a worker thread.
+internal void linux_make_queue(PlatformApi* platform, Array<ThreadContext> contexts, Array<MemoryBlock> memory_blocks) {
+    const u32 thread_count = (u32)contexts.count();
+
+    PlatformWorkQueue* queue = platform->work_queue;
+    queue->completion_goal = 0;
+    queue->completion_count = 0;
+
+    queue->NextEntryToRead = 0;
+    queue->NextEntryToWrite = 0;
+    sem_init(&queue->semaphore, 0, 0);
+
+    for (u32 i = 0; i < thread_count; i++) {
+        ThreadContext* context = &contexts[i];
+
+        context->thread_idx = i;
+        context->scratch.init((u8*)memory_blocks[i].data, memory_blocks[i].size);
+        context->queue = queue;
+        if (i == MAIN_THREAD_IDX) {
+            context->thread_id = get_thread_id();
+        }
+        else {
+            pthread_t thread;
+            pthread_create(&thread, nullptr, linux_worker_proc, context);
+            pthread_detach(thread);
+        }
+    }
+}
+
+internal void linux_print_stack_trace() {
+    void* stack[50];
+    i32 frames = backtrace(stack, 50);
+    backtrace_symbols_fd(stack, frames, STDERR_FILENO);
+}
@@ -2,7 +2,7 @@
 
 #include "math/mat4.hpp"
 #include "math/math.hpp"
-#include <engine/array.hpp>
+#include <core/array.hpp>
 
 #include <math/vec3.hpp>
 #include <math/vec4.hpp>
@@ -18,9 +18,10 @@ auto inline AABB_create_empty() -> AABB {
     bbox.min.y = F32_MAX;
     bbox.min.z = F32_MAX;
 
-    bbox.max.x = F32_MIN;
-    bbox.max.y = F32_MIN;
-    bbox.max.z = F32_MIN;
+    // F32_MIN is the smallest positive f32, not the lowest
+    bbox.max.x = -F32_MAX;
+    bbox.max.y = -F32_MAX;
+    bbox.max.z = -F32_MAX;
     return bbox;
 }
 
@@ -31,97 +32,36 @@ auto inline AABB_set_points(AABB& bbox, const Array<vec4>& points) -> void {
         bbox.min.y = hm::min(point.y, bbox.min.y);
         bbox.min.z = hm::min(point.z, bbox.min.z);
 
-        bbox.max.x = hm::min(point.x, bbox.min.x);
-        bbox.max.y = hm::min(point.y, bbox.min.y);
-        bbox.max.z = hm::min(point.z, bbox.min.z);
+        bbox.max.x = hm::max(point.x, bbox.max.x);
+        bbox.max.y = hm::max(point.y, bbox.max.y);
+        bbox.max.z = hm::max(point.z, bbox.max.z);
     }
 }
 
-auto inline AABB_transform(AABB& bbox, mat4 M) -> AABB {
+/// @brief: Corner index 0-7, bit 0 picks max x, bit 1 max y and bit 2 max z.
+auto inline AABB_corner(const AABB& bbox, i32 index) -> vec4 {
+    return vec4(                              //
+        index & 1 ? bbox.max.x : bbox.min.x, //
+        index & 2 ? bbox.max.y : bbox.min.y, //
+        index & 4 ? bbox.max.z : bbox.min.z, //
+        1.0f);
+}
 
+/// @brief: The box around bbox transformed by the affine M, for row vectors. Each element of M scales either the
+/// min or the max of its row's axis into the smaller end of its column's axis (Arvo).
+auto inline AABB_transform(const AABB& bbox, const mat4& M) -> AABB {
     // Translation basis
-    vec3 max = M.w_basis.xyz();
-    vec3 min = M.w_basis.xyz();
-
-    if (M.r0c0 > 0.0f) {
-        min.x += M.r0c0 * bbox.min.x;
-        max.x += M.r0c0 * bbox.max.x;
-    }
-    else {
-        min.x += M.r0c0 * bbox.max.x;
-        max.x += M.r0c0 * bbox.min.x;
-    }
-
-    if (M.r0c1 > 0.0f) {
-        min.x += M.r0c1 * bbox.min.x;
-        max.x += M.r0c1 * bbox.max.x;
-    }
-    else {
-        min.x += M.r0c1 * bbox.max.x;
-        max.x += M.r0c1 * bbox.min.x;
-    }
-
-    if (M.r0c2 > 0.0f) {
-        min.x += M.r0c2 * bbox.min.x;
-        max.x += M.r0c2 * bbox.max.x;
-    }
-    else {
-        min.x += M.r0c2 * bbox.max.x;
-        max.x += M.r0c2 * bbox.min.x;
-    }
-
-    if (M.r1c0 > 0.0f) {
-        min.x += M.r1c0 * bbox.min.x;
-        max.x += M.r1c0 * bbox.max.x;
-    }
-    else {
-        min.x += M.r1c0 * bbox.max.x;
-        max.x += M.r1c0 * bbox.min.x;
-    }
-
-    if (M.r1c1 > 0.0f) {
-        min.x += M.r1c1 * bbox.min.x;
-        max.x += M.r1c1 * bbox.max.x;
-    }
-    else {
-        min.x += M.r1c1 * bbox.max.x;
-        max.x += M.r1c1 * bbox.min.x;
-    }
-
-    if (M.r1c2 > 0.0f) {
-        min.x += M.r1c2 * bbox.min.x;
-        max.x += M.r1c2 * bbox.max.x;
-    }
-    else {
-        min.x += M.r1c2 * bbox.max.x;
-        max.x += M.r1c2 * bbox.min.x;
-    }
-
-    if (M.r2c0 > 0.0f) {
-        min.x += M.r2c0 * bbox.min.x;
-        max.x += M.r2c0 * bbox.max.x;
-    }
-    else {
-        min.x += M.r2c0 * bbox.max.x;
-        max.x += M.r2c0 * bbox.min.x;
-    }
-
-    if (M.r2c1 > 0.0f) {
-        min.x += M.r2c1 * bbox.min.x;
-        max.x += M.r2c1 * bbox.max.x;
-    }
-    else {
-        min.x += M.r2c1 * bbox.max.x;
-        max.x += M.r2c1 * bbox.min.x;
-    }
-
-    if (M.r2c2 > 0.0f) {
-        min.x += M.r2c2 * bbox.min.x;
-        max.x += M.r2c2 * bbox.max.x;
-    }
-    else {
-        min.x += M.r2c2 * bbox.max.x;
-        max.x += M.r2c2 * bbox.min.x;
+    vec3 max = vec3(M.tx, M.ty, M.tz);
+    vec3 min = vec3(M.tx, M.ty, M.tz);
+
+    for (i32 row = 0; row < 3; row++) {
+        for (i32 column = 0; column < 3; column++) {
+            f32 e = M.v[row * 4 + column];
+            f32 a = e * bbox.min.v[row];
+            f32 b = e * bbox.max.v[row];
+            min.v[column] += hm::min(a, b);
+            max.v[column] += hm::max(a, b);
+        }
     }
 
     AABB result;
@@ -0,0 +1,785 @@
+// Renders synthetic render groups through the software renderer and reports how fast every kernel is.
+// Runs on the headless backend, so the numbers do not include presenting the frame.
+//
+// Usage: renderer_benchmark [filter] [iterations]
+//   filter: only run the scenarios whose name contains it
+//   iterations: timed frames per measurement, the fastest one is reported
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <time.h>
+#include <x86intrin.h>
+
+#include <renderers/headless_software_renderer.cpp>
+
+#include <core/mesh.hpp>
+#include <linux_work_queue.hpp>
+
+const f32 Pi = 3.14159265f;
+
+const i32 Texture_Sprite = 1;
+const i32 Texture_Glyphs = 2;
+// The same large sprite in both layouts, larger than L2 so the layout shows
+const i32 Texture_Large_Linear = 3;
+const i32 Texture_Large_Blocks = 4;
+const i32 Large_Sprite_Dim = 1024;
+const i32 Glyph_Width = 8;
+const i32 Glyph_Height = 14;
+const i32 Glyph_Atlas_Dim = 128;
+
+struct BenchmarkRandom {
+    u32 state;
+};
+
+auto next_random(BenchmarkRandom* random) -> u32 {
+    // xorshift32, the same sequence on every run and platform
+    u32 x = random->state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    random->state = x;
+    return x;
+}
+
+auto random_unilateral(BenchmarkRandom* random) -> f32 {
+    return (f32)(next_random(random) >> 8) / (f32)(1 << 24);
+}
+
+auto random_between(BenchmarkRandom* random, f32 min, f32 max) -> f32 {
+    return min + (max - min) * random_unilateral(random);
+}
+
+auto random_color(BenchmarkRandom* random, f32 alpha) -> vec4 {
+    return vec4(random_unilateral(random), random_unilateral(random), random_unilateral(random), alpha);
+}
+
+struct BenchmarkTarget {
+    const char* name;
+    i32 width;
+    i32 height;
+    FrameBufferHandle handle;
+};
+
+struct BenchmarkScene {
+    RenderGroup* group;
+    i32 width;
+    i32 height;
+    // Screen relative, so every resolution draws the same picture
+    f32 unit;
+    BenchmarkRandom random;
+    MemoryArena* arena;
+    // Pixels the commands cover, estimated from their geometry. Lines and outlines count their length.
+    f64 pixel_count;
+};
+
+typedef void (*push_scenario_fn)(BenchmarkScene* scene, i32 command_count);
+
+auto push_rotated_sprites(BenchmarkScene* scene, i32 command_count, i32 texture_id, f32 min_size, f32 max_size) -> void {
+    for (i32 i = 0; i < command_count; i++) {
+        f32 size = random_between(&scene->random, min_size, max_size) * scene->unit;
+        RenderEntryBitmap entry = {};
+        entry.quad = { .bl = vec2(-0.5f, -0.5f), .tl = vec2(-0.5f, 0.5f), .tr = vec2(0.5f, 0.5f), .br = vec2(0.5f, -0.5f) };
+        entry.offset = vec2(random_between(&scene->random, size, (f32)scene->width - size),
+            random_between(&scene->random, size, (f32)scene->height - size));
+        entry.scale = vec2(size, size);
+        entry.rotation = random_between(&scene->random, 0.1f, 3.0f);
+        entry.color = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+        entry.texture_id = texture_id;
+        push_bitmap(scene->group, entry, 1);
+        scene->pixel_count += size * size;
+    }
+}
+
+auto push_rotated_bitmaps(BenchmarkScene* scene, i32 command_count) -> void {
+    push_rotated_sprites(scene, command_count, Texture_Sprite, 24.0f, 96.0f);
+}
+
+// Minified about 2-4x, the texture does not fit in L2
+auto push_rotated_large_linear(BenchmarkScene* scene, i32 command_count) -> void {
+    push_rotated_sprites(scene, command_count, Texture_Large_Linear, 256.0f, 512.0f);
+}
+
+auto push_rotated_large_blocks(BenchmarkScene* scene, i32 command_count) -> void {
+    push_rotated_sprites(scene, command_count, Texture_Large_Blocks, 256.0f, 512.0f);
+}
+
+// Many small sprites of one texture, like a swarm of projectiles. Pushed one command each, or as one batch.
+auto push_small_sprites(BenchmarkScene* scene, i32 command_count) -> void {
+    push_rotated_sprites(scene, command_count, Texture_Sprite, 8.0f, 24.0f);
+}
+
+auto push_small_sprites_batch(BenchmarkScene* scene, i32 command_count) -> void {
+    RenderEntryBitmapBatch entry = {};
+    entry.quad = { .bl = vec2(-0.5f, -0.5f), .tl = vec2(-0.5f, 0.5f), .tr = vec2(0.5f, 0.5f), .br = vec2(0.5f, -0.5f) };
+    entry.texture_id = Texture_Sprite;
+    entry.count = command_count;
+    auto* batch = push_bitmap_batch(scene->group, entry, 1);
+    BitmapBatchInstances instances = get_bitmap_batch_instances(batch);
+    for (i32 i = 0; i < command_count; i++) {
+        // Same sequence as push_small_sprites, so both draw the same picture
+        f32 size = random_between(&scene->random, 8.0f, 24.0f) * scene->unit;
+        instances.offset_x[i] = random_between(&scene->random, size, (f32)scene->width - size);
+        instances.offset_y[i] = random_between(&scene->random, size, (f32)scene->height - size);
+        instances.scale_x[i] = size;
+        instances.scale_y[i] = size;
+        instances.rotation[i] = random_between(&scene->random, 0.1f, 3.0f);
+        instances.color[i] = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+        scene->pixel_count += size * size;
+    }
+    end_bitmap_batch(scene->group, batch);
+}
+
+auto push_glyphs(BenchmarkScene* scene, i32 command_count) -> void {
+    const i32 glyphs_per_row = Glyph_Atlas_Dim / Glyph_Width;
+    const i32 glyph_rows = Glyph_Atlas_Dim / Glyph_Height;
+    const i32 line_length = hm::min(80, scene->width / Glyph_Width - 1);
+    f32 line_x = random_between(&scene->random, 0.0f, (f32)(scene->width - line_length * Glyph_Width));
+    f32 line_y = (f32)Glyph_Height;
+    for (i32 i = 0; i < command_count; i++) {
+        if (i % line_length == 0 && i > 0) {
+            line_x = random_between(&scene->random, 0.0f, (f32)(scene->width - line_length * Glyph_Width));
+            line_y += Glyph_Height + 2;
+            if (line_y > scene->height - Glyph_Height) {
+                line_y = (f32)Glyph_Height;
+            }
+        }
+
+        // Same layout as the ui text: a unit quad scaled to the glyph, offset by half a pixel
+        i32 glyph = next_random(&scene->random) % (glyphs_per_row * glyph_rows);
+        ivec2 uv_min = ivec2((glyph % glyphs_per_row) * Glyph_Width, (glyph / glyphs_per_row) * Glyph_Height);
+        RenderEntryBitmap entry = {};
+        entry.uv_min = uv_min;
+        entry.uv_max = ivec2(uv_min.x + Glyph_Width, uv_min.y + Glyph_Height);
+        entry.quad = { .bl = vec2(-0.5f, -0.5f), .tl = vec2(-0.5f, 0.5f), .tr = vec2(0.5f, 0.5f), .br = vec2(0.5f, -0.5f) };
+        entry.offset = vec2(line_x + (i % line_length) * Glyph_Width + Glyph_Width / 2.0f + 0.5f, line_y + 0.5f);
+        entry.scale = vec2((f32)Glyph_Width, (f32)Glyph_Height);
+        entry.rotation = 0.0f;
+        entry.color = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+        entry.texture_id = Texture_Glyphs;
+        push_bitmap(scene->group, entry, 1);
+        scene->pixel_count += Glyph_Width * Glyph_Height;
+    }
+}
+
+// The same text as push_glyphs, a glyph run per line
+auto push_glyph_runs(BenchmarkScene* scene, i32 command_count) -> void {
+    const i32 glyphs_per_row = Glyph_Atlas_Dim / Glyph_Width;
+    const i32 glyph_rows = Glyph_Atlas_Dim / Glyph_Height;
+    const i32 line_length = hm::min(80, scene->width / Glyph_Width - 1);
+    f32 line_x = random_between(&scene->random, 0.0f, (f32)(scene->width - line_length * Glyph_Width));
+    f32 line_y = (f32)Glyph_Height;
+    RenderEntryGlyphRun* run = nullptr;
+    GlyphRunGlyph* glyph = nullptr;
+    for (i32 i = 0; i < command_count; i++) {
+        if (i % line_length == 0) {
+            if (i > 0) {
+                end_glyph_run(scene->group, run);
+                line_x = random_between(&scene->random, 0.0f, (f32)(scene->width - line_length * Glyph_Width));
+                line_y += Glyph_Height + 2;
+                if (line_y > scene->height - Glyph_Height) {
+                    line_y = (f32)Glyph_Height;
+                }
+            }
+            i32 glyph_count = hm::min(line_length, command_count - i);
+            RenderEntryGlyphRun entry = {
+                .color = vec4(1.0f, 1.0f, 1.0f, 1.0f), .texture_id = Texture_Glyphs, .count = glyph_count };
+            run = push_glyph_run(scene->group, entry, 1);
+            glyph = get_glyph_run_glyphs(run);
+        }
+
+        i32 glyph_index = next_random(&scene->random) % (glyphs_per_row * glyph_rows);
+        glyph->u_min = (u16)((glyph_index % glyphs_per_row) * Glyph_Width);
+        glyph->v_min = (u16)((glyph_index / glyphs_per_row) * Glyph_Height);
+        glyph->u_max = glyph->u_min + Glyph_Width;
+        glyph->v_max = glyph->v_min + Glyph_Height;
+        glyph->x = round_f32_to_i32(line_x + (i % line_length) * Glyph_Width + 0.5f);
+        glyph->y = round_f32_to_i32(line_y - Glyph_Height / 2.0f + 0.5f);
+        glyph++;
+        scene->pixel_count += Glyph_Width * Glyph_Height;
+    }
+    if (run) {
+        end_glyph_run(scene->group, run);
+    }
+}
+
+auto push_translucent_quads(BenchmarkScene* scene, i32 command_count) -> void {
+    for (i32 i = 0; i < command_count; i++) {
+        f32 width = random_between(&scene->random, 16.0f, 256.0f) * scene->unit;
+        f32 height = random_between(&scene->random, 16.0f, 256.0f) * scene->unit;
+        f32 x = random_between(&scene->random, 0.0f, (f32)scene->width - width);
+        f32 y = random_between(&scene->random, 0.0f, (f32)scene->height - height);
+        RenderEntryQuad entry = {};
+        entry.quad = { .min_x = x, .max_x = x + width, .min_y = y, .max_y = y + height };
+        entry.color = random_color(&scene->random, 0.5f);
+        push_quad(scene->group, entry, 1);
+        scene->pixel_count += width * height;
+    }
+}
+
+auto push_lines(BenchmarkScene* scene, i32 command_count) -> void {
+    for (i32 i = 0; i < command_count; i++) {
+        vec3 start = vec3(random_between(&scene->random, 0.0f, (f32)scene->width - 1),
+            random_between(&scene->random, 0.0f, (f32)scene->height - 1), 0.0f);
+        vec3 end = vec3(random_between(&scene->random, 0.0f, (f32)scene->width - 1),
+            random_between(&scene->random, 0.0f, (f32)scene->height - 1), 0.0f);
+        push_line(scene->group, { .start = start, .end = end, .color = random_color(&scene->random, 1.0f) }, 1);
+        scene->pixel_count += hm::max(fabsf(end.x - start.x), fabsf(end.y - start.y));
+    }
+}
+
+auto push_circles(BenchmarkScene* scene, i32 command_count) -> void {
+    for (i32 i = 0; i < command_count; i++) {
+        f32 radius = random_between(&scene->random, 8.0f, 96.0f) * scene->unit;
+        RenderEntryCircle entry = {};
+        entry.P = vec2(random_between(&scene->random, radius, (f32)scene->width - radius),
+            random_between(&scene->random, radius, (f32)scene->height - radius));
+        entry.radius = radius;
+        entry.color = random_color(&scene->random, 1.0f);
+        push_circle(scene->group, entry, 1);
+        scene->pixel_count += 2.0f * Pi * radius;
+    }
+}
+
+auto push_filled_circles(BenchmarkScene* scene, i32 command_count) -> void {
+    for (i32 i = 0; i < command_count; i++) {
+        f32 radius = random_between(&scene->random, 8.0f, 96.0f) * scene->unit;
+        RenderEntryFilledCircle entry = {};
+        entry.P = vec2(random_between(&scene->random, radius, (f32)scene->width - radius),
+            random_between(&scene->random, radius, (f32)scene->height - radius));
+        entry.radius = radius;
+        entry.color = random_color(&scene->random, 1.0f);
+        push_filled_circle(scene->group, entry, 1);
+        scene->pixel_count += Pi * radius * radius;
+    }
+}
+
+auto push_filled_triangles(BenchmarkScene* scene, i32 command_count) -> void {
+    for (i32 i = 0; i < command_count; i++) {
+        f32 size = random_between(&scene->random, 16.0f, 128.0f) * scene->unit;
+        vec2 center = vec2(random_between(&scene->random, size, (f32)scene->width - size),
+            random_between(&scene->random, size, (f32)scene->height - size));
+        RenderEntryFilledTriangle entry = {};
+        for (i32 j = 0; j < 3; j++) {
+            f32 angle = random_between(&scene->random, 0.0f, 2.0f * Pi);
+            entry.vertices[j] = vec3(center.x + cosf(angle) * size, center.y + sinf(angle) * size, 0.5f);
+        }
+        entry.color = random_color(&scene->random, 1.0f);
+        push_filled_triangle(scene->group, entry, 1);
+        vec3 e1 = entry.P1 - entry.P0;
+        vec3 e2 = entry.P2 - entry.P0;
+        scene->pixel_count += 0.5f * fabsf(e1.x * e2.y - e1.y * e2.x);
+    }
+}
+
+auto push_tri_mesh_instances(BenchmarkScene* scene, i32 command_count, bool is_lit) -> void {
+    const vec3 up(0.0f, 1.0f, 0.0f);
+    RenderEntryTriMesh entry = {};
+    generate_cube_mesh(&entry.model, scene->arena);
+    entry.world_to_view = lookAt(vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), up);
+    entry.view_to_clip = perspective(60.0f, (f32)scene->width / (f32)scene->height, 0.1f, 1000.0f);
+    entry.camera_position = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    if (is_lit) {
+        entry.is_lit = true;
+        entry.lights.ambient.color = vec4(0.15f, 0.15f, 0.2f, 1.0f);
+        entry.lights.directional = Array<DirectionalLight>::create(1, scene->arena);
+        entry.lights.directional[0].L = vec4(0.48f, 0.64f, -0.6f, 0.0f);
+        entry.lights.directional[0].color = vec4(0.8f, 0.75f, 0.7f, 1.0f);
+        entry.lights.point = Array<PointLight>::create(1, scene->arena);
+        entry.lights.point[0].P = vec4(-2.0f, 3.0f, 6.0f, 1.0f);
+        entry.lights.point[0].color = vec4(0.6f, 0.3f, 0.1f, 1.0f);
+    }
+    entry.instances = Array<MeshInstance>::create(command_count, scene->arena);
+    auto* mesh = push_tri_mesh(scene->group, entry, 1);
+
+    auto colors = Array<vec4>::create(12, scene->arena);
+    for (u32 i = 0; i < colors.count(); i++) {
+        colors[i] = random_color(&scene->random, 1.0f);
+    }
+
+    for (i32 i = 0; i < command_count; i++) {
+        MeshInstance* instance = &mesh->instances[i];
+        f32 z = random_between(&scene->random, 6.0f, 14.0f);
+        instance->transform.position = vec3(random_between(&scene->random, -0.4f, 0.4f) * z,
+            random_between(&scene->random, -0.25f, 0.25f) * z, z);
+        instance->transform.rotation = angle_axis(random_between(&scene->random, 0.0f, 2.0f * Pi),
+            normalized(vec3(random_unilateral(&scene->random), 1.0f, random_unilateral(&scene->random))));
+        instance->transform.scale = vec3(1.0f, 1.0f, 1.0f);
+        instance->colors = colors;
+    }
+
+    // Covered pixels, the same way the renderer transforms them
+    for (i32 i = 0; i < command_count; i++) {
+        const MeshLights* lights = is_lit ? &mesh->lights : nullptr;
+        MemoryArena* temp = scene->arena->allocate_arena(
+            project_mesh_instance_arena_size(mesh->model.vertex_count, mesh->model.triangles.count(), lights));
+        ProjectedMeshInstance projected = project_mesh_instance(mesh->model, mesh->instances[i], //
+            mesh->world_to_view, mesh->view_to_clip, mesh->camera_position, lights,              //
+            scene->width, scene->height, *temp);
+        temp = scene->arena->allocate_arena(clip_mesh_instance_arena_size(projected));
+        ScreenMesh screen = clip_mesh_instance(projected, mesh->instances[i], scene->width, scene->height, *temp);
+        for (u32 j = 0; j < screen.triangles.count(); j++) {
+            vec3 e1 = screen.vertices[screen.triangles[j].y] - screen.vertices[screen.triangles[j].x];
+            vec3 e2 = screen.vertices[screen.triangles[j].z] - screen.vertices[screen.triangles[j].x];
+            scene->pixel_count += 0.5f * fabsf(e1.x * e2.y - e1.y * e2.x);
+        }
+    }
+}
+
+auto push_tri_meshes(BenchmarkScene* scene, i32 command_count) -> void {
+    push_tri_mesh_instances(scene, command_count, false);
+}
+
+auto push_lit_tri_meshes(BenchmarkScene* scene, i32 command_count) -> void {
+    push_tri_mesh_instances(scene, command_count, true);
+}
+
+// Kernels, selected through the same globals the renderer dispatches on
+auto select_draw_bitmap_scalar() -> void {
+    draw_bitmap = draw_bitmap_scalar;
+}
+auto select_draw_bitmap_avx2() -> void {
+    draw_bitmap = draw_bitmap_avx2;
+}
+auto select_blit_glyph_scalar() -> void {
+    blit_glyph = blit_glyph_scalar;
+}
+auto select_blit_glyph_avx2() -> void {
+    blit_glyph = blit_glyph_avx2;
+}
+auto select_blend_span_scalar() -> void {
+    blend_span = blend_span_scalar;
+}
+auto select_blend_span_avx2() -> void {
+    blend_span = blend_span_avx2;
+}
+auto select_blend_span_avx512() -> void {
+    blend_span = blend_span_avx512;
+}
+auto select_triangle_gambetta() -> void {
+    render_triangle_filled = render_triangle_filled_gambetta;
+}
+auto select_triangle_half_space_avx2() -> void {
+    render_triangle_filled = render_triangle_filled_half_space_avx2;
+    render_triangle_shaded = render_triangle_shaded_half_space_avx2;
+}
+auto select_triangle_half_space_avx512() -> void {
+    render_triangle_filled = render_triangle_filled_half_space_avx512;
+    render_triangle_shaded = render_triangle_shaded_half_space_avx512;
+}
+// Kernels without alternatives
+auto select_default() -> void {
+}
+
+struct BenchmarkKernel {
+    const char* name;
+    void (*select)();
+    bool needs_avx512;
+};
+
+struct BenchmarkScenario {
+    const char* name;
+    push_scenario_fn push;
+    // Instances for tri-meshes and bitmap batches, glyphs for glyph runs
+    i32 command_count;
+    BenchmarkKernel kernels[3];
+    i32 kernel_count;
+};
+
+// clang-format off
+static BenchmarkScenario scenarios[] = {
+    { "rotated_bitmaps", push_rotated_bitmaps, 256,
+        { { "draw_bitmap_scalar", select_draw_bitmap_scalar }, { "draw_bitmap_avx2", select_draw_bitmap_avx2 } }, 2 },
+    { "rotated_large_linear", push_rotated_large_linear, 32,
+        { { "draw_bitmap_scalar", select_draw_bitmap_scalar }, { "draw_bitmap_avx2", select_draw_bitmap_avx2 } }, 2 },
+    { "rotated_large_blocks4x4", push_rotated_large_blocks, 32,
+        { { "draw_bitmap_scalar", select_draw_bitmap_scalar }, { "draw_bitmap_avx2", select_draw_bitmap_avx2 } }, 2 },
+    { "glyphs", push_glyphs, 4000,
+        { { "draw_bitmap_scalar", select_draw_bitmap_scalar }, { "draw_bitmap_avx2", select_draw_bitmap_avx2 } }, 2 },
+    { "glyph_runs", push_glyph_runs, 4000,
+        { { "blit_glyph_scalar", select_blit_glyph_scalar }, { "blit_glyph_avx2", select_blit_glyph_avx2 } }, 2 },
+    { "small_sprites", push_small_sprites, 4000,
+        { { "draw_bitmap_scalar", select_draw_bitmap_scalar }, { "draw_bitmap_avx2", select_draw_bitmap_avx2 } }, 2 },
+    { "small_sprites_batch", push_small_sprites_batch, 4000,
+        { { "draw_bitmap_scalar", select_draw_bitmap_scalar }, { "draw_bitmap_avx2", select_draw_bitmap_avx2 } }, 2 },
+    { "translucent_quads", push_translucent_quads, 512,
+        { { "blend_span_scalar", select_blend_span_scalar }, { "blend_span_avx2", select_blend_span_avx2 },
+          { "blend_span_avx512", select_blend_span_avx512, true } }, 3 },
+    { "lines", push_lines, 1000, { { "render_line_gambetta", select_default } }, 1 },
+    { "circles", push_circles, 512, { { "render_circle_bresenham", select_default } }, 1 },
+    { "filled_circles", push_filled_circles, 512, { { "render_filled_circle_bresenham", select_default } }, 1 },
+    { "filled_triangles", push_filled_triangles, 300,
+        { { "triangle_gambetta", select_triangle_gambetta }, { "triangle_half_space_avx2", select_triangle_half_space_avx2 },
+          { "triangle_half_space_avx512", select_triangle_half_space_avx512, true } }, 3 },
+    { "tri_mesh_instances", push_tri_meshes, 24,
+        { { "triangle_gambetta", select_triangle_gambetta }, { "triangle_half_space_avx2", select_triangle_half_space_avx2 },
+          { "triangle_half_space_avx512", select_triangle_half_space_avx512, true } }, 3 },
+    { "lit_tri_mesh_instances", push_lit_tri_meshes, 24,
+        { { "triangle_half_space_avx2", select_triangle_half_space_avx2 },
+          { "triangle_half_space_avx512", select_triangle_half_space_avx512, true } }, 2 },
+};
+// clang-format on
+
+auto read_wall_clock_ns() -> u64 {
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (u64)time.tv_sec * 1000000000ull + (u64)time.tv_nsec;
+}
+
+auto create_sprite_texture(MemoryArena* arena) -> void {
+    const i32 dim = 64;
+    u32* pixels = allocate<u32>(*arena, dim * dim);
+    for (i32 y = 0; y < dim; y++) {
+        for (i32 x = 0; x < dim; x++) {
+            // RGBA, opaque with a translucent border, like the ship sprites
+            bool is_border = x < 4 || y < 4 || x >= dim - 4 || y >= dim - 4;
+            u32 alpha = is_border ? 0x80 : 0xFF;
+            pixels[y * dim + x] = alpha << 24 | (u32)(x * 4) << 16 | (u32)(y * 4) << 8 | 0x40;
+        }
+    }
+    headless_renderer_add_texture(Texture_Sprite, pixels, dim, dim, sizeof(u32), PixelFormat_RGBA8);
+}
+
+auto create_large_sprite_textures(MemoryArena* arena) -> void {
+    u32* pixels = allocate<u32>(*arena, Large_Sprite_Dim * Large_Sprite_Dim);
+    BenchmarkRandom random = { 0xBADF00D };
+    for (i32 i = 0; i < Large_Sprite_Dim * Large_Sprite_Dim; i++) {
+        pixels[i] = 0xFF000000 | (next_random(&random) & 0x00FFFFFF);
+    }
+    software_renderer_add_texture_with_layout(Texture_Large_Linear, pixels, Large_Sprite_Dim, Large_Sprite_Dim, //
+        sizeof(u32), PixelFormat_RGBA8, TextureLayout_Linear);
+    software_renderer_add_texture_with_layout(Texture_Large_Blocks, pixels, Large_Sprite_Dim, Large_Sprite_Dim, //
+        sizeof(u32), PixelFormat_RGBA8, TextureLayout_Blocks4x4);
+}
+
+auto create_glyph_texture(MemoryArena* arena) -> void {
+    u32* pixels = allocate<u32>(*arena, Glyph_Atlas_Dim * Glyph_Atlas_Dim);
+    BenchmarkRandom random = { 0xC0FFEE };
+    for (i32 i = 0; i < Glyph_Atlas_Dim * Glyph_Atlas_Dim; i++) {
+        // White with coverage in alpha, like the font atlas
+        u32 alpha = (next_random(&random) & 1) ? 0xFF : 0x00;
+        pixels[i] = alpha << 24 | 0x00FFFFFF;
+    }
+    headless_renderer_add_texture(
+        Texture_Glyphs, pixels, Glyph_Atlas_Dim, Glyph_Atlas_Dim, sizeof(u32), PixelFormat_RGBA8);
+}
+
+// Clear, small sprites over it or nothing, then composite into a platform buffer of the same size. Frames run
+// back to back, so the tiles render right after the previous frame's composite, with and without streaming stores.
+auto run_composition_benchmark(ThreadContext* thread_context, BenchmarkTarget* targets, i32 target_count, //
+    i32 iterations, MemoryArena* arena) -> void {
+    printf("\n%-24s %-30s %-10s %10s %10s\n", "composition", "stores", "resolution", "render ms", "apply ms");
+    for (i32 run = 0; run < 2 * target_count; run++) {
+        BenchmarkTarget* target = &targets[run % target_count];
+        i32 sprite_count = run < target_count ? 0 : 2000;
+        arena->clear();
+        BenchmarkScene scene = {};
+        scene.group = allocate<RenderGroup>(*arena);
+        scene.group->max_push_buffer_size = MegaBytes(2);
+        scene.group->push_buffer = allocate<u8>(*arena, scene.group->max_push_buffer_size);
+        init_render_group_commands(scene.group, arena, sprite_count + 1);
+        scene.width = target->width;
+        scene.height = target->height;
+        scene.unit = (f32)target->height / 720.0f;
+        scene.random = { 0x1234567u };
+        scene.arena = arena;
+        // Like the 3D layer. A plain clear leaves the tile clean, so it would not be composited.
+        push_clear_check_pattern(
+            scene.group, { .color1 = vec4(0.1f, 0.1f, 0.1f, 1.0f), .color2 = vec4(0.2f, 0.2f, 0.2f, 1.0f) }, 0);
+        push_small_sprites(&scene, sprite_count);
+
+        resize_frame_buffer(&state.platform_buffer, target->width, target->height);
+        Framebuffer* buffer = &state.framebuffers[target->handle.v];
+        for (i32 mode = 0; mode < 2; mode++) {
+            bool is_streaming = mode == 1;
+            state.streaming_store_min_size = is_streaming ? 0 : UINT64_MAX;
+            u64 best_render_ns = UINT64_MAX;
+            u64 best_apply_ns = UINT64_MAX;
+            for (i32 iteration = 0; iteration <= iterations; iteration++) {
+                headless_renderer_begin_frame(nullptr);
+                for (auto& tile : buffer->tiles) {
+                    tile.content_hash = 0;
+                }
+
+                u64 start_ns = read_wall_clock_ns();
+                headless_renderer_render(thread_context, true, scene.group, target->handle);
+                u64 render_ns = read_wall_clock_ns() - start_ns;
+
+                start_ns = read_wall_clock_ns();
+                headless_renderer_apply_framebuffer(thread_context, target->handle, { 1, 1 });
+                u64 apply_ns = read_wall_clock_ns() - start_ns;
+                headless_renderer_end_frame(nullptr);
+
+                if (iteration > 0 && render_ns < best_render_ns) {
+                    best_render_ns = render_ns;
+                }
+                if (iteration > 0 && apply_ns < best_apply_ns) {
+                    best_apply_ns = apply_ns;
+                }
+            }
+            printf("%-24s %-30s %-10s %10.3f %10.3f\n", sprite_count ? "clear_sprites_apply" : "clear_apply",
+                is_streaming ? "streaming" : "regular",
+                target->name, (f64)best_render_ns / 1e6, (f64)best_apply_ns / 1e6);
+        }
+    }
+    state.streaming_store_min_size = DefaultStreamingStoreMinSize;
+    resize_frame_buffer(&state.platform_buffer, CLIENT_WIDTH, CLIENT_HEIGHT);
+}
+
+// Model to screen space for a batch of vertices in front of the camera, without clipping or rasterizing. The batch
+// stays in L2, so it measures the transform and not memory.
+auto run_vertex_transform_benchmark(i32 iterations, f64 cycles_per_ns, MemoryArena* arena) -> void {
+    struct VertexTransformKernel {
+        const char* name;
+        transform_vertices_fn transform;
+        bool needs_avx512;
+    };
+    VertexTransformKernel kernels[] = {
+        { "transform_vertices_scalar", transform_vertices_scalar },
+        { "transform_vertices_avx2", transform_vertices_avx2 },
+        { "transform_vertices_avx512", transform_vertices_avx512, true },
+    };
+    const u32 vertex_count = 16384;
+    const i32 repeat_count = 64;
+
+    arena->clear();
+    BenchmarkRandom random = { 0x7654321u };
+    auto vertices = Array<vec4>::create(vertex_count, arena);
+    for (u32 i = 0; i < vertex_count; i++) {
+        vertices[i] = vec4(random_unilateral(&random), random_unilateral(&random), random_unilateral(&random), 1.0f);
+    }
+    VertexPositions positions = create_vertex_positions(vertices, *arena);
+    ProjectedVertices projected = create_projected_vertices(vertex_count, *arena);
+    Transform transform = {};
+    transform.position = vec3(0.5f, -0.25f, 8.0f);
+    transform.rotation = angle_axis(0.7f, normalized(vec3(0.3f, 1.0f, 0.2f)));
+    transform.scale = vec3(2.0f, 2.0f, 2.0f);
+    const vec3 up(0.0f, 1.0f, 0.0f);
+    mat4 model_to_clip = transform.to_mat4() * lookAt(vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), up) *
+                         perspective(60.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+
+    printf("\n%-24s %-30s %10s %10s %10s\n", "vertex_transform", "kernel", "vertices", "Mverts/s", "cycles/vert");
+    for (auto& kernel : kernels) {
+        if (kernel.needs_avx512 && !cpu_supports_avx512f()) {
+            continue;
+        }
+        u64 best_ns = UINT64_MAX;
+        for (i32 iteration = 0; iteration <= iterations; iteration++) {
+            u64 start_ns = read_wall_clock_ns();
+            for (i32 i = 0; i < repeat_count; i++) {
+                kernel.transform(positions, vertex_count, model_to_clip, 1920, 1080, &projected);
+            }
+            u64 ns = read_wall_clock_ns() - start_ns;
+            if (iteration > 0 && ns < best_ns) {
+                best_ns = ns;
+            }
+        }
+        f64 vertices_transformed = (f64)vertex_count * repeat_count;
+        printf("%-24s %-30s %10u %10.1f %10.2f\n", "vertex_transform", kernel.name, vertex_count,
+            vertices_transformed / ((f64)best_ns / 1e3), (f64)best_ns * cycles_per_ns / vertices_transformed);
+    }
+}
+
+// Ambient, one directional and two point lights on a batch of vertices with their normals, the lighting part of a
+// lit mesh instance on its own.
+auto run_vertex_lighting_benchmark(i32 iterations, f64 cycles_per_ns, MemoryArena* arena) -> void {
+    struct VertexLightingKernel {
+        const char* name;
+        light_vertices_fn light;
+        bool needs_avx512;
+    };
+    VertexLightingKernel kernels[] = {
+        { "light_vertices_scalar", light_vertices_scalar },
+        { "light_vertices_avx2", light_vertices_avx2 },
+        { "light_vertices_avx512", light_vertices_avx512, true },
+    };
+    const u32 vertex_count = 16384;
+    const i32 repeat_count = 64;
+
+    arena->clear();
+    BenchmarkRandom random = { 0x1234567u };
+    auto vertices = Array<vec4>::create(vertex_count, arena);
+    for (u32 i = 0; i < vertex_count; i++) {
+        vertices[i] = vec4(random_unilateral(&random), random_unilateral(&random), random_unilateral(&random), 1.0f);
+    }
+    VertexPositions positions = create_vertex_positions(vertices, *arena);
+    // Points on a sphere face away from its center
+    VertexNormals normals = {};
+    normals.x = Array<f32>::create(vertex_count, arena);
+    normals.y = Array<f32>::create(vertex_count, arena);
+    normals.z = Array<f32>::create(vertex_count, arena);
+    for (u32 i = 0; i < vertex_count; i++) {
+        vec3 normal = normalized(vec3(vertices[i].x, vertices[i].y, vertices[i].z));
+        normals.x[i] = normal.x;
+        normals.y[i] = normal.y;
+        normals.z[i] = normal.z;
+    }
+    MeshLights lights = {};
+    lights.ambient.color = vec4(0.1f, 0.1f, 0.1f, 1.0f);
+    lights.directional = Array<DirectionalLight>::create(1, arena);
+    lights.directional[0].L = vec4(0.0f, 0.6f, -0.8f, 0.0f);
+    lights.directional[0].color = vec4(0.8f, 0.8f, 0.7f, 1.0f);
+    lights.point = Array<PointLight>::create(2, arena);
+    lights.point[0].P = vec4(2.0f, 1.0f, -1.0f, 1.0f);
+    lights.point[0].color = vec4(0.5f, 0.2f, 0.1f, 1.0f);
+    lights.point[1].P = vec4(-2.0f, -1.0f, 0.5f, 1.0f);
+    lights.point[1].color = vec4(0.1f, 0.2f, 0.5f, 1.0f);
+    VertexLight light = create_vertex_light(vertex_count, *arena);
+
+    printf("\n%-24s %-30s %10s %10s %10s\n", "vertex_lighting", "kernel", "vertices", "Mverts/s", "cycles/vert");
+    for (auto& kernel : kernels) {
+        if (kernel.needs_avx512 && !cpu_supports_avx512f()) {
+            continue;
+        }
+        u64 best_ns = UINT64_MAX;
+        for (i32 iteration = 0; iteration <= iterations; iteration++) {
+            u64 start_ns = read_wall_clock_ns();
+            for (i32 i = 0; i < repeat_count; i++) {
+                kernel.light(positions, normals, vertex_count, lights, &light);
+            }
+            u64 ns = read_wall_clock_ns() - start_ns;
+            if (iteration > 0 && ns < best_ns) {
+                best_ns = ns;
+            }
+        }
+        f64 vertices_lit = (f64)vertex_count * repeat_count;
+        printf("%-24s %-30s %10u %10.1f %10.2f\n", "vertex_lighting", kernel.name, vertex_count,
+            vertices_lit / ((f64)best_ns / 1e3), (f64)best_ns * cycles_per_ns / vertices_lit);
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : "";
+    i32 iterations = argc > 2 ? atoi(argv[2]) : 20;
+    iterations = iterations > 0 ? iterations : 1;
+
+    PlatformApi platform = {};
+    PlatformWorkQueue queue = {};
+    platform.work_queue = &queue;
+    platform.add_work_queue_entry = linux_add_work_queue_entry;
+    platform.complete_all_work = linux_complete_all_work;
+    platform.print_stack_trace = linux_print_stack_trace;
+    platform.debug_table = (DebugTable*)allocate_pages(sizeof(DebugTable));
+
+    StackArray<ThreadContext, TOTAL_THREAD_COUNT> thread_contexts = {};
+    StackArray<MemoryBlock, TOTAL_THREAD_COUNT> thread_memory = {};
+    for (u32 i = 0; i < TOTAL_THREAD_COUNT; i++) {
+        thread_memory[i].size = MegaBytes(16);
+        thread_memory[i].data = allocate_pages(thread_memory[i].size);
+    }
+    linux_make_queue(&platform, Array<ThreadContext>(thread_contexts.data(), TOTAL_THREAD_COUNT),
+        Array<MemoryBlock>(thread_memory.data(), TOTAL_THREAD_COUNT));
+    ThreadContext* thread_context = &thread_contexts[MAIN_THREAD_IDX];
+
+    MemoryBlock renderer_memory = { allocate_pages(MegaBytes(64)), (u32)MegaBytes(64) };
+    headless_renderer_init(nullptr, &platform, &renderer_memory);
+
+    MemoryArena arena = {};
+    arena.init(allocate_pages(MegaBytes(64)), MegaBytes(64));
+    create_sprite_texture(&arena);
+    create_glyph_texture(&arena);
+    create_large_sprite_textures(&arena);
+
+    BenchmarkTarget targets[] = {
+        { "320x180", 320, 180 },
+        { "1280x720", 1280, 720 },
+        { "1920x1080", 1920, 1080 },
+    };
+    for (auto& target : targets) {
+        target.handle = headless_renderer_create_framebuffer(target.width, target.height);
+    }
+
+    // Only clears, so the timed group starts from the same pixels and depth every iteration
+    RenderGroup clear_group = {};
+    clear_group.max_push_buffer_size = KiloBytes(1);
+    clear_group.push_buffer = allocate<u8>(arena, clear_group.max_push_buffer_size);
+    init_render_group_commands(&clear_group, &arena, 1);
+    push_clear_check_pattern(
+        &clear_group, { .color1 = vec4(0.1f, 0.1f, 0.1f, 1.0f), .color2 = vec4(0.2f, 0.2f, 0.2f, 1.0f) }, 0);
+
+    // Rough, only used to turn cycles into time for cycles per pixel
+    u64 calibration_ns = read_wall_clock_ns();
+    u64 calibration_cycles = __rdtsc();
+    while (read_wall_clock_ns() - calibration_ns < 100000000ull) {
+    }
+    f64 cycles_per_ns = (f64)(__rdtsc() - calibration_cycles) / (f64)(read_wall_clock_ns() - calibration_ns);
+
+    printf("%u worker threads, %d iterations, %.2f GHz TSC, fastest iteration reported\n", WORKER_THREAD_COUNT, iterations,
+        cycles_per_ns);
+    printf("%-24s %-30s %-10s %-6s %8s %10s %10s %10s %10s %10s\n", "scenario", "kernel", "resolution", "mode", "commands",
+        "Mpixels", "ms", "Mpixels/s", "ns/cmd", "cycles/px");
+
+    MemoryArena scenario_arena = *arena.allocate_arena(MegaBytes(16));
+    for (auto& scenario : scenarios) {
+        if (!strstr(scenario.name, filter)) {
+            continue;
+        }
+        for (auto& target : targets) {
+            scenario_arena.clear();
+            BenchmarkScene scene = {};
+            scene.group = allocate<RenderGroup>(scenario_arena);
+            scene.group->max_push_buffer_size = MegaBytes(2);
+            scene.group->push_buffer = allocate<u8>(scenario_arena, scene.group->max_push_buffer_size);
+            init_render_group_commands(scene.group, &scenario_arena, scenario.command_count);
+            scene.width = target.width;
+            scene.height = target.height;
+            scene.unit = (f32)target.height / 720.0f;
+            scene.random = { 0x1234567u };
+            scene.arena = &scenario_arena;
+            scenario.push(&scene, scenario.command_count);
+
+            Framebuffer* buffer = &state.framebuffers[target.handle.v];
+            for (i32 kernel_idx = 0; kernel_idx < scenario.kernel_count; kernel_idx++) {
+                BenchmarkKernel* kernel = &scenario.kernels[kernel_idx];
+                if (kernel->needs_avx512 && !cpu_supports_avx512f()) {
+                    continue;
+                }
+                kernel->select();
+
+                for (i32 mode = 0; mode < 2; mode++) {
+                    bool is_multithreaded = mode == 1;
+                    u64 best_ns = UINT64_MAX;
+                    u64 best_cycles = UINT64_MAX;
+                    // The first iteration warms the caches and is not counted
+                    for (i32 iteration = 0; iteration <= iterations; iteration++) {
+                        headless_renderer_begin_frame(nullptr);
+                        headless_renderer_render(thread_context, is_multithreaded, &clear_group, target.handle);
+                        for (auto& tile : buffer->tiles) {
+                            // Otherwise unchanged tiles are skipped, and only the first iteration renders
+                            tile.content_hash = 0;
+                        }
+
+                        u64 start_ns = read_wall_clock_ns();
+                        u64 start_cycles = __rdtsc();
+                        headless_renderer_render(thread_context, is_multithreaded, scene.group, target.handle);
+                        u64 cycles = __rdtsc() - start_cycles;
+                        u64 ns = read_wall_clock_ns() - start_ns;
+
+                        if (iteration > 0 && ns < best_ns) {
+                            best_ns = ns;
+                            best_cycles = cycles;
+                        }
+                    }
+
+                    f64 mpixels = scene.pixel_count / 1e6;
+                    printf("%-24s %-30s %-10s %-6s %8d %10.3f %10.3f %10.1f %10.1f %10.2f\n", //
+                        scenario.name, kernel->name, target.name, is_multithreaded ? "tiled" : "single",
+                        scenario.command_count, mpixels, (f64)best_ns / 1e6, mpixels / ((f64)best_ns / 1e9),
+                        (f64)best_ns / scenario.command_count, (f64)best_cycles / scene.pixel_count);
+                }
+            }
+            // Back to what the renderer picked at init
+            software_renderer_select_kernels();
+        }
+    }
+
+    if (strstr("composition", filter)) {
+        run_composition_benchmark(thread_context, targets, ArrayCount(targets), iterations, &scenario_arena);
+    }
+    if (strstr("vertex_transform", filter)) {
+        run_vertex_transform_benchmark(iterations, cycles_per_ns, &scenario_arena);
+    }
+    if (strstr("vertex_lighting", filter)) {
+        run_vertex_lighting_benchmark(iterations, cycles_per_ns, &scenario_arena);
+    }
+    return 0;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <math/math.hpp>
+#include <math/simd.hpp>
 #include <platform/platform.hpp>
 #include <platform/types.hpp>
 
@@ -418,6 +419,512 @@ auto inline render_triangle_filled_gambetta(
     // render_line_gambetta_internal(P2, P0, packed_color, clip_rect, buffer, arena);
 }
 
+// Half-space rasterizer. Walks the triangle's bounding box in fixed size blocks, testing the
+// three edge functions per pixel center. Does no arena allocations, unlike the gambetta path.
+
+// E(x, y) = a * x + b * y + c, positive on the inside of the triangle.
+struct EdgeFunction {
+    f32 a;
+    f32 b;
+    f32 c;
+    bool is_top_left;
+};
+
+struct HalfSpaceTriangle {
+    EdgeFunction edges[3];
+    // Depth plane, z(x, y) = z_a * x + z_b * y + z_c
+    f32 z_a;
+    f32 z_b;
+    f32 z_c;
+    f32 z_min; // Farthest vertex
+    f32 z_max; // Closest vertex
+    Rectangle2i bounds; // Pixels to visit, already clipped
+};
+
+auto inline create_edge_function(vec3 from, vec3 to) -> EdgeFunction {
+    EdgeFunction result;
+    result.a = from.y - to.y;
+    result.b = to.x - from.x;
+    result.c = -(result.a * from.x + result.b * from.y);
+    // y grows downwards, so a top edge goes right and a left edge goes up.
+    f32 dx = to.x - from.x;
+    f32 dy = to.y - from.y;
+    result.is_top_left = dy < 0.0f || (dy == 0.0f && dx > 0.0f);
+    return result;
+}
+
+/// @return: false if the triangle is degenerate or does not touch the clip rect.
+auto inline setup_half_space_triangle(
+    vec3 P0, vec3 P1, vec3 P2, Rectangle2i clip_rect, Framebuffer& buffer, HalfSpaceTriangle& triangle) -> bool {
+    f32 area = (P1.x - P0.x) * (P2.y - P0.y) - (P1.y - P0.y) * (P2.x - P0.x);
+    if (area == 0.0f) {
+        return false;
+    }
+    if (area < 0.0f) {
+        vec3_swap(P1, P2);
+        area = -area;
+    }
+
+    triangle.edges[0] = create_edge_function(P1, P2); // Weight of P0
+    triangle.edges[1] = create_edge_function(P2, P0); // Weight of P1
+    triangle.edges[2] = create_edge_function(P0, P1); // Weight of P2
+
+    f32 inv_area = 1.0f / area;
+    EdgeFunction* e = triangle.edges;
+    triangle.z_a = (e[0].a * P0.z + e[1].a * P1.z + e[2].a * P2.z) * inv_area;
+    triangle.z_b = (e[0].b * P0.z + e[1].b * P1.z + e[2].b * P2.z) * inv_area;
+    triangle.z_c = (e[0].c * P0.z + e[1].c * P1.z + e[2].c * P2.z) * inv_area;
+    triangle.z_min = hm::min(P0.z, P1.z, P2.z);
+    triangle.z_max = hm::max(P0.z, P1.z, P2.z);
+
+    Rectangle2i bounds;
+    bounds.min_x = hm::max((i32)floorf(hm::min(P0.x, P1.x, P2.x)), clip_rect.min_x, 0);
+    bounds.min_y = hm::max((i32)floorf(hm::min(P0.y, P1.y, P2.y)), clip_rect.min_y, 0);
+    bounds.max_x = hm::min((i32)ceilf(hm::max(P0.x, P1.x, P2.x)) + 1, clip_rect.max_x, buffer.width);
+    bounds.max_y = hm::min((i32)ceilf(hm::max(P0.y, P1.y, P2.y)) + 1, clip_rect.max_y, buffer.height);
+    triangle.bounds = bounds;
+    return bounds.min_x < bounds.max_x && bounds.min_y < bounds.max_y;
+}
+
+enum BlockCoverage {
+    BlockCoverage_None,    //
+    BlockCoverage_Partial, //
+    BlockCoverage_Full     //
+};
+
+/// @brief: Classifies a block of pixel centers [x + 0.5, x + dim_x - 0.5] x [y + 0.5, y + dim_y - 0.5].
+auto inline classify_block(HalfSpaceTriangle& triangle, i32 x, i32 y, i32 dim_x, i32 dim_y) -> BlockCoverage {
+    f32 x_min = (f32)x + 0.5f;
+    f32 x_max = (f32)(x + dim_x) - 0.5f;
+    f32 y_min = (f32)y + 0.5f;
+    f32 y_max = (f32)(y + dim_y) - 0.5f;
+
+    bool is_full = true;
+    for (i32 i = 0; i < 3; i++) {
+        EdgeFunction& e = triangle.edges[i];
+        f32 e_max = e.a * (e.a > 0.0f ? x_max : x_min) + e.b * (e.b > 0.0f ? y_max : y_min) + e.c;
+        if (e_max < 0.0f) {
+            return BlockCoverage_None;
+        }
+        f32 e_min = e.a * (e.a > 0.0f ? x_min : x_max) + e.b * (e.b > 0.0f ? y_min : y_max) + e.c;
+        is_full = is_full && e_min > 0.0f;
+    }
+
+    Rectangle2i& bounds = triangle.bounds;
+    is_full = is_full && x >= bounds.min_x && (x + dim_x) <= bounds.max_x && y >= bounds.min_y && (y + dim_y) <= bounds.max_y;
+    return is_full ? BlockCoverage_Full : BlockCoverage_Partial;
+}
+
+struct BlockDepthRange {
+    f32 z_near;
+    f32 z_far;
+};
+
+/// @brief: Depth of the triangle's plane over a block of pixel centers, clamped to the triangle's own depth range.
+auto inline get_block_depth_range(HalfSpaceTriangle& triangle, i32 x, i32 y, i32 dim_x, i32 dim_y) -> BlockDepthRange {
+    f32 x_min = (f32)x + 0.5f;
+    f32 x_max = (f32)(x + dim_x) - 0.5f;
+    f32 y_min = (f32)y + 0.5f;
+    f32 y_max = (f32)(y + dim_y) - 0.5f;
+    f32 plane_max = triangle.z_a * (triangle.z_a > 0.0f ? x_max : x_min) + triangle.z_b * (triangle.z_b > 0.0f ? y_max : y_min) + triangle.z_c;
+    f32 plane_min = triangle.z_a * (triangle.z_a > 0.0f ? x_min : x_max) + triangle.z_b * (triangle.z_b > 0.0f ? y_min : y_max) + triangle.z_c;
+
+    BlockDepthRange result;
+    result.z_near = hm::min(plane_max, triangle.z_max);
+    result.z_far = hm::max(plane_min, triangle.z_min);
+    return result;
+}
+
+/// @brief: True if the triangle is behind everything already written to the z block at (x, y).
+auto inline is_z_block_occluded(HalfSpaceTriangle& triangle, Framebuffer& buffer, i32 x, i32 y) -> bool {
+    BlockDepthRange range = get_block_depth_range(triangle, x, y, ZBlockDim, ZBlockDim);
+    // A pixel is only written if z > current_z, and current_z >= z block.
+    return range.z_near <= *get_z_block(buffer, x, y);
+}
+
+/// @brief: Raises the z block at (x, y) after a triangle has been written to it.
+/// Only blocks that lie entirely inside clip_rect are touched, so tiles rendered in parallel never
+/// write the same entry. Blocks straddling tiles keep their cleared value and never reject anything.
+auto inline update_z_block(HalfSpaceTriangle& triangle, Framebuffer& buffer, Rectangle2i clip_rect, //
+    i32 x, i32 y, bool is_fully_covered) -> void {
+    i32 max_x = hm::min(x + ZBlockDim, buffer.width);
+    i32 max_y = hm::min(y + ZBlockDim, buffer.height);
+    if (x < clip_rect.min_x || y < clip_rect.min_y || max_x > clip_rect.max_x || max_y > clip_rect.max_y) {
+        return;
+    }
+
+    f32* z_block = get_z_block(buffer, x, y);
+    if (is_fully_covered) {
+        // Every pixel now holds max(old z, triangle z), so both lower bounds hold.
+        BlockDepthRange range = get_block_depth_range(triangle, x, y, ZBlockDim, ZBlockDim);
+        *z_block = hm::max(*z_block, range.z_far);
+        return;
+    }
+
+    static_assert(ZBlockDim == 8);
+    i32x8 column_mask_v8 = _mm256_cmpgt_epi32(
+        _mm256_set1_epi32(max_x - x), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    f32x8 z_min_v8 = _mm256_set1_ps(F32_MAX);
+    for (i32 py = y; py < max_y; py++) {
+        f32* z_row = buffer.z_buffer.data() + py * buffer.width + x;
+        f32x8 z_v8 = _mm256_blendv_ps(z_min_v8, _mm256_maskload_ps(z_row, column_mask_v8), _mm256_castsi256_ps(column_mask_v8));
+        z_min_v8 = _mm256_min_ps(z_min_v8, z_v8);
+    }
+    __m128 z_min_v4 = _mm_min_ps(_mm256_castps256_ps128(z_min_v8), _mm256_extractf128_ps(z_min_v8, 1));
+    z_min_v4 = _mm_min_ps(z_min_v4, _mm_movehl_ps(z_min_v4, z_min_v4));
+    z_min_v4 = _mm_min_ss(z_min_v4, _mm_shuffle_ps(z_min_v4, z_min_v4, 1));
+    *z_block = _mm_cvtss_f32(z_min_v4);
+}
+
+// Gouraud shading. r, g and b are planes over the screen like the depth, c(x, y) = a * x + b * y + c, in 0-255.
+struct ColorPlanes {
+    f32 a[3];
+    f32 b[3];
+    f32 c[3];
+};
+
+/// @brief: Planes through the colors at the vertices. Takes the triangle as given, the winding does not matter.
+auto inline setup_color_planes(vec3 P0, vec3 P1, vec3 P2, vec4 C0, vec4 C1, vec4 C2) -> ColorPlanes {
+    f32 dx1 = P1.x - P0.x;
+    f32 dy1 = P1.y - P0.y;
+    f32 dx2 = P2.x - P0.x;
+    f32 dy2 = P2.y - P0.y;
+    // Not degenerate, setup_half_space_triangle rejected those
+    f32 inv_area = 1.0f / (dx1 * dy2 - dy1 * dx2);
+
+    ColorPlanes result;
+    for (i32 i = 0; i < 3; i++) {
+        f32 c0 = C0.v[i] * 255.0f;
+        f32 d1 = C1.v[i] * 255.0f - c0;
+        f32 d2 = C2.v[i] * 255.0f - c0;
+        result.a[i] = (d1 * dy2 - d2 * dy1) * inv_area;
+        result.b[i] = (d2 * dx1 - d1 * dx2) * inv_area;
+        result.c[i] = c0 - result.a[i] * P0.x - result.b[i] * P0.y;
+    }
+    return result;
+}
+
+/// @brief: Packs the colors of a row of 8 pixels. Clamped, the planes overshoot a little at the edges of thin triangles.
+auto inline interpolate_color_planes_v8(const f32* color_row, const f32x8* color_lane_v8, i32x8 alpha_v8) -> i32x8 {
+    f32x8 r = clamp_f32_v8(0.0f, _mm256_add_ps(_mm256_set1_ps(color_row[0]), color_lane_v8[0]), 255.0f);
+    f32x8 g = clamp_f32_v8(0.0f, _mm256_add_ps(_mm256_set1_ps(color_row[1]), color_lane_v8[1]), 255.0f);
+    f32x8 b = clamp_f32_v8(0.0f, _mm256_add_ps(_mm256_set1_ps(color_row[2]), color_lane_v8[2]), 255.0f);
+    i32x8 result = _mm256_or_si256(alpha_v8, _mm256_slli_epi32(_mm256_cvtps_epi32(r), 16));
+    result = _mm256_or_si256(result, _mm256_slli_epi32(_mm256_cvtps_epi32(g), 8));
+    return _mm256_or_si256(result, _mm256_cvtps_epi32(b));
+}
+
+/// @brief: Fills the triangle with packed_color, or with the shading planes over its alpha if there are any.
+auto inline render_half_space_triangle_avx2(HalfSpaceTriangle& triangle, u32 packed_color, //
+    const ColorPlanes* shading, Rectangle2i clip_rect, Framebuffer& buffer) -> void {
+    const i32 BLOCK_DIM = 8;
+    const f32x8 zero_v8 = _mm256_setzero_ps();
+    const f32x8 lane_centers_v8 = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const i32x8 lane_index_v8 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const i32x8 color_v8 = _mm256_set1_epi32(packed_color);
+
+    f32x8 color_lane_v8[3];
+    if (shading) {
+        for (i32 i = 0; i < 3; i++) {
+            color_lane_v8[i] = _mm256_mul_ps(_mm256_set1_ps(shading->a[i]), lane_centers_v8);
+        }
+    }
+
+    f32x8 edge_lane_v8[3];
+    f32x8 top_left_v8[3];
+    for (i32 i = 0; i < 3; i++) {
+        edge_lane_v8[i] = _mm256_mul_ps(_mm256_set1_ps(triangle.edges[i].a), lane_centers_v8);
+        top_left_v8[i] = _mm256_castsi256_ps(_mm256_set1_epi32(triangle.edges[i].is_top_left ? -1 : 0));
+    }
+    const f32x8 z_lane_v8 = _mm256_mul_ps(_mm256_set1_ps(triangle.z_a), lane_centers_v8);
+
+    Rectangle2i bounds = triangle.bounds;
+    i32 start_x = bounds.min_x & ~(BLOCK_DIM - 1);
+    i32 start_y = bounds.min_y & ~(BLOCK_DIM - 1);
+    for (i32 block_y = start_y; block_y < bounds.max_y; block_y += BLOCK_DIM) {
+        i32 y_begin = hm::max(block_y, bounds.min_y);
+        i32 y_end = hm::min(block_y + BLOCK_DIM, bounds.max_y);
+
+        for (i32 block_x = start_x; block_x < bounds.max_x; block_x += BLOCK_DIM) {
+            BlockCoverage coverage = classify_block(triangle, block_x, block_y, BLOCK_DIM, BLOCK_DIM);
+            if (coverage == BlockCoverage_None || is_z_block_occluded(triangle, buffer, block_x, block_y)) {
+                continue;
+            }
+
+            // Lanes outside of the clipped bounds are never touched, not even loaded.
+            i32x8 column_mask_v8 = _mm256_and_si256(                                         //
+                _mm256_cmpgt_epi32(lane_index_v8, _mm256_set1_epi32(bounds.min_x - block_x - 1)), //
+                _mm256_cmpgt_epi32(_mm256_set1_epi32(bounds.max_x - block_x), lane_index_v8));
+
+            f32 x = (f32)block_x;
+            f32 y = (f32)y_begin + 0.5f;
+            f32 edge_row[3];
+            for (i32 i = 0; i < 3; i++) {
+                edge_row[i] = triangle.edges[i].a * x + triangle.edges[i].b * y + triangle.edges[i].c;
+            }
+            f32 z_row = triangle.z_a * x + triangle.z_b * y + triangle.z_c;
+            f32 color_row[3];
+            if (shading) {
+                for (i32 i = 0; i < 3; i++) {
+                    color_row[i] = shading->a[i] * x + shading->b[i] * y + shading->c[i];
+                }
+            }
+
+            i32 written = 0;
+            for (i32 py = y_begin; py < y_end; py++) {
+                f32x8 mask_v8 = _mm256_castsi256_ps(column_mask_v8);
+                if (coverage == BlockCoverage_Partial) {
+                    for (i32 i = 0; i < 3; i++) {
+                        f32x8 e_v8 = _mm256_add_ps(_mm256_set1_ps(edge_row[i]), edge_lane_v8[i]);
+                        f32x8 inside_v8 = _mm256_or_ps(_mm256_cmp_ps(e_v8, zero_v8, _CMP_GT_OQ),
+                            _mm256_and_ps(_mm256_cmp_ps(e_v8, zero_v8, _CMP_EQ_OQ), top_left_v8[i]));
+                        mask_v8 = _mm256_and_ps(mask_v8, inside_v8);
+                    }
+                }
+
+                if (_mm256_movemask_ps(mask_v8) != 0) {
+                    f32* z_dest = buffer.z_buffer.data() + py * buffer.width + block_x;
+                    u32* pixel_dest = (u32*)((u8*)buffer.memory + py * buffer.pitch) + block_x;
+
+                    // z > current_z, 1/w shrinks with distance.
+                    f32x8 z_v8 = _mm256_add_ps(_mm256_set1_ps(z_row), z_lane_v8);
+                    f32x8 current_z_v8 = _mm256_maskload_ps(z_dest, _mm256_castps_si256(mask_v8));
+                    mask_v8 = _mm256_and_ps(mask_v8, _mm256_cmp_ps(z_v8, current_z_v8, _CMP_GT_OQ));
+
+                    i32x8 write_mask_v8 = _mm256_castps_si256(mask_v8);
+                    i32x8 row_color_v8 = shading ? interpolate_color_planes_v8(color_row, color_lane_v8, color_v8) : color_v8;
+                    _mm256_maskstore_ps(z_dest, write_mask_v8, z_v8);
+                    _mm256_maskstore_epi32((i32*)pixel_dest, write_mask_v8, row_color_v8);
+                    written |= _mm256_movemask_ps(mask_v8);
+                }
+
+                for (i32 i = 0; i < 3; i++) {
+                    edge_row[i] += triangle.edges[i].b;
+                }
+                z_row += triangle.z_b;
+                if (shading) {
+                    for (i32 i = 0; i < 3; i++) {
+                        color_row[i] += shading->b[i];
+                    }
+                }
+            }
+
+            if (coverage == BlockCoverage_Full || written != 0) {
+                update_z_block(triangle, buffer, clip_rect, block_x, block_y, coverage == BlockCoverage_Full);
+            }
+        }
+    }
+}
+
+auto inline render_triangle_filled_half_space_avx2(
+    vec3 P0, vec3 P1, vec3 P2, vec4 color, Rectangle2i clip_rect, Framebuffer& buffer, MemoryArena& arena) -> void {
+    Assert(buffer.bytes_per_pixel == 4);
+    HalfSpaceTriangle triangle;
+    if (!setup_half_space_triangle(P0, P1, P2, clip_rect, buffer, triangle)) {
+        return;
+    }
+    render_half_space_triangle_avx2(triangle, pack_color_8x4(color), nullptr, clip_rect, buffer);
+}
+
+/// @brief: Interpolates the colors at the vertices. The alpha is C0's, a triangle is drawn with one alpha.
+auto inline render_triangle_shaded_half_space_avx2(vec3 P0, vec3 P1, vec3 P2, vec4 C0, vec4 C1, vec4 C2, //
+    Rectangle2i clip_rect, Framebuffer& buffer, MemoryArena& arena) -> void {
+    Assert(buffer.bytes_per_pixel == 4);
+    HalfSpaceTriangle triangle;
+    if (!setup_half_space_triangle(P0, P1, P2, clip_rect, buffer, triangle)) {
+        return;
+    }
+    ColorPlanes shading = setup_color_planes(P0, P1, P2, C0, C1, C2);
+    render_half_space_triangle_avx2(triangle, pack_color_8x4(vec4(0.0f, 0.0f, 0.0f, C0.a)), &shading, clip_rect, buffer);
+}
+
+auto inline interpolate_color_planes_v16(const f32* color_row, const f32x16* color_lane_v16, i32x16 alpha_v16)
+    -> i32x16 {
+    const f32x16 zero_v16 = _mm512_setzero_ps();
+    const f32x16 max_v16 = _mm512_set1_ps(255.0f);
+    f32x16 r = _mm512_min_ps(_mm512_max_ps(_mm512_add_ps(_mm512_set1_ps(color_row[0]), color_lane_v16[0]), zero_v16), max_v16);
+    f32x16 g = _mm512_min_ps(_mm512_max_ps(_mm512_add_ps(_mm512_set1_ps(color_row[1]), color_lane_v16[1]), zero_v16), max_v16);
+    f32x16 b = _mm512_min_ps(_mm512_max_ps(_mm512_add_ps(_mm512_set1_ps(color_row[2]), color_lane_v16[2]), zero_v16), max_v16);
+    i32x16 result = _mm512_or_si512(alpha_v16, _mm512_slli_epi32(_mm512_cvtps_epi32(r), 16));
+    result = _mm512_or_si512(result, _mm512_slli_epi32(_mm512_cvtps_epi32(g), 8));
+    return _mm512_or_si512(result, _mm512_cvtps_epi32(b));
+}
+
+auto inline render_half_space_triangle_avx512(HalfSpaceTriangle& triangle, u32 packed_color, //
+    const ColorPlanes* shading, Rectangle2i clip_rect, Framebuffer& buffer) -> void {
+    // 16 lanes, so a block row fills a whole register.
+    const i32 BLOCK_DIM_X = 16;
+    const i32 BLOCK_DIM_Y = 8;
+    const f32x16 zero_v16 = _mm512_setzero_ps();
+    const f32x16 lane_centers_v16 = _mm512_setr_ps(
+        0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f, 8.5f, 9.5f, 10.5f, 11.5f, 12.5f, 13.5f, 14.5f, 15.5f);
+    const i32x16 color_v16 = _mm512_set1_epi32(packed_color);
+
+    f32x16 color_lane_v16[3];
+    if (shading) {
+        for (i32 i = 0; i < 3; i++) {
+            color_lane_v16[i] = _mm512_mul_ps(_mm512_set1_ps(shading->a[i]), lane_centers_v16);
+        }
+    }
+
+    f32x16 edge_lane_v16[3];
+    __mmask16 top_left_mask[3];
+    for (i32 i = 0; i < 3; i++) {
+        edge_lane_v16[i] = _mm512_mul_ps(_mm512_set1_ps(triangle.edges[i].a), lane_centers_v16);
+        top_left_mask[i] = triangle.edges[i].is_top_left ? 0xFFFF : 0;
+    }
+    const f32x16 z_lane_v16 = _mm512_mul_ps(_mm512_set1_ps(triangle.z_a), lane_centers_v16);
+
+    Rectangle2i bounds = triangle.bounds;
+    i32 start_x = bounds.min_x & ~(BLOCK_DIM_X - 1);
+    i32 start_y = bounds.min_y & ~(BLOCK_DIM_Y - 1);
+    for (i32 block_y = start_y; block_y < bounds.max_y; block_y += BLOCK_DIM_Y) {
+        i32 y_begin = hm::max(block_y, bounds.min_y);
+        i32 y_end = hm::min(block_y + BLOCK_DIM_Y, bounds.max_y);
+
+        for (i32 block_x = start_x; block_x < bounds.max_x; block_x += BLOCK_DIM_X) {
+            BlockCoverage coverage = classify_block(triangle, block_x, block_y, BLOCK_DIM_X, BLOCK_DIM_Y);
+            if (coverage == BlockCoverage_None) {
+                continue;
+            }
+
+            // Lanes outside of the clipped bounds are never touched, not even loaded.
+            i32 first_lane = hm::max(bounds.min_x - block_x, 0);
+            i32 last_lane = hm::min(bounds.max_x - block_x, BLOCK_DIM_X);
+            __mmask16 column_mask = (__mmask16)(((1u << last_lane) - 1) & ~((1u << first_lane) - 1));
+
+            // The block spans two z blocks, drop the half the triangle is hidden behind.
+            static_assert(BLOCK_DIM_X == 2 * ZBlockDim && BLOCK_DIM_Y == ZBlockDim);
+            for (i32 half = 0; half < 2; half++) {
+                __mmask16 half_mask = (__mmask16)(0xFF << (half * ZBlockDim));
+                i32 half_x = block_x + half * ZBlockDim;
+                if ((column_mask & half_mask) && is_z_block_occluded(triangle, buffer, half_x, block_y)) {
+                    column_mask &= ~half_mask;
+                }
+            }
+            if (column_mask == 0) {
+                continue;
+            }
+
+            f32 x = (f32)block_x;
+            f32 y = (f32)y_begin + 0.5f;
+            f32 edge_row[3];
+            for (i32 i = 0; i < 3; i++) {
+                edge_row[i] = triangle.edges[i].a * x + triangle.edges[i].b * y + triangle.edges[i].c;
+            }
+            f32 z_row = triangle.z_a * x + triangle.z_b * y + triangle.z_c;
+            f32 color_row[3];
+            if (shading) {
+                for (i32 i = 0; i < 3; i++) {
+                    color_row[i] = shading->a[i] * x + shading->b[i] * y + shading->c[i];
+                }
+            }
+
+            __mmask16 written = 0;
+            for (i32 py = y_begin; py < y_end; py++) {
+                __mmask16 mask = column_mask;
+                if (coverage == BlockCoverage_Partial) {
+                    for (i32 i = 0; i < 3; i++) {
+                        f32x16 e_v16 = _mm512_add_ps(_mm512_set1_ps(edge_row[i]), edge_lane_v16[i]);
+                        __mmask16 inside = _mm512_cmp_ps_mask(e_v16, zero_v16, _CMP_GT_OQ) |
+                            (_mm512_cmp_ps_mask(e_v16, zero_v16, _CMP_EQ_OQ) & top_left_mask[i]);
+                        mask &= inside;
+                    }
+                }
+
+                if (mask != 0) {
+                    f32* z_dest = buffer.z_buffer.data() + py * buffer.width + block_x;
+                    u32* pixel_dest = (u32*)((u8*)buffer.memory + py * buffer.pitch) + block_x;
+
+                    // z > current_z, 1/w shrinks with distance.
+                    f32x16 z_v16 = _mm512_add_ps(_mm512_set1_ps(z_row), z_lane_v16);
+                    f32x16 current_z_v16 = _mm512_maskz_loadu_ps(mask, z_dest);
+                    mask &= _mm512_cmp_ps_mask(z_v16, current_z_v16, _CMP_GT_OQ);
+
+                    i32x16 row_color_v16 = shading ? interpolate_color_planes_v16(color_row, color_lane_v16, color_v16) : color_v16;
+                    _mm512_mask_storeu_ps(z_dest, mask, z_v16);
+                    _mm512_mask_storeu_epi32(pixel_dest, mask, row_color_v16);
+                    written |= mask;
+                }
+
+                for (i32 i = 0; i < 3; i++) {
+                    edge_row[i] += triangle.edges[i].b;
+                }
+                z_row += triangle.z_b;
+                if (shading) {
+                    for (i32 i = 0; i < 3; i++) {
+                        color_row[i] += shading->b[i];
+                    }
+                }
+            }
+
+            for (i32 half = 0; half < 2; half++) {
+                __mmask16 half_mask = (__mmask16)(0xFF << (half * ZBlockDim));
+                bool is_fully_covered = coverage == BlockCoverage_Full && (column_mask & half_mask) == half_mask;
+                if (is_fully_covered || (written & half_mask)) {
+                    update_z_block(triangle, buffer, clip_rect, block_x + half * ZBlockDim, block_y, is_fully_covered);
+                }
+            }
+        }
+    }
+}
+
+auto inline render_triangle_filled_half_space_avx512(
+    vec3 P0, vec3 P1, vec3 P2, vec4 color, Rectangle2i clip_rect, Framebuffer& buffer, MemoryArena& arena) -> void {
+    Assert(buffer.bytes_per_pixel == 4);
+    HalfSpaceTriangle triangle;
+    if (!setup_half_space_triangle(P0, P1, P2, clip_rect, buffer, triangle)) {
+        return;
+    }
+    render_half_space_triangle_avx512(triangle, pack_color_8x4(color), nullptr, clip_rect, buffer);
+}
+
+auto inline render_triangle_shaded_half_space_avx512(vec3 P0, vec3 P1, vec3 P2, vec4 C0, vec4 C1, vec4 C2, //
+    Rectangle2i clip_rect, Framebuffer& buffer, MemoryArena& arena) -> void {
+    Assert(buffer.bytes_per_pixel == 4);
+    HalfSpaceTriangle triangle;
+    if (!setup_half_space_triangle(P0, P1, P2, clip_rect, buffer, triangle)) {
+        return;
+    }
+    ColorPlanes shading = setup_color_planes(P0, P1, P2, C0, C1, C2);
+    render_half_space_triangle_avx512(triangle, pack_color_8x4(vec4(0.0f, 0.0f, 0.0f, C0.a)), &shading, clip_rect, buffer);
+}
+
+enum TriangleRasterizer {
+    TriangleRasterizer_Gambetta, //
+    TriangleRasterizer_HalfSpace //
+};
+
+typedef void (*render_triangle_filled_fn)(
+    vec3 P0, vec3 P1, vec3 P2, vec4 color, Rectangle2i clip_rect, Framebuffer& buffer, MemoryArena& arena);
+global_variable render_triangle_filled_fn render_triangle_filled = render_triangle_filled_gambetta;
+
+typedef void (*render_triangle_shaded_fn)(vec3 P0, vec3 P1, vec3 P2, vec4 C0, vec4 C1, vec4 C2, //
+    Rectangle2i clip_rect, Framebuffer& buffer, MemoryArena& arena);
+global_variable render_triangle_shaded_fn render_triangle_shaded = render_triangle_shaded_half_space_avx2;
+
+/// @brief: Picks the filled triangle rasterizer used by tri-meshes and filled triangle commands.
+/// Both stay available so they can be benchmarked against each other.
+auto inline select_triangle_rasterizer(TriangleRasterizer rasterizer) -> void {
+    switch (rasterizer) {
+    case TriangleRasterizer_Gambetta: {
+        // No shaded variant, lit meshes keep the half space one
+        render_triangle_filled = render_triangle_filled_gambetta;
+    } break;
+    case TriangleRasterizer_HalfSpace: {
+        if (cpu_supports_avx512f()) {
+            render_triangle_filled = render_triangle_filled_half_space_avx512;
+            render_triangle_shaded = render_triangle_shaded_half_space_avx512;
+        }
+        else {
+            render_triangle_filled = render_triangle_filled_half_space_avx2;
+            render_triangle_shaded = render_triangle_shaded_half_space_avx2;
+        }
+    } break;
+    default: InvalidCodePath;
+    }
+}
+
 auto inline render_shaded_triangle_gambetta(vec3 P0, vec3 P1, vec3 P2, f32 h0, f32 h1, f32 h2, vec4 color,
     Rectangle2i clip_rect, Framebuffer& buffer, MemoryArena& arena) -> void {
 
@@ -509,6 +1016,404 @@ auto inline is_inside_view(vec4 p) -> bool {
     return in_range(-p.w, p.x, p.w) && in_range(-p.w, p.y, p.w) && in_range(-p.w, p.z, p.w);
 }
 
+// Wider than the view by this factor in x and y. Triangles inside it are left to the rasterizer, which only visits
+// the pixels inside its clip rect. Screen coordinates stay within a few widths of the view, small enough for the
+// edge functions to keep their precision.
+const f32 GuardBandScale = 4.0f;
+
+// The clip planes a clip space vertex is outside of, the same tests the clipper does.
+enum ClipCode : u8 {
+    ClipCode_NegativeX = 1 << 0,
+    ClipCode_PositiveX = 1 << 1,
+    ClipCode_NegativeY = 1 << 2,
+    ClipCode_PositiveY = 1 << 3,
+    ClipCode_NegativeZ = 1 << 4,
+    ClipCode_PositiveZ = 1 << 5,
+    // Outside of the guard band on either side
+    ClipCode_GuardBandX = 1 << 6,
+    ClipCode_GuardBandY = 1 << 7,
+};
+
+// A triangle whose vertices all share one of these is entirely outside of the view.
+const u8 ClipCodes_View = ClipCode_NegativeX | ClipCode_PositiveX | ClipCode_NegativeY | ClipCode_PositiveY |
+                          ClipCode_NegativeZ | ClipCode_PositiveZ;
+// A triangle with a vertex outside of one of these has to be clipped before it is projected.
+const u8 ClipCodes_GuardBand = ClipCode_NegativeZ | ClipCode_PositiveZ | ClipCode_GuardBandX | ClipCode_GuardBandY;
+
+auto inline compute_clip_code(f32 x, f32 y, f32 z, f32 w) -> u8 {
+    u8 clip_code = 0;
+    clip_code |= x < -w ? ClipCode_NegativeX : 0;
+    clip_code |= x > w ? ClipCode_PositiveX : 0;
+    clip_code |= y < -w ? ClipCode_NegativeY : 0;
+    clip_code |= y > w ? ClipCode_PositiveY : 0;
+    clip_code |= z < -w ? ClipCode_NegativeZ : 0;
+    clip_code |= z > w ? ClipCode_PositiveZ : 0;
+    f32 guard_band_w = GuardBandScale * w;
+    clip_code |= x < -guard_band_w || x > guard_band_w ? ClipCode_GuardBandX : 0;
+    clip_code |= y < -guard_band_w || y > guard_band_w ? ClipCode_GuardBandY : 0;
+    return clip_code;
+}
+
+enum FrustumTest : u8 {
+    FrustumTest_Outside,
+    // Inside the near and far planes and the guard band, nothing needs clipping
+    FrustumTest_Inside,
+    FrustumTest_Intersecting,
+};
+
+/// @brief: Tests the corners of a model space box in clip space. The box is convex, so it is outside when all
+/// corners are outside of the same plane, and everything in it is inside when all corners are.
+auto inline test_bounds_against_frustum(const AABB& bounds, const mat4& model_to_clip) -> FrustumTest {
+    u8 all_codes = 0xFF;
+    u8 any_codes = 0;
+    for (i32 i = 0; i < 8; i++) {
+        vec4 p = AABB_corner(bounds, i) * model_to_clip;
+        u8 clip_code = compute_clip_code(p.x, p.y, p.z, p.w);
+        all_codes &= clip_code;
+        any_codes |= clip_code;
+    }
+    if (all_codes & ClipCodes_View) {
+        return FrustumTest_Outside;
+    }
+    return any_codes & ClipCodes_GuardBand ? FrustumTest_Intersecting : FrustumTest_Inside;
+}
+
+// Output of the vertex transform, structure of arrays padded like VertexPositions. x, y and inv_w are what
+// project_vertex returns, only meaningful for the vertices with a clip code of 0.
+struct ProjectedVertices {
+    Array<f32> x;
+    Array<f32> y;
+    Array<f32> inv_w;
+    Array<u8> clip_codes;
+};
+
+auto inline create_projected_vertices(u32 count, MemoryArena& arena) -> ProjectedVertices {
+    u32 padded_count = vertex_batch_padded_count(count);
+    ProjectedVertices result = {};
+    result.x = Array<f32>::create(padded_count, arena);
+    result.y = Array<f32>::create(padded_count, arena);
+    result.inv_w = Array<f32>::create(padded_count, arena);
+    result.clip_codes = Array<u8>::create(padded_count, arena);
+    return result;
+}
+
+/// @brief: Transforms count model space positions to clip space, and projects them to the screen in the same pass.
+typedef void (*transform_vertices_fn)(const VertexPositions& positions, u32 count, const mat4& model_to_clip, //
+    i32 width, i32 height, ProjectedVertices* result);
+
+auto inline transform_vertices_scalar(const VertexPositions& positions, u32 count, const mat4& model_to_clip, //
+    i32 width, i32 height, ProjectedVertices* result) -> void {
+    Assert(positions.x.count() >= count && result->x.count() >= count);
+    const f32* m = model_to_clip.v;
+    f32 half_width = 0.5f * (f32)(width - 1);
+    f32 half_height = 0.5f * (f32)(height - 1);
+    for (u32 i = 0; i < count; i++) {
+        f32 px = positions.x[i];
+        f32 py = positions.y[i];
+        f32 pz = positions.z[i];
+        f32 x = px * m[0] + py * m[4] + pz * m[8] + m[12];
+        f32 y = px * m[1] + py * m[5] + pz * m[9] + m[13];
+        f32 z = px * m[2] + py * m[6] + pz * m[10] + m[14];
+        f32 w = px * m[3] + py * m[7] + pz * m[11] + m[15];
+
+        u8 clip_code = compute_clip_code(x, y, z, w);
+
+        f32 inv_w = 1.0f / w;
+        result->x[i] = x * inv_w * half_width + half_width;
+        result->y[i] = y * inv_w * half_height + half_height;
+        result->inv_w[i] = inv_w;
+        result->clip_codes[i] = clip_code;
+    }
+}
+
+/// @brief: 8 vertices per iteration. Runs over the padding up to the next multiple of 8.
+auto inline transform_vertices_avx2(const VertexPositions& positions, u32 count, const mat4& model_to_clip, //
+    i32 width, i32 height, ProjectedVertices* result) -> void {
+    Assert(positions.x.count() >= vertex_batch_padded_count(count));
+    Assert(result->x.count() >= vertex_batch_padded_count(count));
+    f32x8 m_v8[16];
+    for (i32 i = 0; i < 16; i++) {
+        m_v8[i] = _mm256_set1_ps(model_to_clip.v[i]);
+    }
+    f32x8 half_width_v8 = _mm256_set1_ps(0.5f * (f32)(width - 1));
+    f32x8 half_height_v8 = _mm256_set1_ps(0.5f * (f32)(height - 1));
+    f32x8 guard_band_scale_v8 = _mm256_set1_ps(GuardBandScale);
+    f32x8 one_v8 = _mm256_set1_ps(1.0f);
+    f32x8 zero_v8 = _mm256_setzero_ps();
+
+    for (u32 i = 0; i < count; i += 8) {
+        f32x8 px = _mm256_loadu_ps(positions.x.data() + i);
+        f32x8 py = _mm256_loadu_ps(positions.y.data() + i);
+        f32x8 pz = _mm256_loadu_ps(positions.z.data() + i);
+        f32x8 x = _mm256_fmadd_ps(pz, m_v8[8], _mm256_fmadd_ps(py, m_v8[4], _mm256_fmadd_ps(px, m_v8[0], m_v8[12])));
+        f32x8 y = _mm256_fmadd_ps(pz, m_v8[9], _mm256_fmadd_ps(py, m_v8[5], _mm256_fmadd_ps(px, m_v8[1], m_v8[13])));
+        f32x8 z = _mm256_fmadd_ps(pz, m_v8[10], _mm256_fmadd_ps(py, m_v8[6], _mm256_fmadd_ps(px, m_v8[2], m_v8[14])));
+        f32x8 w = _mm256_fmadd_ps(pz, m_v8[11], _mm256_fmadd_ps(py, m_v8[7], _mm256_fmadd_ps(px, m_v8[3], m_v8[15])));
+
+        f32x8 negative_w = _mm256_sub_ps(zero_v8, w);
+        i32x8 clip_code = _mm256_and_si256(
+            _mm256_castps_si256(_mm256_cmp_ps(x, negative_w, _CMP_LT_OQ)), _mm256_set1_epi32(ClipCode_NegativeX));
+        clip_code = _mm256_or_si256(clip_code,
+            _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(x, w, _CMP_GT_OQ)), _mm256_set1_epi32(ClipCode_PositiveX)));
+        clip_code = _mm256_or_si256(clip_code, _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(y, negative_w, _CMP_LT_OQ)),
+                                                   _mm256_set1_epi32(ClipCode_NegativeY)));
+        clip_code = _mm256_or_si256(clip_code,
+            _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(y, w, _CMP_GT_OQ)), _mm256_set1_epi32(ClipCode_PositiveY)));
+        clip_code = _mm256_or_si256(clip_code, _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(z, negative_w, _CMP_LT_OQ)),
+                                                   _mm256_set1_epi32(ClipCode_NegativeZ)));
+        clip_code = _mm256_or_si256(clip_code,
+            _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(z, w, _CMP_GT_OQ)), _mm256_set1_epi32(ClipCode_PositiveZ)));
+        f32x8 guard_band_w = _mm256_mul_ps(guard_band_scale_v8, w);
+        f32x8 negative_guard_band_w = _mm256_sub_ps(zero_v8, guard_band_w);
+        f32x8 is_outside_x = _mm256_or_ps(
+            _mm256_cmp_ps(x, negative_guard_band_w, _CMP_LT_OQ), _mm256_cmp_ps(x, guard_band_w, _CMP_GT_OQ));
+        f32x8 is_outside_y = _mm256_or_ps(
+            _mm256_cmp_ps(y, negative_guard_band_w, _CMP_LT_OQ), _mm256_cmp_ps(y, guard_band_w, _CMP_GT_OQ));
+        clip_code = _mm256_or_si256(
+            clip_code, _mm256_and_si256(_mm256_castps_si256(is_outside_x), _mm256_set1_epi32(ClipCode_GuardBandX)));
+        clip_code = _mm256_or_si256(
+            clip_code, _mm256_and_si256(_mm256_castps_si256(is_outside_y), _mm256_set1_epi32(ClipCode_GuardBandY)));
+        // 8 x i32 to 8 x u8, the codes fit in the low byte
+        __m128i clip_code_i16 = _mm_packs_epi32(_mm256_castsi256_si128(clip_code), _mm256_extracti128_si256(clip_code, 1));
+        _mm_storel_epi64((__m128i*)(result->clip_codes.data() + i), _mm_packus_epi16(clip_code_i16, clip_code_i16));
+
+        f32x8 inv_w = _mm256_div_ps(one_v8, w);
+        _mm256_storeu_ps(result->x.data() + i, _mm256_fmadd_ps(_mm256_mul_ps(x, inv_w), half_width_v8, half_width_v8));
+        _mm256_storeu_ps(result->y.data() + i, _mm256_fmadd_ps(_mm256_mul_ps(y, inv_w), half_height_v8, half_height_v8));
+        _mm256_storeu_ps(result->inv_w.data() + i, inv_w);
+    }
+}
+
+/// @brief: 16 vertices per iteration. Runs over the padding up to the next multiple of 16.
+auto inline transform_vertices_avx512(const VertexPositions& positions, u32 count, const mat4& model_to_clip, //
+    i32 width, i32 height, ProjectedVertices* result) -> void {
+    Assert(positions.x.count() >= vertex_batch_padded_count(count));
+    Assert(result->x.count() >= vertex_batch_padded_count(count));
+    f32x16 m_v16[16];
+    for (i32 i = 0; i < 16; i++) {
+        m_v16[i] = _mm512_set1_ps(model_to_clip.v[i]);
+    }
+    f32x16 half_width_v16 = _mm512_set1_ps(0.5f * (f32)(width - 1));
+    f32x16 half_height_v16 = _mm512_set1_ps(0.5f * (f32)(height - 1));
+    f32x16 guard_band_scale_v16 = _mm512_set1_ps(GuardBandScale);
+    f32x16 one_v16 = _mm512_set1_ps(1.0f);
+    f32x16 zero_v16 = _mm512_setzero_ps();
+
+    for (u32 i = 0; i < count; i += 16) {
+        f32x16 px = _mm512_loadu_ps(positions.x.data() + i);
+        f32x16 py = _mm512_loadu_ps(positions.y.data() + i);
+        f32x16 pz = _mm512_loadu_ps(positions.z.data() + i);
+        f32x16 x = _mm512_fmadd_ps(pz, m_v16[8], _mm512_fmadd_ps(py, m_v16[4], _mm512_fmadd_ps(px, m_v16[0], m_v16[12])));
+        f32x16 y = _mm512_fmadd_ps(pz, m_v16[9], _mm512_fmadd_ps(py, m_v16[5], _mm512_fmadd_ps(px, m_v16[1], m_v16[13])));
+        f32x16 z = _mm512_fmadd_ps(pz, m_v16[10], _mm512_fmadd_ps(py, m_v16[6], _mm512_fmadd_ps(px, m_v16[2], m_v16[14])));
+        f32x16 w = _mm512_fmadd_ps(pz, m_v16[11], _mm512_fmadd_ps(py, m_v16[7], _mm512_fmadd_ps(px, m_v16[3], m_v16[15])));
+
+        f32x16 negative_w = _mm512_sub_ps(zero_v16, w);
+        i32x16 clip_code = _mm512_setzero_si512();
+        clip_code = _mm512_mask_or_epi32(clip_code, _mm512_cmp_ps_mask(x, negative_w, _CMP_LT_OQ), clip_code,
+            _mm512_set1_epi32(ClipCode_NegativeX));
+        clip_code = _mm512_mask_or_epi32(
+            clip_code, _mm512_cmp_ps_mask(x, w, _CMP_GT_OQ), clip_code, _mm512_set1_epi32(ClipCode_PositiveX));
+        clip_code = _mm512_mask_or_epi32(clip_code, _mm512_cmp_ps_mask(y, negative_w, _CMP_LT_OQ), clip_code,
+            _mm512_set1_epi32(ClipCode_NegativeY));
+        clip_code = _mm512_mask_or_epi32(
+            clip_code, _mm512_cmp_ps_mask(y, w, _CMP_GT_OQ), clip_code, _mm512_set1_epi32(ClipCode_PositiveY));
+        clip_code = _mm512_mask_or_epi32(clip_code, _mm512_cmp_ps_mask(z, negative_w, _CMP_LT_OQ), clip_code,
+            _mm512_set1_epi32(ClipCode_NegativeZ));
+        clip_code = _mm512_mask_or_epi32(
+            clip_code, _mm512_cmp_ps_mask(z, w, _CMP_GT_OQ), clip_code, _mm512_set1_epi32(ClipCode_PositiveZ));
+        f32x16 guard_band_w = _mm512_mul_ps(guard_band_scale_v16, w);
+        f32x16 negative_guard_band_w = _mm512_sub_ps(zero_v16, guard_band_w);
+        __mmask16 is_outside_x =
+            _mm512_cmp_ps_mask(x, negative_guard_band_w, _CMP_LT_OQ) | _mm512_cmp_ps_mask(x, guard_band_w, _CMP_GT_OQ);
+        __mmask16 is_outside_y =
+            _mm512_cmp_ps_mask(y, negative_guard_band_w, _CMP_LT_OQ) | _mm512_cmp_ps_mask(y, guard_band_w, _CMP_GT_OQ);
+        clip_code = _mm512_mask_or_epi32(clip_code, is_outside_x, clip_code, _mm512_set1_epi32(ClipCode_GuardBandX));
+        clip_code = _mm512_mask_or_epi32(clip_code, is_outside_y, clip_code, _mm512_set1_epi32(ClipCode_GuardBandY));
+        _mm_storeu_si128((__m128i*)(result->clip_codes.data() + i), _mm512_cvtepi32_epi8(clip_code));
+
+        f32x16 inv_w = _mm512_div_ps(one_v16, w);
+        _mm512_storeu_ps(result->x.data() + i, _mm512_fmadd_ps(_mm512_mul_ps(x, inv_w), half_width_v16, half_width_v16));
+        _mm512_storeu_ps(result->y.data() + i, _mm512_fmadd_ps(_mm512_mul_ps(y, inv_w), half_height_v16, half_height_v16));
+        _mm512_storeu_ps(result->inv_w.data() + i, inv_w);
+    }
+}
+
+global_variable transform_vertices_fn transform_vertices = transform_vertices_avx2;
+
+// Light reaching each vertex, linear rgb. Padded like VertexPositions.
+struct VertexLight {
+    Array<f32> r;
+    Array<f32> g;
+    Array<f32> b;
+};
+
+auto inline create_vertex_light(u32 count, MemoryArena& arena) -> VertexLight {
+    u32 padded_count = vertex_batch_padded_count(count);
+    VertexLight result = {};
+    result.r = Array<f32>::create(padded_count, arena);
+    result.g = Array<f32>::create(padded_count, arena);
+    result.b = Array<f32>::create(padded_count, arena);
+    return result;
+}
+
+/// @brief: Brings the lights to model space, so the vertices can be lit where they are. Right for rotations and
+/// uniform scales, like the backface culling. Point lights have no range, so they do not fall off with distance.
+auto inline transform_lights_to_model(const MeshLights& lights, const mat4& world_to_model, MemoryArena& arena)
+    -> MeshLights {
+    MeshLights result = {};
+    result.ambient = lights.ambient;
+    result.directional = Array<DirectionalLight>::create(lights.directional.count(), arena);
+    for (u32 i = 0; i < lights.directional.count(); i++) {
+        const DirectionalLight& light = lights.directional[i];
+        vec4 L = vec4(light.L.x, light.L.y, light.L.z, 0.0f) * world_to_model;
+        vec3 L_M = normalized(vec3(L.x, L.y, L.z));
+        result.directional[i].L = vec4(L_M.x, L_M.y, L_M.z, 0.0f);
+        result.directional[i].color = light.color;
+    }
+    result.point = Array<PointLight>::create(lights.point.count(), arena);
+    for (u32 i = 0; i < lights.point.count(); i++) {
+        const PointLight& light = lights.point[i];
+        result.point[i].P = vec4(light.P.x, light.P.y, light.P.z, 1.0f) * world_to_model;
+        result.point[i].color = light.color;
+    }
+    return result;
+}
+
+/// @brief: Ambient, plus n.L times the color of every light the vertex faces. Not clamped, colors are clamped after
+/// they are multiplied by the surface color.
+typedef void (*light_vertices_fn)(const VertexPositions& positions, const VertexNormals& normals, u32 count, //
+    const MeshLights& lights, VertexLight* result);
+
+auto inline light_vertices_scalar(const VertexPositions& positions, const VertexNormals& normals, u32 count, //
+    const MeshLights& lights, VertexLight* result) -> void {
+    Assert(positions.x.count() >= count && normals.x.count() >= count && result->r.count() >= count);
+    for (u32 i = 0; i < count; i++) {
+        vec3 P = vec3(positions.x[i], positions.y[i], positions.z[i]);
+        vec3 N = vec3(normals.x[i], normals.y[i], normals.z[i]);
+        vec3 light = vec3(lights.ambient.color.r, lights.ambient.color.g, lights.ambient.color.b);
+        for (const DirectionalLight& directional : lights.directional) {
+            f32 n_dot_l = N.x * directional.L.x + N.y * directional.L.y + N.z * directional.L.z;
+            if (n_dot_l > 0.0f) {
+                light = light + vec3(directional.color.r, directional.color.g, directional.color.b) * n_dot_l;
+            }
+        }
+        for (const PointLight& point : lights.point) {
+            vec3 L = vec3(point.P.x, point.P.y, point.P.z) - P;
+            f32 n_dot_l = dot(N, L);
+            if (n_dot_l > 0.0f) {
+                n_dot_l /= sqrtf(dot(L, L));
+                light = light + vec3(point.color.r, point.color.g, point.color.b) * n_dot_l;
+            }
+        }
+        result->r[i] = light.x;
+        result->g[i] = light.y;
+        result->b[i] = light.z;
+    }
+}
+
+auto inline light_vertices_avx2(const VertexPositions& positions, const VertexNormals& normals, u32 count, //
+    const MeshLights& lights, VertexLight* result) -> void {
+    Assert(positions.x.count() >= vertex_batch_padded_count(count));
+    Assert(normals.x.count() >= vertex_batch_padded_count(count));
+    Assert(result->r.count() >= vertex_batch_padded_count(count));
+    f32x8 zero_v8 = _mm256_setzero_ps();
+
+    for (u32 i = 0; i < count; i += 8) {
+        f32x8 nx = _mm256_loadu_ps(normals.x.data() + i);
+        f32x8 ny = _mm256_loadu_ps(normals.y.data() + i);
+        f32x8 nz = _mm256_loadu_ps(normals.z.data() + i);
+        f32x8 r = _mm256_set1_ps(lights.ambient.color.r);
+        f32x8 g = _mm256_set1_ps(lights.ambient.color.g);
+        f32x8 b = _mm256_set1_ps(lights.ambient.color.b);
+
+        for (const DirectionalLight& directional : lights.directional) {
+            f32x8 n_dot_l = _mm256_mul_ps(nx, _mm256_set1_ps(directional.L.x));
+            n_dot_l = _mm256_fmadd_ps(ny, _mm256_set1_ps(directional.L.y), n_dot_l);
+            n_dot_l = _mm256_fmadd_ps(nz, _mm256_set1_ps(directional.L.z), n_dot_l);
+            n_dot_l = _mm256_max_ps(n_dot_l, zero_v8);
+            r = _mm256_fmadd_ps(n_dot_l, _mm256_set1_ps(directional.color.r), r);
+            g = _mm256_fmadd_ps(n_dot_l, _mm256_set1_ps(directional.color.g), g);
+            b = _mm256_fmadd_ps(n_dot_l, _mm256_set1_ps(directional.color.b), b);
+        }
+
+        if (lights.point.count() > 0) {
+            f32x8 px = _mm256_loadu_ps(positions.x.data() + i);
+            f32x8 py = _mm256_loadu_ps(positions.y.data() + i);
+            f32x8 pz = _mm256_loadu_ps(positions.z.data() + i);
+            for (const PointLight& point : lights.point) {
+                f32x8 lx = _mm256_sub_ps(_mm256_set1_ps(point.P.x), px);
+                f32x8 ly = _mm256_sub_ps(_mm256_set1_ps(point.P.y), py);
+                f32x8 lz = _mm256_sub_ps(_mm256_set1_ps(point.P.z), pz);
+                f32x8 length_sq = _mm256_fmadd_ps(lz, lz, _mm256_fmadd_ps(ly, ly, _mm256_mul_ps(lx, lx)));
+                f32x8 n_dot_l = _mm256_fmadd_ps(nz, lz, _mm256_fmadd_ps(ny, ly, _mm256_mul_ps(nx, lx)));
+                // Only lanes facing the light, which also skips a light on the vertex
+                f32x8 is_facing = _mm256_cmp_ps(n_dot_l, zero_v8, _CMP_GT_OQ);
+                n_dot_l = _mm256_and_ps(_mm256_div_ps(n_dot_l, _mm256_sqrt_ps(length_sq)), is_facing);
+                r = _mm256_fmadd_ps(n_dot_l, _mm256_set1_ps(point.color.r), r);
+                g = _mm256_fmadd_ps(n_dot_l, _mm256_set1_ps(point.color.g), g);
+                b = _mm256_fmadd_ps(n_dot_l, _mm256_set1_ps(point.color.b), b);
+            }
+        }
+
+        _mm256_storeu_ps(result->r.data() + i, r);
+        _mm256_storeu_ps(result->g.data() + i, g);
+        _mm256_storeu_ps(result->b.data() + i, b);
+    }
+}
+
+auto inline light_vertices_avx512(const VertexPositions& positions, const VertexNormals& normals, u32 count, //
+    const MeshLights& lights, VertexLight* result) -> void {
+    Assert(positions.x.count() >= vertex_batch_padded_count(count));
+    Assert(normals.x.count() >= vertex_batch_padded_count(count));
+    Assert(result->r.count() >= vertex_batch_padded_count(count));
+    f32x16 zero_v16 = _mm512_setzero_ps();
+
+    for (u32 i = 0; i < count; i += 16) {
+        f32x16 nx = _mm512_loadu_ps(normals.x.data() + i);
+        f32x16 ny = _mm512_loadu_ps(normals.y.data() + i);
+        f32x16 nz = _mm512_loadu_ps(normals.z.data() + i);
+        f32x16 r = _mm512_set1_ps(lights.ambient.color.r);
+        f32x16 g = _mm512_set1_ps(lights.ambient.color.g);
+        f32x16 b = _mm512_set1_ps(lights.ambient.color.b);
+
+        for (const DirectionalLight& directional : lights.directional) {
+            f32x16 n_dot_l = _mm512_mul_ps(nx, _mm512_set1_ps(directional.L.x));
+            n_dot_l = _mm512_fmadd_ps(ny, _mm512_set1_ps(directional.L.y), n_dot_l);
+            n_dot_l = _mm512_fmadd_ps(nz, _mm512_set1_ps(directional.L.z), n_dot_l);
+            n_dot_l = _mm512_max_ps(n_dot_l, zero_v16);
+            r = _mm512_fmadd_ps(n_dot_l, _mm512_set1_ps(directional.color.r), r);
+            g = _mm512_fmadd_ps(n_dot_l, _mm512_set1_ps(directional.color.g), g);
+            b = _mm512_fmadd_ps(n_dot_l, _mm512_set1_ps(directional.color.b), b);
+        }
+
+        if (lights.point.count() > 0) {
+            f32x16 px = _mm512_loadu_ps(positions.x.data() + i);
+            f32x16 py = _mm512_loadu_ps(positions.y.data() + i);
+            f32x16 pz = _mm512_loadu_ps(positions.z.data() + i);
+            for (const PointLight& point : lights.point) {
+                f32x16 lx = _mm512_sub_ps(_mm512_set1_ps(point.P.x), px);
+                f32x16 ly = _mm512_sub_ps(_mm512_set1_ps(point.P.y), py);
+                f32x16 lz = _mm512_sub_ps(_mm512_set1_ps(point.P.z), pz);
+                f32x16 length_sq = _mm512_fmadd_ps(lz, lz, _mm512_fmadd_ps(ly, ly, _mm512_mul_ps(lx, lx)));
+                f32x16 n_dot_l = _mm512_fmadd_ps(nz, lz, _mm512_fmadd_ps(ny, ly, _mm512_mul_ps(nx, lx)));
+                // Only lanes facing the light, which also skips a light on the vertex
+                __mmask16 is_facing = _mm512_cmp_ps_mask(n_dot_l, zero_v16, _CMP_GT_OQ);
+                n_dot_l = _mm512_maskz_div_ps(is_facing, n_dot_l, _mm512_sqrt_ps(length_sq));
+                r = _mm512_fmadd_ps(n_dot_l, _mm512_set1_ps(point.color.r), r);
+                g = _mm512_fmadd_ps(n_dot_l, _mm512_set1_ps(point.color.g), g);
+                b = _mm512_fmadd_ps(n_dot_l, _mm512_set1_ps(point.color.b), b);
+            }
+        }
+
+        _mm512_storeu_ps(result->r.data() + i, r);
+        _mm512_storeu_ps(result->g.data() + i, g);
+        _mm512_storeu_ps(result->b.data() + i, b);
+    }
+}
+
+global_variable light_vertices_fn light_vertices = light_vertices_avx2;
+
 enum PlaneIdx : i8 {
     PlaneIdx_X = 0,
     PlaneIdx_Y = 1,
@@ -521,27 +1426,108 @@ enum PlaneDirection : i8 {
     PlaneDirection_Backwards = -1,
 };
 
+// What the clipper reads and writes per vertex. The colors are optional, empty to clip the positions alone.
+struct ClipVertices {
+    Array<vec4> in_positions;
+    Array<vec4> in_colors;
+    List<vec4>* out_positions;
+    List<vec4>* out_colors;
+};
+
+/// @brief: Emits an input vertex the clipper keeps, once, and returns its output index.
+auto inline push_kept_vertex(ClipVertices& vertices, i32 in_index, Array<i32>& remap) -> i32 {
+    if (remap[in_index] < 0) {
+        remap[in_index] = vertices.out_positions->count();
+        vertices.out_positions->push(vertices.in_positions[in_index]);
+        if (vertices.in_colors.count() > 0) {
+            vertices.out_colors->push(vertices.in_colors[in_index]);
+        }
+    }
+    return remap[in_index];
+}
+
+struct ClipEdge {
+    i32 in_high;
+    i32 out_index;
+    i32 next; // -1 ends the list
+};
+
+// The intersections one pass made, listed by the lower input vertex of their edge
+struct ClipEdges {
+    Array<i32> first;
+    List<ClipEdge> edges;
+};
+
+/// @brief: Emits where the edge between in_a and in_b crosses the plane, once per edge, and returns its output index.
+/// Always lerped from the lower index, so both triangles of an edge see the same vertex whichever way they walk it.
+auto inline push_intersection_vertex(ClipVertices& vertices, ClipEdges& edges, i32 in_a, f32 d_a, i32 in_b, f32 d_b)
+    -> i32 {
+    i32 low = in_a < in_b ? in_a : in_b;
+    i32 high = in_a < in_b ? in_b : in_a;
+    for (i32 i = edges.first[low]; i >= 0; i = edges.edges[i].next) {
+        if (edges.edges[i].in_high == high) {
+            return edges.edges[i].out_index;
+        }
+    }
+
+    f32 d_low = in_a < in_b ? d_a : d_b;
+    f32 d_high = in_a < in_b ? d_b : d_a;
+    f32 t = -(d_low) / (d_high - d_low);
+    i32 result = vertices.out_positions->count();
+    vertices.out_positions->push(lerp(vertices.in_positions[low], t, vertices.in_positions[high]));
+    if (vertices.in_colors.count() > 0) {
+        vertices.out_colors->push(lerp(vertices.in_colors[low], t, vertices.in_colors[high]));
+    }
+    edges.edges.push({ high, result, edges.first[low] });
+    edges.first[low] = edges.edges.count() - 1;
+    return result;
+}
+
+/// @brief: Upper bound of the vertices one clip_triangle_against_plane2 pass writes. Every triangle keeps or makes at
+/// most 4, and it only makes 2. Edges shared by two triangles only make one, which the bound does not count on.
+auto inline clip_pass_max_vertex_count(u64 in_vertex_count, u64 in_triangle_count) -> u64 {
+    u64 kept_and_made_count = in_vertex_count + 2 * in_triangle_count;
+    return 4 * in_triangle_count < kept_and_made_count ? 4 * in_triangle_count : kept_and_made_count;
+}
+
+/// @brief: Clips against the plane v[plane_index] = -plane_direction * w_scale * w. A w_scale of 1 is the view.
+/// Input vertices that are kept, and the intersections on the edges triangles share, are written once and shared by
+/// the triangles using them. Writes at most 2 triangles per input triangle, and clip_pass_max_vertex_count vertices.
+/// These bounds are per pass, they compound over the passes of clip_triangles_against_guard_band.
 auto inline clip_triangle_against_plane2(                 //
-    Array<vec4> in_vertices, Array<ivec3> in_indices,     //
-    List<vec4>& out_vertices, List<ivec3>& out_indices,   //
+    ClipVertices& vertices,                               //
+    Array<ivec3> in_indices, List<ivec3>& out_indices,    //
     PlaneIdx plane_index, PlaneDirection plane_direction, //
-    MemoryArena& arena) {
+    f32 w_scale, MemoryArena& arena) {
     Assert(plane_index >= 0 && plane_index < PlaneIdx_Count);
     Assert(plane_direction == 1 || plane_direction == -1);
+    Assert(vertices.in_colors.count() == 0 || vertices.in_colors.count() == vertices.in_positions.count());
+
+    // Output index of each input vertex, -1 until it is kept
+    auto remap = Array<i32>::create(vertices.in_positions.count(), arena);
+    for (i32& index : remap) {
+        index = -1;
+    }
+    // Each triangle crosses the plane on at most 2 edges
+    ClipEdges edges = { Array<i32>::create(vertices.in_positions.count(), arena),
+        List<ClipEdge>::create(2 * in_indices.count(), arena) };
+    for (i32& index : edges.first) {
+        index = -1;
+    }
 
     f32 dir = (f32)plane_direction;
+    f32 plane_w = dir * w_scale;
     for (auto triangle_indices : in_indices) {
-        vec4 v0 = in_vertices[triangle_indices.x];
-        vec4 v1 = in_vertices[triangle_indices.y];
-        vec4 v2 = in_vertices[triangle_indices.z];
+        vec4 v0 = vertices.in_positions[triangle_indices.x];
+        vec4 v1 = vertices.in_positions[triangle_indices.y];
+        vec4 v2 = vertices.in_positions[triangle_indices.z];
 
         const i32 Edge_Count = 3;
         f32 ds[Edge_Count] = {
-            v0.v[plane_index] + (dir * v0.w),
-            v1.v[plane_index] + (dir * v1.w),
-            v2.v[plane_index] + (dir * v2.w),
+            v0.v[plane_index] + (plane_w * v0.w),
+            v1.v[plane_index] + (plane_w * v1.w),
+            v2.v[plane_index] + (plane_w * v2.w),
         };
-        vec4 v[Edge_Count] = { v0, v1, v2 };
 
         i32 out_count = 0;
         i32 in_count = 0;
@@ -557,224 +1543,452 @@ auto inline clip_triangle_against_plane2(                 //
         }
 
         if (out_count == 0) {
-            // TODO: We create more vertexes than neccessary here.
-            i32 start_idx = out_vertices.count();
-            ivec3 indices = { start_idx, start_idx + 1, start_idx + 2 };
+            ivec3 indices = {
+                push_kept_vertex(vertices, triangle_indices.x, remap), //
+                push_kept_vertex(vertices, triangle_indices.y, remap), //
+                push_kept_vertex(vertices, triangle_indices.z, remap)  //
+            };
             out_indices.push(indices);
-            out_vertices.push(v0);
-            out_vertices.push(v1);
-            out_vertices.push(v2);
         }
         else if (out_count == 1) {
             i32 a_idx = out_idx[0];
             i32 b_idx = (a_idx + 1) % Edge_Count;
             i32 c_idx = (a_idx + 2) % Edge_Count;
-            vec4 a = v[a_idx];
-            vec4 b = v[b_idx];
-            vec4 c = v[c_idx];
-
-            // ab
-            vec4 ab = {};
-            {
-                f32 d_a = ds[a_idx];
-                f32 d_b = ds[b_idx];
-                f32 t = -(d_a) / (d_b - d_a);
-                ab = lerp(a, t, b);
-            }
-            vec4 ac = {};
-            {
-                f32 d_a = ds[a_idx];
-                f32 d_c = ds[c_idx];
-                f32 t = -(d_a) / (d_c - d_a);
-                ac = lerp(a, t, c);
-            }
+            i32 a = triangle_indices.v[a_idx];
+            i32 b = triangle_indices.v[b_idx];
+            i32 c = triangle_indices.v[c_idx];
 
-            i32 start_idx = out_vertices.count();
-            out_vertices.push(ab);
-            out_vertices.push(b);
-            out_vertices.push(c);
-            out_vertices.push(ac);
+            i32 b_out_idx = push_kept_vertex(vertices, b, remap);
+            i32 c_out_idx = push_kept_vertex(vertices, c, remap);
+            i32 ab_out_idx = push_intersection_vertex(vertices, edges, a, ds[a_idx], b, ds[b_idx]);
+            i32 ac_out_idx = push_intersection_vertex(vertices, edges, a, ds[a_idx], c, ds[c_idx]);
 
-            ivec3 ab_b_c_indices = {
-                start_idx,     //
-                start_idx + 1, //
-                start_idx + 2  //
-            };
-            ivec3 ac_ab_c_indices = {
-                start_idx + 3, //
-                start_idx + 0, //
-                start_idx + 2  //
-            };
             // ab -> b -> c;
-            out_indices.push(ab_b_c_indices);
-            // // ac -> ab -> c;
-            out_indices.push(ac_ab_c_indices);
+            out_indices.push({ ab_out_idx, b_out_idx, c_out_idx });
+            // ac -> ab -> c;
+            out_indices.push({ ac_out_idx, ab_out_idx, c_out_idx });
         }
         else if (out_count == 2) {
             i32 a_idx = in_idx[0];
             i32 b_idx = (a_idx + 1) % Edge_Count;
             i32 c_idx = (a_idx + 2) % Edge_Count;
+            i32 a = triangle_indices.v[a_idx];
+            i32 b = triangle_indices.v[b_idx];
+            i32 c = triangle_indices.v[c_idx];
 
-            vec4 a = v[a_idx];
-            vec4 b = v[b_idx];
-            vec4 c = v[c_idx];
-
-            vec4 b_new;
-            // b'
-            {
-                f32 d_a = ds[a_idx];
-                f32 d_b = ds[b_idx];
-                f32 t = -(d_a) / (d_b - d_a);
-                b_new = lerp(a, t, b);
-            }
-            vec4 c_new;
-            {
-                f32 d_a = ds[a_idx];
-                f32 d_c = ds[c_idx];
-                f32 t = -(d_a) / (d_c - d_a);
-                c_new = lerp(a, t, c);
-            }
-
-            i32 start_idx = out_vertices.count();
-            out_vertices.push(a);
-            out_vertices.push(b_new);
-            out_vertices.push(c_new);
+            i32 a_out_idx = push_kept_vertex(vertices, a, remap);
+            i32 b_new_out_idx = push_intersection_vertex(vertices, edges, a, ds[a_idx], b, ds[b_idx]);
+            i32 c_new_out_idx = push_intersection_vertex(vertices, edges, a, ds[a_idx], c, ds[c_idx]);
 
-            ivec3 a_bNew_cNew_indices = {
-                start_idx,     //
-                start_idx + 1, //
-                start_idx + 2  //
-            };
-            out_indices.push(a_bNew_cNew_indices);
+            out_indices.push({ a_out_idx, b_new_out_idx, c_new_out_idx });
         }
         else if (out_count == 3) {
         }
     }
 }
 
-auto inline clip_triangles_against_all_planes(          //
-    Array<vec4> in_vertices, Array<ivec3> in_indices,   //
-    List<vec4>& out_vertices, List<ivec3>& out_indices, //
-    MemoryArena& arena) {
+struct ClipPlane {
+    PlaneIdx index;
+    PlaneDirection direction;
+    f32 w_scale;
+    ClipCode clip_code;
+};
 
-    auto temp_vertices = List<vec4>::create(out_vertices.max_count(), arena);
-    auto temp_indices = List<ivec3>::create(out_indices.max_count(), arena);
+// The near and far planes first, they remove the most
+const ClipPlane GuardBandClipPlanes[] = {
+    { PlaneIdx_Z, PlaneDirection_Forward, 1.0f, ClipCode_NegativeZ },
+    { PlaneIdx_Z, PlaneDirection_Backwards, 1.0f, ClipCode_PositiveZ },
+    { PlaneIdx_X, PlaneDirection_Forward, GuardBandScale, ClipCode_GuardBandX },
+    { PlaneIdx_X, PlaneDirection_Backwards, GuardBandScale, ClipCode_GuardBandX },
+    { PlaneIdx_Y, PlaneDirection_Forward, GuardBandScale, ClipCode_GuardBandY },
+    { PlaneIdx_Y, PlaneDirection_Backwards, GuardBandScale, ClipCode_GuardBandY },
+};
 
-    {
-        clip_triangle_against_plane2(           //
-            in_vertices, in_indices,            //
-            temp_vertices, temp_indices,        //
-            PlaneIdx_X, PlaneDirection_Forward, //
-            arena                               //
-        );
-        out_vertices.clear();
-        out_indices.clear();
-        clip_triangle_against_plane2(                          //
-            temp_vertices.to_array(), temp_indices.to_array(), //
-            out_vertices, out_indices,                         //
-            PlaneIdx_X, PlaneDirection_Backwards,              //
-            arena                                              //
+struct ClippedTriangles {
+    Array<vec4> vertices;
+    // Lerped along with the vertices, empty if none were given
+    Array<vec4> colors;
+    Array<ivec3> triangles;
+};
+
+/// @brief: Clips against the near and far planes and the guard band, skipping the planes not in clip_codes.
+/// Each pass allocates for the worst case of what it is given, so the total depends on how much is split.
+auto inline clip_triangles_against_guard_band(                                  //
+    Array<vec4> in_vertices, Array<vec4> in_colors, Array<ivec3> in_indices, //
+    u8 clip_codes, MemoryArena& arena) -> ClippedTriangles {
+    ClippedTriangles result = { in_vertices, in_colors, in_indices };
+    bool has_colors = in_colors.count() > 0;
+    for (auto& plane : GuardBandClipPlanes) {
+        if (!(clip_codes & plane.clip_code) || result.triangles.count() == 0) {
+            continue;
+        }
+        u64 max_vertex_count = clip_pass_max_vertex_count(result.vertices.count(), result.triangles.count());
+        auto out_vertices = List<vec4>::create(max_vertex_count, arena);
+        auto out_colors = List<vec4>::create(has_colors ? max_vertex_count : 0, arena);
+        auto out_indices = List<ivec3>::create(result.triangles.count() * 2, arena);
+        ClipVertices vertices = { result.vertices, result.colors, &out_vertices, &out_colors };
+        clip_triangle_against_plane2(                  //
+            vertices,                                  //
+            result.triangles, out_indices,             //
+            plane.index, plane.direction,              //
+            plane.w_scale, arena                       //
         );
+        result.vertices = out_vertices.to_array();
+        result.colors = out_colors.to_array();
+        result.triangles = out_indices.to_array();
     }
+    return result;
+}
 
-    {
+// Covers the sentinel and the alignment padding of one allocation.
+const u64 MeshArenaAllocationOverhead = 64;
+
+/// @brief: Upper bound of what clip_triangles_against_guard_band allocates for the given input. Replays the passes
+/// with the worst case of each: every pass can cut each triangle it is given in two, and the passes compound, the
+/// triangles are cut one by one and not as a polygon. One triangle can leave the six passes as 64.
+auto inline clip_triangles_against_guard_band_arena_size(u64 vertex_count, u64 triangle_count, bool has_colors)
+    -> u64 {
+    u64 vertex_size = has_colors ? 2 * sizeof(vec4) : sizeof(vec4);
+    u64 result = 0;
+    for (u32 i = 0; i < ArrayCount(GuardBandClipPlanes); i++) {
+        result += vertex_count * 2 * sizeof(i32)                                 // remap + edge lists
+            + triangle_count * 2 * (sizeof(ClipEdge) + sizeof(ivec3))           // edges + triangles
+            + clip_pass_max_vertex_count(vertex_count, triangle_count) * vertex_size // vertices + colors
+            + 6 * MeshArenaAllocationOverhead;
+        vertex_count = clip_pass_max_vertex_count(vertex_count, triangle_count);
+        triangle_count *= 2;
+    }
+    return result;
+}
 
-        temp_vertices.clear();
-        temp_indices.clear();
-        clip_triangle_against_plane2(                        //
-            out_vertices.to_array(), out_indices.to_array(), //
-            temp_vertices, temp_indices,                     //
-            PlaneIdx_Y, PlaneDirection_Forward,              //
-            arena                                            //
-        );
-        out_vertices.clear();
-        out_indices.clear();
-        clip_triangle_against_plane2(                          //
-            temp_vertices.to_array(), temp_indices.to_array(), //
-            out_vertices, out_indices,                         //
-            PlaneIdx_Y, PlaneDirection_Backwards,              //
-            arena                                              //
-        );
+// Output of the geometry stage: one instance transformed, culled, clipped and projected.
+// Vertices are in screen space with z = 1/w. Read-only for the tile rasterizers.
+struct ScreenMesh {
+    Array<vec3> vertices;
+    Array<ivec3> triangles;
+    Array<vec4> colors; // One per triangle
+    // Lit meshes only, three per triangle in the order of its vertices. sRGB, ready to be interpolated.
+    Array<vec4> corner_colors;
+    Rectangle2i bounds; // Union of all triangles, clipped to the buffer
+};
+
+/// @brief: The surface color lit by light, clamped, back in sRGB.
+auto inline shade_color(vec4 color_l1, f32 light_r, f32 light_g, f32 light_b) -> vec4 {
+    vec4 result;
+    result.r = (f32)linear1_to_srgb255_lookup(clamp(color_l1.r * light_r, 0.0f, 1.0f)) / 255.0f;
+    result.g = (f32)linear1_to_srgb255_lookup(clamp(color_l1.g * light_g, 0.0f, 1.0f)) / 255.0f;
+    result.b = (f32)linear1_to_srgb255_lookup(clamp(color_l1.b * light_b, 0.0f, 1.0f)) / 255.0f;
+    result.a = color_l1.a;
+    return result;
+}
+
+// First half of the geometry stage: the instance culled, transformed, lit and projected. The triangles crossing the
+// guard band, or the near or far plane, are set aside in clip space for clip_mesh_instance.
+struct ProjectedMeshInstance {
+    ProjectedVertices vertices;
+    u32 vertex_count;
+    bool is_lit;
+    VertexLight vertex_light; // Lit meshes only
+    Array<u8> is_vertex_used;
+    Array<ivec3> unclipped_triangles;
+    Array<vec4> clip_vertices;
+    Array<vec4> clip_colors; // The light of the clip vertices, lit meshes only
+    Array<ivec3> clip_triangles;
+    u8 clip_codes; // Union of the planes the clip triangles cross
+};
+
+/// @brief: Upper bound of what project_mesh_instance allocates.
+auto inline project_mesh_instance_arena_size(u64 vertex_count, u64 triangle_count, const MeshLights* lights) -> u64 {
+    u64 padded_vertex_count = vertex_batch_padded_count((u32)vertex_count);
+    u64 result = 2 * triangle_count * sizeof(ivec3)            // culled + unclipped triangles
+        + padded_vertex_count * (3 * sizeof(f32) + sizeof(u8)) // projected vertices
+        + padded_vertex_count * sizeof(u8)                     // used vertices, padded to keep the size a multiple of 4
+        + vertex_count * (sizeof(vec4) + sizeof(i32))          // clipper input vertices + their index
+        + triangle_count * sizeof(ivec3)                       // clipper input triangles
+        + 12 * MeshArenaAllocationOverhead;
+    if (lights) {
+        result += lights->directional.count() * sizeof(DirectionalLight) // model space lights
+            + lights->point.count() * sizeof(PointLight)                 //
+            + padded_vertex_count * 3 * sizeof(f32)                      // vertex light
+            + vertex_count * sizeof(vec4)                                // clipper input colors
+            + 5 * MeshArenaAllocationOverhead;
     }
+    return result;
+}
 
-    {
+/// @brief: Upper bound of what clip_mesh_instance allocates for this instance. Sized from what the first half
+/// actually set aside, most instances have nothing to clip and only need the screen mesh.
+auto inline clip_mesh_instance_arena_size(const ProjectedMeshInstance& projected) -> u64 {
+    u64 clip_vertex_count = projected.clip_vertices.count();
+    u64 clip_triangle_count = projected.clip_triangles.count();
+    u64 result = clip_triangles_against_guard_band_arena_size(clip_vertex_count, clip_triangle_count, projected.is_lit);
+
+    // What the clipper can return, pass by pass like it allocates. Skipping a pass never makes more.
+    u64 max_vertex_count = clip_vertex_count;
+    u64 max_triangle_count = clip_triangle_count;
+    for (u32 i = 0; i < ArrayCount(GuardBandClipPlanes); i++) {
+        max_vertex_count = clip_pass_max_vertex_count(max_vertex_count, max_triangle_count);
+        max_triangle_count *= 2;
+    }
+    max_triangle_count += projected.unclipped_triangles.count();
+    result += (projected.vertex_count + max_vertex_count) * sizeof(vec3) // screen vertices
+        + max_triangle_count * (sizeof(ivec3) + sizeof(vec4))            // screen triangles + colors
+        + 4 * MeshArenaAllocationOverhead;
+    if (projected.is_lit) {
+        result += max_triangle_count * 3 * sizeof(vec4); // corner colors
+    }
+    return result;
+}
 
-        temp_vertices.clear();
-        temp_indices.clear();
-        clip_triangle_against_plane2(                        //
-            out_vertices.to_array(), out_indices.to_array(), //
-            temp_vertices, temp_indices,                     //
-            PlaneIdx_Z, PlaneDirection_Forward,              //
-            arena                                            //
-        );
-        out_vertices.clear();
-        out_indices.clear();
-        clip_triangle_against_plane2(                          //
-            temp_vertices.to_array(), temp_indices.to_array(), //
-            out_vertices, out_indices,                         //
-            PlaneIdx_Z, PlaneDirection_Backwards,              //
-            arena                                              //
-        );
+auto inline include_in_screen_bounds(Rectangle2i* bounds, vec3 P, i32 width, i32 height) -> void {
+    bounds->min_x = hm::min(bounds->min_x, hm::max((i32)floorf(P.x) - 1, 0));
+    bounds->min_y = hm::min(bounds->min_y, hm::max((i32)floorf(P.y) - 1, 0));
+    bounds->max_x = hm::max(bounds->max_x, hm::min((i32)ceilf(P.x) + 2, width));
+    bounds->max_y = hm::max(bounds->max_y, hm::min((i32)ceilf(P.y) + 2, height));
+}
+
+auto inline project_mesh_instance(            //
+    const TriMesh& model,                     //
+    const MeshInstance& instance,             //
+    const mat4& world_to_view,                //
+    const mat4& view_to_clip,                 //
+    const vec4& camera_direction,             //
+    const MeshLights* lights,                 // Null for flat colors
+    i32 width, i32 height, MemoryArena& arena //
+    ) -> ProjectedMeshInstance {
+    const VertexPositions& positions = model.positions;
+    u32 vertex_count = model.vertex_count;
+    Array<ivec3> indices = model.triangles;
+    Array<vec3> normals = model.normals;
+    mat4 M_to_W = instance.transform.to_mat4();
+    mat4 M_to_C = M_to_W * world_to_view;
+    mat4 M_to_Clip = M_to_C * view_to_clip;
+
+    // Nothing of an instance outside of the view is projected, clip_mesh_instance makes an empty mesh of it
+    ProjectedMeshInstance result = {};
+    FrustumTest frustum_test = test_bounds_against_frustum(model.bounds, M_to_Clip);
+    if (frustum_test == FrustumTest_Outside) {
+        return result;
+    }
+
+    mat4 W_to_M = inverse(M_to_W);
+    vec4 cam_pos_M = camera_direction * W_to_M;
+
+    auto not_culled_indices = List<ivec3>::create(indices.count(), arena);
+    for (u32 i = 0; i < normals.count(); i++) {
+        const ivec3 triangle = indices[i];
+        const vec4 a = get_vertex_position(positions, triangle.a);
+        const vec3 cam_direction_M = (a - cam_pos_M).xyz();
+        if (dot(cam_direction_M, normals[i]) < 0) {
+            not_culled_indices.push(indices[i]);
+        }
     }
 
-    temp_vertices.clear();
-    temp_indices.clear();
+    result.vertex_count = vertex_count;
+    result.vertices = create_projected_vertices(vertex_count, arena);
+    transform_vertices(positions, vertex_count, M_to_Clip, width, height, &result.vertices);
+
+    // Lit per vertex, the rasterizer only interpolates
+    if (lights) {
+        MeshLights lights_M = transform_lights_to_model(*lights, W_to_M, arena);
+        result.is_lit = true;
+        result.vertex_light = create_vertex_light(vertex_count, arena);
+        light_vertices(positions, model.vertex_normals, vertex_count, lights_M, &result.vertex_light);
+    }
+
+    // Triangles inside the guard band keep the projected vertices and are scissored by the rasterizer. Only the ones
+    // crossing it, or the near or far plane, go through the clipper.
+    auto unclipped_indices = List<ivec3>::create(not_culled_indices.count(), arena);
+    result.is_vertex_used = Array<u8>::create(vertex_count, arena);
+    // Model vertices go to the clipper once, however many of the clipped triangles share them
+    auto clip_vertex_index = Array<i32>::create(vertex_count, arena);
+    for (i32& index : clip_vertex_index) {
+        index = -1;
+    }
+    i32 max_clip_vertex_count = hm::min((i32)vertex_count, not_culled_indices.count() * 3);
+    auto clip_vertices = List<vec4>::create(max_clip_vertex_count, arena);
+    auto clip_colors = List<vec4>::create(lights ? max_clip_vertex_count : 0, arena);
+    auto clip_indices = List<ivec3>::create(not_culled_indices.count(), arena);
+    for (i32 i = 0; i < not_culled_indices.count(); i++) {
+        ivec3 triangle = not_culled_indices[i];
+        if (frustum_test == FrustumTest_Inside) {
+            unclipped_indices.push(triangle);
+            result.is_vertex_used[triangle.x] = 1;
+            result.is_vertex_used[triangle.y] = 1;
+            result.is_vertex_used[triangle.z] = 1;
+            continue;
+        }
+        u8 code_a = result.vertices.clip_codes[triangle.x];
+        u8 code_b = result.vertices.clip_codes[triangle.y];
+        u8 code_c = result.vertices.clip_codes[triangle.z];
+        if (code_a & code_b & code_c & ClipCodes_View) {
+            // Outside of one plane entirely
+            continue;
+        }
+        u8 crossed_planes = (code_a | code_b | code_c) & ClipCodes_GuardBand;
+        if (crossed_planes == 0) {
+            unclipped_indices.push(triangle);
+            result.is_vertex_used[triangle.x] = 1;
+            result.is_vertex_used[triangle.y] = 1;
+            result.is_vertex_used[triangle.z] = 1;
+            continue;
+        }
+        ivec3 clip_triangle;
+        for (i32 j = 0; j < 3; j++) {
+            i32 vertex_idx = triangle.v[j];
+            if (clip_vertex_index[vertex_idx] < 0) {
+                clip_vertex_index[vertex_idx] = clip_vertices.count();
+                clip_vertices.push(get_vertex_position(positions, vertex_idx) * M_to_Clip);
+                if (lights) {
+                    clip_colors.push(vec4(result.vertex_light.r[vertex_idx], result.vertex_light.g[vertex_idx],
+                        result.vertex_light.b[vertex_idx], 0.0f));
+                }
+            }
+            clip_triangle.v[j] = clip_vertex_index[vertex_idx];
+        }
+        clip_indices.push(clip_triangle);
+        result.clip_codes |= crossed_planes;
+    }
+    result.unclipped_triangles = unclipped_indices.to_array();
+    result.clip_vertices = clip_vertices.to_array();
+    result.clip_colors = clip_colors.to_array();
+    result.clip_triangles = clip_indices.to_array();
+    return result;
+}
+
+/// @brief: Second half of the geometry stage: clips what project_mesh_instance set aside and assembles the
+/// screen mesh, the projected vertices first, then the ones the clipper made.
+auto inline clip_mesh_instance(const ProjectedMeshInstance& projected, const MeshInstance& instance, //
+    i32 width, i32 height, MemoryArena& arena) -> ScreenMesh {
+    ClippedTriangles clipped = {};
+    if (projected.clip_triangles.count() > 0) {
+        clipped = clip_triangles_against_guard_band(projected.clip_vertices, projected.clip_colors,
+            projected.clip_triangles, projected.clip_codes, arena);
+    }
+
+    ScreenMesh result = {};
+    result.bounds = { .min_x = width, .max_x = 0, .min_y = height, .max_y = 0 };
+    i32 projected_count = (i32)projected.vertex_count;
+    result.vertices = Array<vec3>::create(projected_count + clipped.vertices.count(), arena);
+    for (i32 i = 0; i < projected_count; i++) {
+        vec3 P = { projected.vertices.x[i], projected.vertices.y[i], projected.vertices.inv_w[i] };
+        result.vertices[i] = P;
+        if (projected.is_vertex_used[i]) {
+            include_in_screen_bounds(&result.bounds, P, width, height);
+        }
+    }
+    for (u32 i = 0; i < clipped.vertices.count(); i++) {
+        vec3 P = project_vertex(clipped.vertices[i], width, height);
+        result.vertices[projected_count + i] = P;
+        include_in_screen_bounds(&result.bounds, P, width, height);
+    }
+
+    u32 unclipped_count = (u32)projected.unclipped_triangles.count();
+    result.triangles = Array<ivec3>::create(unclipped_count + clipped.triangles.count(), arena);
+    for (u32 i = 0; i < unclipped_count; i++) {
+        result.triangles[i] = projected.unclipped_triangles[i];
+    }
+    for (u32 i = 0; i < clipped.triangles.count(); i++) {
+        ivec3 triangle = clipped.triangles[i];
+        result.triangles[unclipped_count + i] = { projected_count + triangle.x, projected_count + triangle.y,
+            projected_count + triangle.z };
+    }
+
+    result.colors = Array<vec4>::create(result.triangles.count(), arena);
+    for (u32 i = 0; i < result.triangles.count(); i++) {
+        result.colors[i] = instance.colors[i % instance.colors.count()];
+    }
+
+    if (projected.is_lit) {
+        const VertexLight& vertex_light = projected.vertex_light;
+        result.corner_colors = Array<vec4>::create(result.triangles.count() * 3, arena);
+        for (u32 i = 0; i < result.triangles.count(); i++) {
+            vec4 color_l1 = srgb_to_linear1(result.colors[i]);
+            for (i32 j = 0; j < 3; j++) {
+                i32 vertex_idx = result.triangles[i].v[j];
+                vec4 corner_color;
+                if (vertex_idx < projected_count) {
+                    corner_color = shade_color(color_l1, vertex_light.r[vertex_idx], vertex_light.g[vertex_idx],
+                        vertex_light.b[vertex_idx]);
+                }
+                else {
+                    vec4 light = clipped.colors[vertex_idx - projected_count];
+                    corner_color = shade_color(color_l1, light.r, light.g, light.b);
+                }
+                result.corner_colors[3 * i + j] = corner_color;
+            }
+        }
+    }
+    return result;
+}
+
+/// @brief: Both halves of the geometry stage out of one arena, for callers that do not size it up front.
+auto inline transform_mesh_instance(          //
+    const TriMesh& model,                     //
+    const MeshInstance& instance,             //
+    const mat4& world_to_view,                //
+    const mat4& view_to_clip,                 //
+    const vec4& camera_direction,             //
+    const MeshLights* lights,                 // Null for flat colors
+    i32 width, i32 height, MemoryArena& arena //
+    ) -> ScreenMesh {
+    ProjectedMeshInstance projected = project_mesh_instance(model, instance, world_to_view, view_to_clip,
+        camera_direction, lights, width, height, arena);
+    return clip_mesh_instance(projected, instance, width, height, arena);
+}
+
+/// @brief: Raster stage. Only reads the mesh, so every tile can share the same ScreenMesh.
+auto inline render_screen_mesh(const ScreenMesh& mesh, bool is_wireframe, Rectangle2i clip_rect, Framebuffer& buffer,
+    MemoryArena& arena) -> void {
+    if (mesh.bounds.max_x <= clip_rect.min_x || mesh.bounds.min_x >= clip_rect.max_x || //
+        mesh.bounds.max_y <= clip_rect.min_y || mesh.bounds.min_y >= clip_rect.max_y) {
+        return;
+    }
+
+    for (u32 i = 0; i < mesh.triangles.count(); i++) {
+        ivec3 index = mesh.triangles[i];
+        vec3 a = mesh.vertices[index.x];
+        vec3 b = mesh.vertices[index.y];
+        vec3 c = mesh.vertices[index.z];
+
+        // Trivially reject triangles that do not touch this tile
+        f32 min_x = hm::min(a.x, b.x, c.x);
+        f32 max_x = hm::max(a.x, b.x, c.x);
+        f32 min_y = hm::min(a.y, b.y, c.y);
+        f32 max_y = hm::max(a.y, b.y, c.y);
+        if (max_x < (f32)clip_rect.min_x - 1.0f || min_x > (f32)clip_rect.max_x || //
+            max_y < (f32)clip_rect.min_y - 1.0f || min_y > (f32)clip_rect.max_y) {
+            continue;
+        }
+
+        if (is_wireframe) {
+            render_triangle_writeframe_gambetta(a, b, c, mesh.colors[i], clip_rect, buffer, arena);
+        }
+        else if (mesh.corner_colors.count() > 0) {
+            const vec4* colors = &mesh.corner_colors[3 * i];
+            render_triangle_shaded(a, b, c, colors[0], colors[1], colors[2], clip_rect, buffer, arena);
+        }
+        else {
+            render_triangle_filled(a, b, c, mesh.colors[i], clip_rect, buffer, arena);
+        }
+    }
 }
 
 auto inline render_mesh_gambetta(                                    //
-    Array<vec4> vertices, Array<ivec3> indices, Array<vec3> normals, //
+    const TriMesh& model,                                            //
     Array<MeshInstance> instances,                                   //
     const mat4& world_to_view,                                       //
     const mat4& view_to_clip,                                        //
     const vec4& camera_direction,                                    //
+    const MeshLights* lights,                                        //
     bool is_wireframe,                                               //
     Rectangle2i clip_rect, Framebuffer& buffer, MemoryArena& arena   //
     ) -> void {
     for (const auto& instance : instances) {
-        mat4 M_to_W = instance.transform.to_mat4();
-        mat4 W_to_M = inverse(M_to_W);
-        vec4 cam_pos_M = camera_direction * W_to_M;
-
-        auto not_culled_indices = List<ivec3>::create(indices.count(), arena);
-        for (u32 i = 0; i < normals.count(); i++) {
-            const ivec3 triangle = indices[i];
-            const vec4 a = vertices[triangle.a];
-            const vec3 cam_direction_M = (a - cam_pos_M).xyz();
-            if (dot(cam_direction_M, normals[i]) < 0) {
-                not_culled_indices.push(indices[i]);
-            }
-        }
-        auto clip_space_vertices = Array<vec4>::create(vertices.count(), arena);
-
-        mat4 M_to_C = M_to_W * world_to_view;
-        mat4 M_to_Clip = M_to_C * view_to_clip;
-        for (u32 i = 0; i < vertices.count(); i++) {
-            clip_space_vertices[i] = vertices[i] * M_to_Clip;
-        }
-
-        auto clipped_vertices = List<vec4>::create(vertices.count() * 100, arena);
-        auto clipped_indices = List<ivec3>::create(not_culled_indices.count() * 100, arena);
-        clip_triangles_against_all_planes(
-            clip_space_vertices, not_culled_indices.to_array(), clipped_vertices, clipped_indices, arena);
-
-        auto projected_vertices = Array<vec3>::create(clipped_vertices.count(), arena);
-        for (i32 i = 0; i < clipped_vertices.count(); i++) {
-            projected_vertices[i] = project_vertex(clipped_vertices[i], buffer.width, buffer.height);
-        }
-
-        for (i32 i = 0; i < clipped_indices.count(); i++) {
-            ivec3 index = clipped_indices[i];
-            vec3 a = projected_vertices[index.x];
-            vec3 b = projected_vertices[index.y];
-            vec3 c = projected_vertices[index.z];
-            if (is_wireframe) {
-                render_triangle_writeframe_gambetta( //
-                    a, b, c, instance.colors[i % instance.colors.count()], clip_rect, buffer, arena);
-            }
-            else {
-                render_triangle_filled_gambetta( //
-                    a, b, c, instance.colors[i % instance.colors.count()], clip_rect, buffer, arena);
-            }
-        }
+        ScreenMesh mesh = transform_mesh_instance(         //
+            model, instance,                               //
+            world_to_view, view_to_clip, camera_direction, //
+            lights, buffer.width, buffer.height, arena);
+        render_screen_mesh(mesh, is_wireframe, clip_rect, buffer, arena);
     }
 }
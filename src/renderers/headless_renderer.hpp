@@ -0,0 +1,24 @@
+#pragma once
+
+#include <renderers/renderer.hpp>
+
+// Passed as the context of init and end_frame. Can be null, then nothing is written to disk.
+struct HeadlessRenderContext {
+    // When set, frames are written to <dump_directory>/frame_<frame index>.png
+    const char* dump_directory;
+    // Only every n-th frame is written. 0 and 1 write every frame.
+    u32 dump_interval;
+};
+
+static const char* headless_renderer_exports[] = {
+    "headless_renderer_init",
+    "headless_renderer_add_texture",
+    "headless_renderer_render",
+    "headless_renderer_begin_frame",
+    "headless_renderer_end_frame",
+    "headless_renderer_delete_context",
+    "headless_renderer_create_framebuffer",
+    "headless_renderer_apply_framebuffer",
+    "headless_renderer_get_color",
+    "headless_renderer_set_pipelined",
+};
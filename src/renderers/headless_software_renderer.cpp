@@ -0,0 +1,140 @@
+// Software renderer without a window. Renders into memory with the same tile/job model as
+// win32_software_renderer.cpp, and optionally writes the frames to disk. Used to measure and
+// regression test the renderer on Linux.
+#include <sys/mman.h>
+
+#include <platform/platform.hpp>
+#include <renderers/headless_renderer.hpp>
+
+#include "software_renderer.cpp"
+
+#include "../third-party/stb_image_write.cpp"
+
+#define HEADLESS_EXPORT extern "C" __attribute__((visibility("default")))
+
+struct HeadlessState {
+    HeadlessRenderContext context;
+    u64 frame_index;
+    // RGBA copy of the platform buffer, only allocated if frames are written
+    u8* dump_pixels;
+};
+
+static HeadlessState headless = {};
+
+// munmap needs the size, so every allocation starts with a page holding its size.
+const u64 PageSize = KiloBytes(4);
+
+internal auto allocate_pages(u64 size) -> void* {
+    u64 total_size = size + PageSize;
+    void* memory = mmap(0, total_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        crash_and_burn("mmap failed to allocate %llu bytes.", (unsigned long long)size);
+    }
+    *(u64*)memory = total_size;
+    return (u8*)memory + PageSize;
+}
+
+internal auto free_pages(void* memory) -> void {
+    u8* base = (u8*)memory - PageSize;
+    munmap(base, *(u64*)base);
+}
+
+/// @brief: Writes the platform buffer to <dump_directory>/frame_<frame_index>.png.
+static auto dump_frame(u64 frame_index) -> void {
+    Framebuffer* buffer = &state.platform_buffer;
+    u32* src = (u32*)buffer->memory;
+    u8* dest = headless.dump_pixels;
+    for (i32 i = 0; i < buffer->width * buffer->height; i++) {
+        // ARGB to RGBA. Alpha is not meaningful in the platform buffer, the window ignores it too.
+        u32 color = *src++;
+        *dest++ = (color >> 16) & 0xFF;
+        *dest++ = (color >> 8) & 0xFF;
+        *dest++ = (color >> 0) & 0xFF;
+        *dest++ = 0xFF;
+    }
+
+    char path[Max_Path_Length * 2];
+    snprintf(path, sizeof(path), "%s/frame_%05llu.png", headless.context.dump_directory, (unsigned long long)frame_index);
+    // Bottom up, like the DIB section on Windows
+    stbi_flip_vertically_on_write(1);
+    if (!stbi_write_png(path, buffer->width, buffer->height, 4, headless.dump_pixels, buffer->width * 4)) {
+        log_error("Failed to write %s", path);
+    }
+}
+
+HEADLESS_EXPORT RENDERER_INIT(headless_renderer_init) {
+    software_renderer_init(platform_api, memory);
+
+    if (context) {
+        headless.context = *(HeadlessRenderContext*)context;
+    }
+    resize_frame_buffer(&state.platform_buffer, CLIENT_WIDTH, CLIENT_HEIGHT);
+    if (headless.context.dump_directory) {
+        headless.dump_pixels = allocate<u8>(state.permanent, state.platform_buffer.memory_size);
+        log_info("Writing frames to %s", headless.context.dump_directory);
+    }
+    log_info("Resolution: %d x %d", CLIENT_WIDTH, CLIENT_HEIGHT);
+}
+
+HEADLESS_EXPORT RENDERER_DELETE_CONTEXT(headless_renderer_delete_context) {
+}
+
+HEADLESS_EXPORT RENDERER_ADD_TEXTURE(headless_renderer_add_texture) {
+    return software_renderer_add_texture(texture_id, data, width, height, bytes_per_pixel, pixel_format);
+}
+
+HEADLESS_EXPORT RENDERER_RENDER(headless_renderer_render) {
+    software_renderer_render(thread_context, is_multithreaded, group, handle);
+}
+
+HEADLESS_EXPORT RENDERER_BEGIN_FRAME(headless_renderer_begin_frame) {
+    software_renderer_begin_frame(context);
+}
+
+HEADLESS_EXPORT RENDERER_END_FRAME(headless_renderer_end_frame) {
+    software_renderer_end_frame();
+
+    u64 frame_index = headless.frame_index++;
+    u32 interval = headless.context.dump_interval > 1 ? headless.context.dump_interval : 1;
+    if (headless.dump_pixels && frame_index % interval == 0) {
+        TIMED_BLOCK("dump_frame");
+        dump_frame(frame_index);
+    }
+}
+
+HEADLESS_EXPORT RENDERER_CREATE_FRAMEBUFFER(headless_renderer_create_framebuffer) {
+    return software_renderer_create_framebuffer(width, height);
+}
+
+HEADLESS_EXPORT RENDERER_APPLY_FRAMEBUFFER(headless_renderer_apply_framebuffer) {
+    software_renderer_apply_framebuffer(thread_context, handle, scale);
+}
+
+HEADLESS_EXPORT RENDERER_GET_COLOR(headless_renderer_get_color) {
+    return software_renderer_get_color(handle, offset_x, offset_y);
+}
+
+HEADLESS_EXPORT RENDERER_SET_PIPELINED(headless_renderer_set_pipelined) {
+    software_renderer_set_pipelined(is_pipelined);
+}
+
+/// @brief: What the frames are composited into, so hosts can inspect or checksum the output.
+HEADLESS_EXPORT auto headless_renderer_get_platform_buffer() -> Framebuffer* {
+    return &state.platform_buffer;
+}
+
+/// @brief: For hosts that link the renderer in statically instead of loading it.
+auto headless_renderer_api() -> RendererApi {
+    RendererApi result = {};
+    result.init = headless_renderer_init;
+    result.add_texture = headless_renderer_add_texture;
+    result.render = headless_renderer_render;
+    result.begin_frame = headless_renderer_begin_frame;
+    result.end_frame = headless_renderer_end_frame;
+    result.delete_context = headless_renderer_delete_context;
+    result.create_framebuffer = headless_renderer_create_framebuffer;
+    result.apply_framebuffer = headless_renderer_apply_framebuffer;
+    result.get_color = headless_renderer_get_color;
+    result.set_pipelined = headless_renderer_set_pipelined;
+    return result;
+}
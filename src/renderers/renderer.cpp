@@ -1,4 +1,8 @@
+#include <cmath>
 #include <cstdio>
+
+#include <core/hash.hpp>
+#include <math/mat2.hpp>
 #include <renderers/renderer.hpp>
 
 auto create_frame_buffer(MemoryArena& arena, i32 width, i32 height) -> Framebuffer {
@@ -10,111 +14,478 @@ auto create_frame_buffer(MemoryArena& arena, i32 width, i32 height) -> Framebuff
     buffer.memory_size = buffer.pitch * buffer.height;
     buffer.memory = arena.allocate(buffer.memory_size);
     buffer.z_buffer = Array<f32>::create((u64)width * height, arena);
+    buffer.z_block_count_x = z_block_count(width);
+    buffer.z_blocks = Array<f32>::create((u64)buffer.z_block_count_x * z_block_count(height), arena);
     return buffer;
 }
 
 auto initialize_renderer_lib() -> void {
     if (cpu_supports_avx512f()) {
         apply_frame_buffer = apply_frame_buffer_AVX512;
+        apply_frame_buffer_stream = apply_frame_buffer_stream_AVX512;
+    }
+    else if (cpu_supports_avx2()) {
+        apply_frame_buffer = apply_frame_buffer_AVX2;
+        apply_frame_buffer_stream = apply_frame_buffer_stream_AVX2;
     }
     else {
         apply_frame_buffer = apply_frame_buffer_scalar;
+        apply_frame_buffer_stream = apply_frame_buffer_scalar;
+    }
+
+    if (cpu_supports_avx2()) {
+        compute_tile_ranges = compute_tile_ranges_AVX2;
+    }
+    else {
+        compute_tile_ranges = compute_tile_ranges_scalar;
+    }
+}
+
+// Conservative pixel bounds: one pixel of padding covers the rounding the draw routines do.
+internal auto rect_from_extents(f32 min_x, f32 min_y, f32 max_x, f32 max_y, i32 width, i32 height) -> Rectangle2i {
+    // Clamped first, full screen and empty commands span the whole f32 range
+    min_x = clamp(min_x, -2.0f, (f32)width + 2.0f);
+    min_y = clamp(min_y, -2.0f, (f32)height + 2.0f);
+    max_x = clamp(max_x, -2.0f, (f32)width + 2.0f);
+    max_y = clamp(max_y, -2.0f, (f32)height + 2.0f);
+
+    Rectangle2i result;
+    result.min_x = hm::max((i32)floorf(min_x) - 1, 0);
+    result.min_y = hm::max((i32)floorf(min_y) - 1, 0);
+    result.max_x = hm::min((i32)ceilf(max_x) + 2, width);
+    result.max_y = hm::min((i32)ceilf(max_y) + 2, height);
+    return result;
+}
+
+auto compute_tile_ranges_scalar(RenderCommandBounds* bounds, i32* command_render_order, i32 command_count, //
+    TileGrid grid, CommandTileRanges* ranges) -> void {
+    for (i32 i = 0; i < command_count; i++) {
+        i32 command = command_render_order[i];
+        Rectangle2i rect = rect_from_extents(                                //
+            bounds->min_x.data()[command], bounds->min_y.data()[command], //
+            bounds->max_x.data()[command], bounds->max_y.data()[command], //
+            grid.width, grid.height);
+        if (rect.min_x >= rect.max_x || rect.min_y >= rect.max_y) {
+            ranges->min_x[i] = 1;
+            ranges->max_x[i] = 0;
+            ranges->min_y[i] = 1;
+            ranges->max_y[i] = 0;
+            continue;
+        }
+        ranges->min_x[i] = rect.min_x / grid.tile_width;
+        ranges->max_x[i] = (rect.max_x - 1) / grid.tile_width;
+        ranges->min_y[i] = rect.min_y / grid.tile_height;
+        ranges->max_y[i] = (rect.max_y - 1) / grid.tile_height;
+    }
+}
+
+internal auto tile_index_v8(__m256i pixel_v8, __m256 tile_dim_v8) -> __m256i {
+    return _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_div_ps(_mm256_cvtepi32_ps(pixel_v8), tile_dim_v8)));
+}
+
+/// @brief: rect_from_extents and the tile division, 8 commands at a time. The pixel coordinates are small
+/// integers, so the f32 division floors to the same tile as the integer one.
+auto compute_tile_ranges_AVX2(RenderCommandBounds* bounds, i32* command_render_order, i32 command_count, //
+    TileGrid grid, CommandTileRanges* ranges) -> void {
+    const __m256i lane_index_v8 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i one_v8 = _mm256_set1_epi32(1);
+    const __m256i two_v8 = _mm256_set1_epi32(2);
+    const __m256i zero_v8 = _mm256_setzero_si256();
+    const __m256i width_v8 = _mm256_set1_epi32(grid.width);
+    const __m256i height_v8 = _mm256_set1_epi32(grid.height);
+    const __m256 low_v8 = _mm256_set1_ps(-2.0f);
+    const __m256 high_x_v8 = _mm256_set1_ps((f32)grid.width + 2.0f);
+    const __m256 high_y_v8 = _mm256_set1_ps((f32)grid.height + 2.0f);
+    const __m256 tile_width_v8 = _mm256_set1_ps((f32)grid.tile_width);
+    const __m256 tile_height_v8 = _mm256_set1_ps((f32)grid.tile_height);
+
+    for (i32 i = 0; i < command_count; i += 8) {
+        __m256i in_range_v8 = _mm256_cmpgt_epi32(_mm256_set1_epi32(command_count - i), lane_index_v8);
+        __m256i command_v8 = _mm256_maskload_epi32(command_render_order + i, in_range_v8);
+        __m256 mask_v8 = _mm256_castsi256_ps(in_range_v8);
+        __m256 min_x_v8 = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), bounds->min_x.data(), command_v8, mask_v8, sizeof(f32));
+        __m256 min_y_v8 = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), bounds->min_y.data(), command_v8, mask_v8, sizeof(f32));
+        __m256 max_x_v8 = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), bounds->max_x.data(), command_v8, mask_v8, sizeof(f32));
+        __m256 max_y_v8 = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), bounds->max_y.data(), command_v8, mask_v8, sizeof(f32));
+
+        min_x_v8 = _mm256_floor_ps(_mm256_min_ps(_mm256_max_ps(min_x_v8, low_v8), high_x_v8));
+        min_y_v8 = _mm256_floor_ps(_mm256_min_ps(_mm256_max_ps(min_y_v8, low_v8), high_y_v8));
+        max_x_v8 = _mm256_ceil_ps(_mm256_min_ps(_mm256_max_ps(max_x_v8, low_v8), high_x_v8));
+        max_y_v8 = _mm256_ceil_ps(_mm256_min_ps(_mm256_max_ps(max_y_v8, low_v8), high_y_v8));
+
+        // Pixel rect
+        __m256i pixel_min_x_v8 = _mm256_max_epi32(_mm256_sub_epi32(_mm256_cvttps_epi32(min_x_v8), one_v8), zero_v8);
+        __m256i pixel_min_y_v8 = _mm256_max_epi32(_mm256_sub_epi32(_mm256_cvttps_epi32(min_y_v8), one_v8), zero_v8);
+        __m256i pixel_max_x_v8 = _mm256_min_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(max_x_v8), two_v8), width_v8);
+        __m256i pixel_max_y_v8 = _mm256_min_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(max_y_v8), two_v8), height_v8);
+        __m256i is_visible_v8 = _mm256_and_si256(               //
+            _mm256_cmpgt_epi32(pixel_max_x_v8, pixel_min_x_v8), //
+            _mm256_cmpgt_epi32(pixel_max_y_v8, pixel_min_y_v8));
+
+        // Tile range, inclusive. Off screen is min > max.
+        __m256i tile_min_x_v8 = tile_index_v8(pixel_min_x_v8, tile_width_v8);
+        __m256i tile_max_x_v8 = tile_index_v8(_mm256_sub_epi32(pixel_max_x_v8, one_v8), tile_width_v8);
+        __m256i tile_min_y_v8 = tile_index_v8(pixel_min_y_v8, tile_height_v8);
+        __m256i tile_max_y_v8 = tile_index_v8(_mm256_sub_epi32(pixel_max_y_v8, one_v8), tile_height_v8);
+        tile_min_x_v8 = _mm256_blendv_epi8(one_v8, tile_min_x_v8, is_visible_v8);
+        tile_max_x_v8 = _mm256_blendv_epi8(zero_v8, tile_max_x_v8, is_visible_v8);
+        tile_min_y_v8 = _mm256_blendv_epi8(one_v8, tile_min_y_v8, is_visible_v8);
+        tile_max_y_v8 = _mm256_blendv_epi8(zero_v8, tile_max_y_v8, is_visible_v8);
+
+        // The ranges are padded to whole registers
+        _mm256_storeu_si256((__m256i*)(ranges->min_x + i), tile_min_x_v8);
+        _mm256_storeu_si256((__m256i*)(ranges->max_x + i), tile_max_x_v8);
+        _mm256_storeu_si256((__m256i*)(ranges->min_y + i), tile_min_y_v8);
+        _mm256_storeu_si256((__m256i*)(ranges->max_y + i), tile_max_y_v8);
+    }
+}
+
+/// @brief: Sort-middle binning. Counts the commands overlapping each tile, prefix sums the counts and
+/// scatters the command indices, so a tile only visits the commands that touch it.
+auto bin_render_commands(RenderGroup* group, i32* command_render_order, Framebuffer* buffer, MemoryArena* arena) -> TileBins {
+    TileBins result = {};
+    result.tile_count = (i32)buffer->tiles.count();
+    result.offsets = allocate<i32>(arena, result.tile_count + 1);
+
+    Assert(result.tile_count > 0);
+    TileGrid grid = {};
+    grid.width = buffer->width;
+    grid.height = buffer->height;
+    grid.tile_width = buffer->tiles[0].rect.max_x - buffer->tiles[0].rect.min_x;
+    grid.tile_height = buffer->tiles[0].rect.max_y - buffer->tiles[0].rect.min_y;
+    i32 tile_count_x = buffer->width / grid.tile_width;
+    Assert(tile_count_x * (buffer->height / grid.tile_height) == result.tile_count);
+
+    // Tile range per command, inclusive. min > max means the command is off screen.
+    i32 command_count = group->sort_keys.count();
+    Assert(group->bounds.min_x.count() == command_count);
+    i32 padded_count = (command_count + 7) & ~7;
+    CommandTileRanges ranges = {};
+    ranges.min_x = allocate<i32>(arena, hm::max(padded_count, 1), DoNotClearArenaParams());
+    ranges.max_x = allocate<i32>(arena, hm::max(padded_count, 1), DoNotClearArenaParams());
+    ranges.min_y = allocate<i32>(arena, hm::max(padded_count, 1), DoNotClearArenaParams());
+    ranges.max_y = allocate<i32>(arena, hm::max(padded_count, 1), DoNotClearArenaParams());
+    compute_tile_ranges(&group->bounds, command_render_order, command_count, grid, &ranges);
+
+    i32 total = 0;
+    for (i32 i = 0; i < command_count; i++) {
+        for (i32 y = ranges.min_y[i]; y <= ranges.max_y[i]; y++) {
+            for (i32 x = ranges.min_x[i]; x <= ranges.max_x[i]; x++) {
+                result.offsets[(y * tile_count_x) + x + 1]++;
+            }
+        }
+        if (ranges.min_x[i] <= ranges.max_x[i]) {
+            total += ((ranges.max_x[i] - ranges.min_x[i]) + 1) * ((ranges.max_y[i] - ranges.min_y[i]) + 1);
+        }
+    }
+
+    for (i32 i = 0; i < result.tile_count; i++) {
+        result.offsets[i + 1] += result.offsets[i];
+    }
+    Assert(result.offsets[result.tile_count] == total);
+
+    result.command_indices = allocate<i32>(arena, hm::max(total, 1), DoNotClearArenaParams());
+    i32* cursors = allocate<i32>(arena, result.tile_count, DoNotClearArenaParams());
+    copy_memory(result.offsets, cursors, sizeof(i32) * result.tile_count);
+    for (i32 i = 0; i < command_count; i++) {
+        for (i32 y = ranges.min_y[i]; y <= ranges.max_y[i]; y++) {
+            for (i32 x = ranges.min_x[i]; x <= ranges.max_x[i]; x++) {
+                i32 tile_idx = (y * tile_count_x) + x;
+                result.command_indices[cursors[tile_idx]++] = command_render_order[i];
+            }
+        }
+    }
+
+    return result;
+}
+
+internal auto hash_field(u64 hash, const void* field, u64 size) -> u64 {
+    return hash64_combine(hash, hash64(field, size));
+}
+#define HashField(hash, field) hash_field(hash, &(field), sizeof(field))
+
+/// @brief: Hashes the fields one by one, not the entry's bytes, so the padding between them does not matter.
+internal auto hash_render_command(RenderGroupEntryHeader* header) -> u64 {
+    void* data = (u8*)header + sizeof(*header);
+    u64 result = HashField(0xcbf29ce484222325, header->type);
+    switch (header->type) {
+    case RenderCommands_RenderEntryClear: {
+        auto* entry = (RenderEntryClear*)data;
+        result = HashField(result, entry->color);
+    } break;
+    case RenderCommands_RenderEntryClearCheckPattern: {
+        auto* entry = (RenderEntryClearCheckPattern*)data;
+        result = HashField(result, entry->color1);
+        result = HashField(result, entry->color2);
+    } break;
+    case RenderCommands_RenderEntryQuad: {
+        auto* entry = (RenderEntryQuad*)data;
+        result = HashField(result, entry->quad);
+        result = HashField(result, entry->color);
+        result = HashField(result, entry->border_thickness);
+        result = HashField(result, entry->border_color);
+    } break;
+    case RenderCommands_RenderEntryBitmap: {
+        auto* entry = (RenderEntryBitmap*)data;
+        result = HashField(result, entry->quad);
+        result = HashField(result, entry->uv);
+        result = HashField(result, entry->color);
+        result = HashField(result, entry->offset);
+        result = HashField(result, entry->rotation);
+        result = HashField(result, entry->scale);
+        result = HashField(result, entry->texture_id);
+        result = HashField(result, entry->uv_min);
+        result = HashField(result, entry->uv_max);
+        result = HashField(result, entry->border_thickness);
+        result = HashField(result, entry->border_color);
+    } break;
+    case RenderCommands_RenderEntryBitmapBatch: {
+        // Only the count instances, not the padding of the arrays
+        auto* entry = (RenderEntryBitmapBatch*)data;
+        result = HashField(result, entry->quad);
+        result = HashField(result, entry->texture_id);
+        result = HashField(result, entry->uv_min);
+        result = HashField(result, entry->uv_max);
+        result = HashField(result, entry->count);
+        BitmapBatchInstances instances = get_bitmap_batch_instances(entry);
+        result = hash_field(result, instances.offset_x, entry->count * sizeof(f32));
+        result = hash_field(result, instances.offset_y, entry->count * sizeof(f32));
+        result = hash_field(result, instances.rotation, entry->count * sizeof(f32));
+        result = hash_field(result, instances.scale_x, entry->count * sizeof(f32));
+        result = hash_field(result, instances.scale_y, entry->count * sizeof(f32));
+        result = hash_field(result, instances.color, entry->count * sizeof(vec4));
+    } break;
+    case RenderCommands_RenderEntryGlyphRun: {
+        auto* entry = (RenderEntryGlyphRun*)data;
+        result = HashField(result, entry->color);
+        result = HashField(result, entry->texture_id);
+        result = HashField(result, entry->count);
+        result = hash_field(result, get_glyph_run_glyphs(entry), entry->count * sizeof(GlyphRunGlyph));
+    } break;
+    case RenderCommands_RenderEntryLine: {
+        auto* entry = (RenderEntryLine*)data;
+        result = HashField(result, entry->start);
+        result = HashField(result, entry->end);
+        result = HashField(result, entry->color);
+    } break;
+    case RenderCommands_RenderEntryCircle: {
+        auto* entry = (RenderEntryCircle*)data;
+        result = HashField(result, entry->P);
+        result = HashField(result, entry->radius);
+        result = HashField(result, entry->color);
+    } break;
+    case RenderCommands_RenderEntryFilledCircle: {
+        auto* entry = (RenderEntryFilledCircle*)data;
+        result = HashField(result, entry->P);
+        result = HashField(result, entry->radius);
+        result = HashField(result, entry->color);
+    } break;
+    case RenderCommands_RenderEntryTriangle: {
+        auto* entry = (RenderEntryTriangle*)data;
+        result = HashField(result, entry->vertices);
+        result = HashField(result, entry->color);
+    } break;
+    case RenderCommands_RenderEntryFilledTriangle: {
+        auto* entry = (RenderEntryFilledTriangle*)data;
+        result = HashField(result, entry->vertices);
+        result = HashField(result, entry->color);
+    } break;
+    case RenderCommands_RenderEntryShadedTriangle: {
+        auto* entry = (RenderEntryShadedTriangle*)data;
+        result = HashField(result, entry->P0);
+        result = HashField(result, entry->P1);
+        result = HashField(result, entry->P2);
+        result = HashField(result, entry->h0);
+        result = HashField(result, entry->h1);
+        result = HashField(result, entry->h2);
+        result = HashField(result, entry->color);
+    } break;
+    // Point to per frame data, which is not hashed
+    case RenderCommands_RenderEntryTriMesh:
+    case RenderCommands_RenderEntryTriMeshWireframe: {
+        return 0;
+    } break;
+    default: InvalidCodePath;
+    }
+    // Keep 0 free to mean "unhashable"
+    return result == 0 ? 1 : result;
+}
+
+auto hash_render_commands(RenderGroup* group, MemoryArena* arena) -> u64* {
+    i32 command_count = group->sort_entries_offset.count();
+    u64* result = allocate<u64>(arena, hm::max(command_count, 1), DoNotClearArenaParams());
+    for (i32 i = 0; i < command_count; i++) {
+        result[i] = hash_render_command((RenderGroupEntryHeader*)(group->push_buffer + group->sort_entries_offset[i]));
+    }
+    return result;
+}
+
+auto hash_tile_commands(u64* command_hashes, i32* command_indices, i32 command_count) -> u64 {
+    u64 result = 0xcbf29ce484222325;
+    for (i32 i = 0; i < command_count; i++) {
+        u64 command_hash = command_hashes[command_indices[i]];
+        if (command_hash == 0) {
+            return 0;
+        }
+        result = hash64_combine(result, command_hash);
     }
+    return result == 0 ? 1 : result;
 }
 
-auto apply_frame_buffer_AVX512(           //
-    Framebuffer* src_buffer, Tile* tile,  //
-    Framebuffer* dest_buffer, ivec2 scale //
-    ) -> void {
+// All apply_frame_buffer variants: nearest neighbour upscale of the tile by an integer scale, writing every
+// non-zero (not fully transparent) src pixel to dest. dest pixel x reads src pixel x / scale.x.
+// The stream variants write whole opaque vectors with non-temporal stores, so compositing into a large
+// dest does not evict what the tiles render from.
+
+internal inline auto apply_frame_buffer_AVX512_( //
+    Framebuffer* src_buffer, Tile* tile,       //
+    Framebuffer* dest_buffer, ivec2 scale,     //
+    bool is_streaming) -> void {
     if (!tile->is_dirty) {
         return;
     }
 
     Assert(dest_buffer->bytes_per_pixel == src_buffer->bytes_per_pixel);
-    Assert(dest_buffer->width >= src_buffer->width);
-    Assert(dest_buffer->height >= src_buffer->height);
-
-    // We know this is within bounds.
-    ivec2 src_start = { tile->rect.min_x, tile->rect.min_y };
-    ivec2 src_end = { tile->rect.max_x, tile->rect.max_y };
+    Assert(scale.x > 0 && scale.y > 0);
+    Assert(tile->rect.max_x * scale.x <= dest_buffer->width);
+    Assert(tile->rect.max_y * scale.y <= dest_buffer->height);
 
     ivec2 dest_start = { tile->rect.min_x * scale.x, tile->rect.min_y * scale.y };
     ivec2 dest_end = { tile->rect.max_x * scale.x, tile->rect.max_y * scale.y };
 
-    const i32 LANE_COUNT = 16;
-    if (scale.x == 1) {
-        for (i32 y = dest_start.y; y < dest_end.y; y++) {
-            u32* dest = GET_PIXEL(dest_buffer, dest_start.x, y);
-
-            i32 offset_y = y - dest_start.y;
-            u32* src = GET_PIXEL(src_buffer, src_start.x, (i32)(src_start.y + offset_y));
-            for (i32 x = dest_start.x; x < dest_end.x; x += LANE_COUNT) {
-                __m512i src_colors_v16 = _mm512_load_epi32(src);
-                __mmask16 mask_16 = _mm512_cmpgt_epu32_mask(src_colors_v16, _mm512_setzero_si512());
-                _mm512_mask_storeu_epi32((void*)dest, mask_16, src_colors_v16);
-                dest += LANE_COUNT;
-                src += LANE_COUNT;
+    const i32 LANE_COUNT = AVX512_LANE_COUNT;
+    const __m512i lane_index_v16 = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    // + 0.5 keeps the float division away from integers, so truncating it is an exact integer division.
+    const __m512 half_lane_v16 = _mm512_add_ps(_mm512_cvtepi32_ps(lane_index_v16), _mm512_set1_ps(0.5f));
+    const __m512 inv_scale_v16 = _mm512_set1_ps(1.0f / (f32)scale.x);
+
+    for (i32 y = dest_start.y; y < dest_end.y; y++) {
+        u32* dest = GET_PIXEL(dest_buffer, 0, y);
+        u32* src = GET_PIXEL(src_buffer, 0, y / scale.y);
+
+        for (i32 x = dest_start.x; x < dest_end.x; x += LANE_COUNT) {
+            i32 src_x = x / scale.x;
+            i32 phase = x - src_x * scale.x;
+
+            // Which of the loaded src pixels each dest lane repeats
+            __m512 phase_v16 = _mm512_add_ps(_mm512_set1_ps((f32)phase), half_lane_v16);
+            __m512i src_lane_v16 = _mm512_cvttps_epi32(_mm512_mul_ps(phase_v16, inv_scale_v16));
+
+            i32 src_count = hm::min(tile->rect.max_x - src_x, LANE_COUNT);
+            __m512i src_colors_v16 = _mm512_maskz_loadu_epi32((__mmask16)((1u << src_count) - 1), src + src_x);
+            src_colors_v16 = _mm512_permutexvar_epi32(src_lane_v16, src_colors_v16);
+
+            i32 dest_count = hm::min(dest_end.x - x, LANE_COUNT);
+            __mmask16 mask16 = (__mmask16)((1u << dest_count) - 1);
+            mask16 &= _mm512_cmpneq_epu32_mask(src_colors_v16, _mm512_setzero_si512());
+            if (is_streaming && mask16 == 0xFFFF && is_aligned(dest + x, 64)) {
+                _mm512_stream_si512((__m512i*)(dest + x), src_colors_v16);
+            }
+            else {
+                _mm512_mask_storeu_epi32((void*)(dest + x), mask16, src_colors_v16);
             }
         }
     }
-    else if (scale.x == 4) {
-        __m512i repeat_v16 = _mm512_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
-        i32 dx = LANE_COUNT / 4;
-        f32 dy = 1.0f / 4.0f;
-        f32 offset_y = 0;
-        for (i32 y = dest_start.y; y < dest_end.y; y++) {
-            u32* dest = GET_PIXEL(dest_buffer, dest_start.x, y);
-
-            u32* src = GET_PIXEL(src_buffer, src_start.x, (i32)(src_start.y + offset_y));
-            for (i32 x = dest_start.x; x < dest_end.x; x += 16) {
-                __m128i src_v4 = _mm_load_si128((__m128i const*)(src));
-                __m512i src_colors_v16 = _mm512_permutexvar_epi32(repeat_v16, _mm512_castsi128_si512(src_v4));
-                // Store all values that are not 0
-                __mmask16 mask16 = _mm512_cmpgt_epu32_mask(src_colors_v16, _mm512_setzero_si512());
-                _mm512_mask_storeu_epi32((void*)dest, mask16, src_colors_v16);
-                dest += LANE_COUNT;
-                src += dx;
+    if (is_streaming) {
+        _mm_sfence();
+    }
+}
+
+auto apply_frame_buffer_AVX512(Framebuffer* src_buffer, Tile* tile, Framebuffer* dest_buffer, ivec2 scale) -> void {
+    apply_frame_buffer_AVX512_(src_buffer, tile, dest_buffer, scale, false);
+}
+
+auto apply_frame_buffer_stream_AVX512(Framebuffer* src_buffer, Tile* tile, Framebuffer* dest_buffer, ivec2 scale) -> void {
+    apply_frame_buffer_AVX512_(src_buffer, tile, dest_buffer, scale, true);
+}
+
+internal inline auto apply_frame_buffer_AVX2_( //
+    Framebuffer* src_buffer, Tile* tile,       //
+    Framebuffer* dest_buffer, ivec2 scale,     //
+    bool is_streaming) -> void {
+    if (!tile->is_dirty) {
+        return;
+    }
+
+    Assert(dest_buffer->bytes_per_pixel == src_buffer->bytes_per_pixel);
+    Assert(scale.x > 0 && scale.y > 0);
+    Assert(tile->rect.max_x * scale.x <= dest_buffer->width);
+    Assert(tile->rect.max_y * scale.y <= dest_buffer->height);
+
+    ivec2 dest_start = { tile->rect.min_x * scale.x, tile->rect.min_y * scale.y };
+    ivec2 dest_end = { tile->rect.max_x * scale.x, tile->rect.max_y * scale.y };
+
+    const i32 LANE_COUNT = AVX2_LANE_COUNT;
+    const __m256i lane_index_v8 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    // + 0.5 keeps the float division away from integers, so truncating it is an exact integer division.
+    const __m256 half_lane_v8 = _mm256_add_ps(_mm256_cvtepi32_ps(lane_index_v8), _mm256_set1_ps(0.5f));
+    const __m256 inv_scale_v8 = _mm256_set1_ps(1.0f / (f32)scale.x);
+
+    for (i32 y = dest_start.y; y < dest_end.y; y++) {
+        u32* dest = GET_PIXEL(dest_buffer, 0, y);
+        u32* src = GET_PIXEL(src_buffer, 0, y / scale.y);
+
+        for (i32 x = dest_start.x; x < dest_end.x; x += LANE_COUNT) {
+            i32 src_x = x / scale.x;
+            i32 phase = x - src_x * scale.x;
+
+            // Which of the loaded src pixels each dest lane repeats
+            __m256 phase_v8 = _mm256_add_ps(_mm256_set1_ps((f32)phase), half_lane_v8);
+            __m256i src_lane_v8 = _mm256_cvttps_epi32(_mm256_mul_ps(phase_v8, inv_scale_v8));
+
+            i32 src_count = hm::min(tile->rect.max_x - src_x, LANE_COUNT);
+            __m256i src_mask_v8 = _mm256_cmpgt_epi32(_mm256_set1_epi32(src_count), lane_index_v8);
+            __m256i src_colors_v8 = _mm256_maskload_epi32((const int*)(src + src_x), src_mask_v8);
+            src_colors_v8 = _mm256_permutevar8x32_epi32(src_colors_v8, src_lane_v8);
+
+            i32 dest_count = hm::min(dest_end.x - x, LANE_COUNT);
+            __m256i mask_v8 = _mm256_cmpgt_epi32(_mm256_set1_epi32(dest_count), lane_index_v8);
+            __m256i is_transparent_v8 = _mm256_cmpeq_epi32(src_colors_v8, _mm256_setzero_si256());
+            mask_v8 = _mm256_andnot_si256(is_transparent_v8, mask_v8);
+            if (is_streaming && _mm256_movemask_ps(_mm256_castsi256_ps(mask_v8)) == 0xFF && is_aligned(dest + x, 32)) {
+                _mm256_stream_si256((__m256i*)(dest + x), src_colors_v8);
+            }
+            else {
+                _mm256_maskstore_epi32((int*)(dest + x), mask_v8, src_colors_v8);
             }
-            offset_y += dy;
         }
     }
-    else {
-        InvalidCodePath;
+    if (is_streaming) {
+        _mm_sfence();
     }
 }
 
+auto apply_frame_buffer_AVX2(Framebuffer* src_buffer, Tile* tile, Framebuffer* dest_buffer, ivec2 scale) -> void {
+    apply_frame_buffer_AVX2_(src_buffer, tile, dest_buffer, scale, false);
+}
+
+auto apply_frame_buffer_stream_AVX2(Framebuffer* src_buffer, Tile* tile, Framebuffer* dest_buffer, ivec2 scale) -> void {
+    apply_frame_buffer_AVX2_(src_buffer, tile, dest_buffer, scale, true);
+}
+
 auto apply_frame_buffer_scalar(Framebuffer* src_buffer, Tile* tile, Framebuffer* dest_buffer, ivec2 scale) -> void {
     if (!tile->is_dirty) {
         return;
     }
     Assert(dest_buffer->bytes_per_pixel == src_buffer->bytes_per_pixel);
-    Assert(dest_buffer->width >= src_buffer->width);
-    Assert(dest_buffer->height >= src_buffer->height);
-
-    // We know this is within bounds.
-    vec2 src_start = { (f32)tile->rect.min_x, (f32)tile->rect.min_y };
-    vec2 src_end = { (f32)tile->rect.max_x, (f32)tile->rect.max_y };
+    Assert(scale.x > 0 && scale.y > 0);
+    Assert(tile->rect.max_x * scale.x <= dest_buffer->width);
+    Assert(tile->rect.max_y * scale.y <= dest_buffer->height);
 
     ivec2 dest_start = { tile->rect.min_x * scale.x, tile->rect.min_y * scale.y };
     ivec2 dest_end = { tile->rect.max_x * scale.x, tile->rect.max_y * scale.y };
 
-    f32 dy = 1.0f / scale.y;
-    f32 dx = 1.0f / scale.x;
-    f32 offset_y = 0.0f;
     for (i32 y = dest_start.y; y < dest_end.y; y++) {
         u32* dest = GET_PIXEL(dest_buffer, dest_start.x, y);
-
-        u32* src = GET_PIXEL(src_buffer, 0, (i32)(src_start.y + offset_y));
-        f32 offset_x = 0.0f;
-        for (i32 x = dest_start.x; x < dest_end.x; x++) {
-            i32 src_buffer_x = (i32)(src_start.x + offset_x);
-            u32 src_color = *(src + src_buffer_x);
-            if (src_color > 0) {
-                *dest = src_color;
+        u32* src = GET_PIXEL(src_buffer, 0, y / scale.y);
+        for (i32 src_x = tile->rect.min_x; src_x < tile->rect.max_x; src_x++) {
+            u32 src_color = src[src_x];
+            for (i32 i = 0; i < scale.x; i++) {
+                if (src_color > 0) {
+                    *dest = src_color;
+                }
+                dest++;
             }
-            dest++;
-            offset_x += dx;
         }
-        offset_y += dy;
     }
 }
@@ -5,6 +5,8 @@
 #include <platform/platform.hpp>
 #include <platform/types.hpp>
 
+#include <math/bounding_objects.hpp>
+#include <math/mat2.hpp>
 #include <math/transform.hpp>
 #include <math/vec2.hpp>
 #include <math/vec3.hpp>
@@ -31,6 +33,7 @@ typedef struct {
     vec2 br;
 } Quadrilateral;
 
+// Light colors are linear, and every light a vertex faces adds to it.
 struct PointLight {
     vec4 P;
     vec4 color;
@@ -41,14 +44,24 @@ struct AmbientLight {
 };
 
 struct DirectionalLight {
+    // Towards the light, normalized
     vec4 L;
     vec4 color;
 };
 
+// World space lights of a RenderEntryTriMesh.
+struct MeshLights {
+    AmbientLight ambient;
+    Array<DirectionalLight> directional;
+    Array<PointLight> point;
+};
+
 enum RenderGroupEntryType {                      //
     RenderCommands_RenderEntryClear,             //
     RenderCommands_RenderEntryClearCheckPattern, //
     RenderCommands_RenderEntryBitmap,            //
+    RenderCommands_RenderEntryBitmapBatch,       //
+    RenderCommands_RenderEntryGlyphRun,          //
     RenderCommands_RenderEntryQuad,              //
     RenderCommands_RenderEntryLine,              //
     RenderCommands_RenderEntryCircle,            //
@@ -94,6 +107,81 @@ struct RenderEntryBitmap {
     vec4 border_color;
 };
 
+// Many instances of one bitmap, like a swarm of projectiles, as a single command. Only what differs per instance
+// is stored per instance, as arrays right behind the entry. Push it with push_bitmap_batch and fill in the arrays
+// from get_bitmap_batch_instances.
+struct RenderEntryBitmapBatch {
+    Quadrilateral quad;
+    i32 texture_id;
+    ivec2 uv_min;
+    ivec2 uv_max;
+    i32 count;
+};
+
+struct BitmapBatchInstances {
+    f32* offset_x;
+    f32* offset_y;
+    f32* rotation;
+    f32* scale_x;
+    f32* scale_y;
+    vec4* color;
+};
+
+/// @brief: The f32 arrays are padded to whole AVX2 registers. The padding is zero.
+auto inline bitmap_batch_stride(i32 count) -> i32 {
+    return (count + 7) & ~7;
+}
+
+auto inline bitmap_batch_instances_size(i32 count) -> u32 {
+    return (u32)(bitmap_batch_stride(count) * 5 * sizeof(f32) + count * sizeof(vec4));
+}
+
+auto inline get_bitmap_batch_instances(RenderEntryBitmapBatch* entry) -> BitmapBatchInstances {
+    i32 stride = bitmap_batch_stride(entry->count);
+    f32* arrays = (f32*)(entry + 1);
+    BitmapBatchInstances result;
+    result.offset_x = arrays;
+    result.offset_y = arrays + stride;
+    result.rotation = arrays + 2 * stride;
+    result.scale_x = arrays + 3 * stride;
+    result.scale_y = arrays + 4 * stride;
+    result.color = (vec4*)(arrays + 5 * stride);
+    return result;
+}
+
+/// @brief: How far the quad reaches from the model origin. Scaled by the larger scale, it bounds an instance
+/// at any rotation.
+auto inline bitmap_batch_model_radius(Quadrilateral quad) -> f32 {
+    f32 result = hm::max(dot(quad.bl, quad.bl), dot(quad.tl, quad.tl));
+    result = hm::max(result, hm::max(dot(quad.tr, quad.tr), dot(quad.br, quad.br)));
+    return sqrtf(result);
+}
+
+// A line of text, or any run of unrotated, unscaled bitmaps from one atlas. The glyphs are copied texel for texel
+// to whole pixels, so they skip the rotated sampler and its filtering. They are stored right behind the entry.
+// Push it with push_glyph_run and fill them in from get_glyph_run_glyphs.
+struct RenderEntryGlyphRun {
+    // Multiplied with the atlas texels, the atlas holds the coverage
+    vec4 color;
+    i32 texture_id;
+    i32 count;
+};
+
+struct GlyphRunGlyph {
+    // Bottom left pixel on screen
+    i32 x;
+    i32 y;
+    // Atlas texels copied, [min, max)
+    u16 u_min;
+    u16 v_min;
+    u16 u_max;
+    u16 v_max;
+};
+
+auto inline get_glyph_run_glyphs(RenderEntryGlyphRun* entry) -> GlyphRunGlyph* {
+    return (GlyphRunGlyph*)(entry + 1);
+}
+
 struct RenderEntryLine {
     vec3 start;
     vec3 end;
@@ -151,10 +239,42 @@ struct RenderEntryShadedTriangle {
     vec4 color;
 };
 
+// Vertices the batched vertex transform reads per iteration at most. Arrays it reads and writes are padded to it.
+const u32 VertexBatchSize = 16;
+
+auto inline vertex_batch_padded_count(u32 count) -> u32 {
+    return (count + VertexBatchSize - 1) & ~(VertexBatchSize - 1);
+}
+
+// Model space positions as a structure of arrays, w is 1. Padded with zeroes to a multiple of VertexBatchSize.
+struct VertexPositions {
+    Array<f32> x;
+    Array<f32> y;
+    Array<f32> z;
+};
+
+/// @brief: Vertex i as a point, w is 1.
+auto inline get_vertex_position(const VertexPositions& positions, u32 i) -> vec4 {
+    return vec4(positions.x[i], positions.y[i], positions.z[i], 1.0f);
+}
+
+// Model space vertex normals, padded like VertexPositions.
+struct VertexNormals {
+    Array<f32> x;
+    Array<f32> y;
+    Array<f32> z;
+};
+
 struct TriMesh {
-    Array<vec4> vertices;
+    // The vertices, the arrays are padded past vertex_count
+    VertexPositions positions;
+    u32 vertex_count;
     Array<ivec3> triangles;
     Array<vec3> normals;
+    // Averaged from the faces around each vertex, for vertex lighting
+    VertexNormals vertex_normals;
+    // Model space, for culling instances before their vertices are transformed
+    AABB bounds;
 };
 
 struct MeshInstance {
@@ -168,6 +288,9 @@ struct RenderEntryTriMesh {
     mat4 view_to_clip;
     TriMesh model;
     Array<MeshInstance> instances;
+    // Flat colored unless set
+    bool is_lit;
+    MeshLights lights;
 };
 
 struct RenderEntryPolygonInstances {
@@ -176,26 +299,80 @@ struct RenderEntryPolygonInstances {
     Array<vec4> colors;
 };
 
+// Screen space extents of the commands, in push order, next to the push buffer. Binning and culling scan these
+// instead of decoding the commands. Unclipped, min > max for a command that draws nothing.
+struct RenderCommandBounds {
+    List<f32> min_x;
+    List<f32> min_y;
+    List<f32> max_x;
+    List<f32> max_y;
+};
+
 struct RenderGroup {
     List<u64> sort_entries_offset;
     List<i32> sort_keys;
+    // Written by the push helpers
+    RenderCommandBounds bounds;
 
     u64 max_push_buffer_size;
     u64 push_buffer_size;
     u8* push_buffer;
 };
 
+/// @brief: Allocates the per command lists of a group for up to max_command_count commands.
+auto inline init_render_group_commands(RenderGroup* group, MemoryArena* arena, i32 max_command_count) -> void {
+    group->sort_keys.init(arena, max_command_count);
+    group->sort_entries_offset.init(arena, max_command_count);
+    group->bounds.min_x.init(arena, max_command_count);
+    group->bounds.min_y.init(arena, max_command_count);
+    group->bounds.max_x.init(arena, max_command_count);
+    group->bounds.max_y.init(arena, max_command_count);
+}
+
+/// @brief: Copies what the renderer reads of a group after render returns, the bounds included.
+auto inline copy_render_group(RenderGroup* source, MemoryArena* arena) -> RenderGroup {
+    RenderGroup result = {};
+    i32 command_count = source->sort_keys.count();
+    init_render_group_commands(&result, arena, hm::max(command_count, 1));
+    for (i32 i = 0; i < command_count; i++) {
+        result.sort_keys.push(source->sort_keys[i]);
+        result.sort_entries_offset.push(source->sort_entries_offset[i]);
+        *result.bounds.min_x.push() = source->bounds.min_x[i];
+        *result.bounds.max_x.push() = source->bounds.max_x[i];
+        *result.bounds.min_y.push() = source->bounds.min_y[i];
+        *result.bounds.max_y.push() = source->bounds.max_y[i];
+    }
+    result.push_buffer_size = source->push_buffer_size;
+    result.max_push_buffer_size = source->push_buffer_size;
+    result.push_buffer = allocate<u8>(*arena, source->push_buffer_size, DoNotClearArenaParams());
+    copy_memory(source->push_buffer, result.push_buffer, source->push_buffer_size);
+    return result;
+}
+
 // INTERNAL
 
 struct Tile {
     Rectangle2i rect;
     bool is_dirty;
     bool is_initialized;
+    // Hash of the commands that produced the tile's current pixels, 0 if they are unknown.
+    u64 content_hash;
+    // Set by the last render: the commands matched content_hash, so rendering the tile was skipped.
+    bool is_unchanged;
+    // False after a clear, the tile's z_buffer is stale until the first command that tests depth clears it.
+    bool is_depth_initialized;
 };
 
+// Size of the blocks in Framebuffer::z_blocks
+const i32 ZBlockDim = 8;
+
 struct Framebuffer {
     void* memory;
     Array<f32> z_buffer;
+    // Coarse depth, one entry per ZBlockDim x ZBlockDim block: the farthest z (smallest 1/w) in the block.
+    // A triangle that is nowhere closer than this can skip the block.
+    Array<f32> z_blocks;
+    i32 z_block_count_x;
     i32 memory_size;
     i32 width;
     i32 height;
@@ -203,6 +380,7 @@ struct Framebuffer {
     i32 pitch;
 
     Array<Tile> tiles;
+    u64 rendered_frame; // Frame index of the last render into this buffer
 
     auto inline set_pixel(i32 x, i32 y, u32 color) -> void {
         Assert(x >= 0 && x < width);
@@ -241,6 +419,46 @@ auto inline generate_tiles(i32 width, i32 height, i32 tile_dim_x, i32 tile_dim_y
     return result;
 }
 
+auto inline z_block_count(i32 pixel_count) -> i32 {
+    return (pixel_count + ZBlockDim - 1) / ZBlockDim;
+}
+
+auto inline get_z_block(Framebuffer& buffer, i32 x, i32 y) -> f32* {
+    Assert(x >= 0 && x < buffer.width);
+    Assert(y >= 0 && y < buffer.height);
+    return &buffer.z_blocks[(y / ZBlockDim) * buffer.z_block_count_x + (x / ZBlockDim)];
+}
+
+/// @brief: Must be called whenever z_buffer is cleared. Resets every block touching the rect, so it will not reject anything.
+auto inline reset_z_blocks(Framebuffer& buffer, Rectangle2i rect) -> void {
+    i32 min_x = hm::max(rect.min_x, 0) / ZBlockDim;
+    i32 min_y = hm::max(rect.min_y, 0) / ZBlockDim;
+    i32 max_x = z_block_count(hm::min(rect.max_x, buffer.width));
+    i32 max_y = z_block_count(hm::min(rect.max_y, buffer.height));
+    for (i32 y = min_y; y < max_y; y++) {
+        for (i32 x = min_x; x < max_x; x++) {
+            buffer.z_blocks[y * buffer.z_block_count_x + x] = 0.0f;
+        }
+    }
+}
+
+/// @brief: Clears are O(1) for depth, they only mark the tile. Call this before a command reads the tile's z_buffer,
+/// so only the tiles that draw depth tested geometry pay for the clear, once per frame.
+auto inline initialize_tile_depth(Framebuffer& buffer, Tile* tile) -> void {
+    if (tile->is_depth_initialized) {
+        return;
+    }
+    i32 min_x = hm::max(tile->rect.min_x, 0);
+    i32 max_x = hm::min(tile->rect.max_x, buffer.width);
+    i32 min_y = hm::max(tile->rect.min_y, 0);
+    i32 max_y = hm::min(tile->rect.max_y, buffer.height);
+    for (i32 y = min_y; y < max_y; y++) {
+        ZeroArray((max_x - min_x), buffer.z_buffer.data() + y * buffer.width + min_x);
+    }
+    reset_z_blocks(buffer, tile->rect);
+    tile->is_depth_initialized = true;
+}
+
 auto inline set_pixel(Framebuffer* buffer, i32 x, i32 y, u32 color) -> void {
     Assert(x >= 0 && x < buffer->width);
     Assert(y >= 0 && y < buffer->height);
@@ -255,6 +473,56 @@ auto inline get_pixel(Framebuffer* buffer, i32 x, i32 y) -> u32* {
     return (u32*)((u8*)buffer->memory + (y * buffer->pitch) + (x * buffer->bytes_per_pixel));
 }
 
+// Per-tile command lists, produced once per render call. Tile i owns
+// command_indices[offsets[i], offsets[i + 1]), already in render order.
+struct TileBins {
+    i32 tile_count;
+    i32* offsets;
+    i32* command_indices;
+};
+
+auto inline tile_bins_count(TileBins* bins, i32 tile_idx) -> i32 {
+    Assert(tile_idx >= 0 && tile_idx < bins->tile_count);
+    return bins->offsets[tile_idx + 1] - bins->offsets[tile_idx];
+}
+
+auto inline tile_bins_commands(TileBins* bins, i32 tile_idx) -> i32* {
+    Assert(tile_idx >= 0 && tile_idx < bins->tile_count);
+    return bins->command_indices + bins->offsets[tile_idx];
+}
+
+struct TileGrid {
+    i32 width;
+    i32 height;
+    i32 tile_width;
+    i32 tile_height;
+};
+
+// Tiles each command overlaps, inclusive, in render order. min > max for a command that is off screen.
+struct CommandTileRanges {
+    i32* min_x;
+    i32* max_x;
+    i32* min_y;
+    i32* max_y;
+};
+
+// Clips group->bounds to the grid and converts them to tile ranges. ranges hold command_count rounded up to 8.
+typedef void (*compute_tile_ranges_fn)(RenderCommandBounds* bounds, i32* command_render_order, i32 command_count, //
+    TileGrid grid, CommandTileRanges* ranges);
+auto compute_tile_ranges_scalar(RenderCommandBounds* bounds, i32* command_render_order, i32 command_count, //
+    TileGrid grid, CommandTileRanges* ranges) -> void;
+auto compute_tile_ranges_AVX2(RenderCommandBounds* bounds, i32* command_render_order, i32 command_count, //
+    TileGrid grid, CommandTileRanges* ranges) -> void;
+global_variable compute_tile_ranges_fn compute_tile_ranges = compute_tile_ranges_scalar;
+
+auto bin_render_commands(RenderGroup* group, i32* command_render_order, Framebuffer* buffer, MemoryArena* arena) -> TileBins;
+
+// Content hash of every command in push order. 0 for commands whose result cannot be derived
+// from the push buffer alone, e.g. meshes that point to per frame data.
+auto hash_render_commands(RenderGroup* group, MemoryArena* arena) -> u64*;
+/// @return: Hash of a tile's command list, 0 if any of the commands can not be hashed.
+auto hash_tile_commands(u64* command_hashes, i32* command_indices, i32 command_count) -> u64;
+
 #define GET_PIXEL(buffer_ptr, x, y) \
     ((u32*)((u8*)(buffer_ptr)->memory + ((y) * (buffer_ptr)->pitch) + ((x) * (buffer_ptr)->bytes_per_pixel)))
 
@@ -263,26 +531,51 @@ inline void apply_frame_buffer_no_init(Framebuffer* src_buffer, Tile* tile, Fram
 }
 typedef void (*apply_frame_buffer_fn)(Framebuffer* src_buffer, Tile* tile, Framebuffer* dest_buffer, ivec2 scale);
 global_variable apply_frame_buffer_fn apply_frame_buffer = apply_frame_buffer_no_init;
+// Same result, with non-temporal stores. For dest buffers too large to stay cached.
+global_variable apply_frame_buffer_fn apply_frame_buffer_stream = apply_frame_buffer_no_init;
 
 void apply_frame_buffer_scalar(Framebuffer* src_buffer, Tile* tile, Framebuffer* dest_buffer, ivec2 scale);
+void apply_frame_buffer_AVX2(Framebuffer* src_buffer, Tile* tile, Framebuffer* dest_buffer, ivec2 scale);
 void apply_frame_buffer_AVX512(Framebuffer* src_buffer, Tile* tile, Framebuffer* dest_buffer, ivec2 scale);
+void apply_frame_buffer_stream_AVX2(Framebuffer* src_buffer, Tile* tile, Framebuffer* dest_buffer, ivec2 scale);
+void apply_frame_buffer_stream_AVX512(Framebuffer* src_buffer, Tile* tile, Framebuffer* dest_buffer, ivec2 scale);
 auto initialize_renderer_lib() -> void;
 
 // INTERNAL END
 
-#define PushRenderElement(group, type, sort_key) \
-    (type*)push_render_element_(group, sizeof(type), RenderCommands_##type, sort_key)
-auto inline push_render_element_(RenderGroup* render_group, u32 size, RenderGroupEntryType type, i32 sort_key) {
+const Rectangle2f Full_Extents = { .min_x = -f32_max, .max_x = f32_max, .min_y = -f32_max, .max_y = f32_max };
+const Rectangle2f Empty_Extents = { .min_x = f32_max, .max_x = -f32_max, .min_y = f32_max, .max_y = -f32_max };
+
+auto inline extents_from_triangle(vec3 P0, vec3 P1, vec3 P2) -> Rectangle2f {
+    return {
+        .min_x = hm::min(P0.x, P1.x, P2.x),
+        .max_x = hm::max(P0.x, P1.x, P2.x),
+        .min_y = hm::min(P0.y, P1.y, P2.y),
+        .max_y = hm::max(P0.y, P1.y, P2.y),
+    };
+}
+
+auto inline extents_from_circle(vec2 P, f32 radius) -> Rectangle2f {
+    return { .min_x = P.x - radius, .max_x = P.x + radius, .min_y = P.y - radius, .max_y = P.y + radius };
+}
+
+/// @brief: Reserves an entry of size bytes behind its header and records extents, the screen space rect it can
+/// write to, in group->bounds. Entries are packed back to back and are not zeroed, the push_* helpers write them.
+auto inline push_render_element_(RenderGroup* render_group, u32 size, RenderGroupEntryType type, i32 sort_key, //
+    Rectangle2f extents) {
     void* result = 0;
 
     u64 total_size = size + sizeof(RenderGroupEntryHeader);
     if ((render_group->push_buffer_size + total_size) < render_group->max_push_buffer_size) {
         RenderGroupEntryHeader* header = (RenderGroupEntryHeader*)(render_group->push_buffer + render_group->push_buffer_size);
-        ZeroSize(total_size, header);
         header->type = type;
         result = (u8*)(header) + sizeof(*header);
         render_group->sort_entries_offset.push(render_group->push_buffer_size);
         render_group->sort_keys.push(sort_key);
+        *render_group->bounds.min_x.push() = extents.min_x;
+        *render_group->bounds.max_x.push() = extents.max_x;
+        *render_group->bounds.min_y.push() = extents.min_y;
+        *render_group->bounds.max_y.push() = extents.max_y;
 
         render_group->push_buffer_size += total_size;
     }
@@ -294,6 +587,181 @@ auto inline push_render_element_(RenderGroup* render_group, u32 size, RenderGrou
     return result;
 }
 
+auto inline push_clear(RenderGroup* render_group, const RenderEntryClear& entry, i32 sort_key) -> RenderEntryClear* {
+    auto* result = (RenderEntryClear*)push_render_element_(
+        render_group, sizeof(entry), RenderCommands_RenderEntryClear, sort_key, Full_Extents);
+    *result = entry;
+    return result;
+}
+
+auto inline push_clear_check_pattern(RenderGroup* render_group, const RenderEntryClearCheckPattern& entry, i32 sort_key)
+    -> RenderEntryClearCheckPattern* {
+    auto* result = (RenderEntryClearCheckPattern*)push_render_element_(
+        render_group, sizeof(entry), RenderCommands_RenderEntryClearCheckPattern, sort_key, Full_Extents);
+    *result = entry;
+    return result;
+}
+
+auto inline push_quad(RenderGroup* render_group, const RenderEntryQuad& entry, i32 sort_key) -> RenderEntryQuad* {
+    auto* result = (RenderEntryQuad*)push_render_element_(
+        render_group, sizeof(entry), RenderCommands_RenderEntryQuad, sort_key, entry.quad);
+    *result = entry;
+    return result;
+}
+
+auto inline push_bitmap(RenderGroup* render_group, const RenderEntryBitmap& entry, i32 sort_key) -> RenderEntryBitmap* {
+    // Same model to camera transform as draw_bitmap. The border is inset, so the quad covers it.
+    mat2 M_m_to_c = mat2_rotate(entry.rotation) * mat2_scale(entry.scale);
+    vec2 bl_c = entry.quad.bl * M_m_to_c + entry.offset;
+    vec2 tl_c = entry.quad.tl * M_m_to_c + entry.offset;
+    vec2 tr_c = entry.quad.tr * M_m_to_c + entry.offset;
+    vec2 br_c = entry.quad.br * M_m_to_c + entry.offset;
+    Rectangle2f extents = {
+        .min_x = hm::min(bl_c.x, tl_c.x, tr_c.x, br_c.x),
+        .max_x = hm::max(bl_c.x, tl_c.x, tr_c.x, br_c.x),
+        .min_y = hm::min(bl_c.y, tl_c.y, tr_c.y, br_c.y),
+        .max_y = hm::max(bl_c.y, tl_c.y, tr_c.y, br_c.y),
+    };
+    auto* result = (RenderEntryBitmap*)push_render_element_(
+        render_group, sizeof(entry), RenderCommands_RenderEntryBitmap, sort_key, extents);
+    *result = entry;
+    return result;
+}
+
+auto inline push_line(RenderGroup* render_group, const RenderEntryLine& entry, i32 sort_key) -> RenderEntryLine* {
+    Rectangle2f extents = {
+        .min_x = hm::min(entry.start.x, entry.end.x),
+        .max_x = hm::max(entry.start.x, entry.end.x),
+        .min_y = hm::min(entry.start.y, entry.end.y),
+        .max_y = hm::max(entry.start.y, entry.end.y),
+    };
+    auto* result = (RenderEntryLine*)push_render_element_(
+        render_group, sizeof(entry), RenderCommands_RenderEntryLine, sort_key, extents);
+    *result = entry;
+    return result;
+}
+
+auto inline push_circle(RenderGroup* render_group, const RenderEntryCircle& entry, i32 sort_key) -> RenderEntryCircle* {
+    auto* result = (RenderEntryCircle*)push_render_element_(render_group, sizeof(entry),
+        RenderCommands_RenderEntryCircle, sort_key, extents_from_circle(entry.P, entry.radius));
+    *result = entry;
+    return result;
+}
+
+auto inline push_filled_circle(RenderGroup* render_group, const RenderEntryFilledCircle& entry, i32 sort_key)
+    -> RenderEntryFilledCircle* {
+    auto* result = (RenderEntryFilledCircle*)push_render_element_(render_group, sizeof(entry),
+        RenderCommands_RenderEntryFilledCircle, sort_key, extents_from_circle(entry.P, entry.radius));
+    *result = entry;
+    return result;
+}
+
+auto inline push_triangle(RenderGroup* render_group, const RenderEntryTriangle& entry, i32 sort_key)
+    -> RenderEntryTriangle* {
+    auto* result = (RenderEntryTriangle*)push_render_element_(render_group, sizeof(entry),
+        RenderCommands_RenderEntryTriangle, sort_key, extents_from_triangle(entry.P0, entry.P1, entry.P2));
+    *result = entry;
+    return result;
+}
+
+auto inline push_filled_triangle(RenderGroup* render_group, const RenderEntryFilledTriangle& entry, i32 sort_key)
+    -> RenderEntryFilledTriangle* {
+    auto* result = (RenderEntryFilledTriangle*)push_render_element_(render_group, sizeof(entry),
+        RenderCommands_RenderEntryFilledTriangle, sort_key, extents_from_triangle(entry.P0, entry.P1, entry.P2));
+    *result = entry;
+    return result;
+}
+
+auto inline push_shaded_triangle(RenderGroup* render_group, const RenderEntryShadedTriangle& entry, i32 sort_key)
+    -> RenderEntryShadedTriangle* {
+    auto* result = (RenderEntryShadedTriangle*)push_render_element_(render_group, sizeof(entry),
+        RenderCommands_RenderEntryShadedTriangle, sort_key, extents_from_triangle(entry.P0, entry.P1, entry.P2));
+    *result = entry;
+    return result;
+}
+
+/// @brief: The mesh is projected when it is rendered, so it may cover the whole screen.
+auto inline push_tri_mesh(RenderGroup* render_group, const RenderEntryTriMesh& entry, i32 sort_key)
+    -> RenderEntryTriMesh* {
+    auto* result = (RenderEntryTriMesh*)push_render_element_(
+        render_group, sizeof(entry), RenderCommands_RenderEntryTriMesh, sort_key, Full_Extents);
+    *result = entry;
+    return result;
+}
+
+/// @brief: Pushes a batch of entry.count instances. The caller fills them in and then calls end_bitmap_batch,
+/// which bounds the batch by its instances. Until then it covers the whole screen.
+auto inline push_bitmap_batch(RenderGroup* render_group, const RenderEntryBitmapBatch& entry, i32 sort_key)
+    -> RenderEntryBitmapBatch* {
+    u32 size = sizeof(RenderEntryBitmapBatch) + bitmap_batch_instances_size(entry.count);
+    auto* result = (RenderEntryBitmapBatch*)push_render_element_(
+        render_group, size, RenderCommands_RenderEntryBitmapBatch, sort_key, Full_Extents);
+    *result = entry;
+
+    // The padding of the f32 arrays is loaded by the AVX2 setup
+    i32 stride = bitmap_batch_stride(entry.count);
+    f32* arrays = (f32*)(result + 1);
+    for (i32 i = 0; i < 5; i++) {
+        ZeroArray((stride - entry.count), arrays + i * stride + entry.count);
+    }
+    return result;
+}
+
+/// @brief: Bounds the last pushed command, a batch, by its instances. Each is bounded at any rotation.
+auto inline end_bitmap_batch(RenderGroup* render_group, RenderEntryBitmapBatch* batch) -> void {
+    i32 last = render_group->sort_entries_offset.count() - 1;
+    Assert(last >= 0);
+    u8* last_entry = render_group->push_buffer + render_group->sort_entries_offset[last] + sizeof(RenderGroupEntryHeader);
+    Assert((u8*)batch == last_entry);
+
+    BitmapBatchInstances instances = get_bitmap_batch_instances(batch);
+    f32 radius = bitmap_batch_model_radius(batch->quad);
+    Rectangle2f extents = Empty_Extents;
+    for (i32 i = 0; i < batch->count; i++) {
+        f32 r = radius * hm::max(fabsf(instances.scale_x[i]), fabsf(instances.scale_y[i]));
+        extents.min_x = hm::min(extents.min_x, instances.offset_x[i] - r);
+        extents.min_y = hm::min(extents.min_y, instances.offset_y[i] - r);
+        extents.max_x = hm::max(extents.max_x, instances.offset_x[i] + r);
+        extents.max_y = hm::max(extents.max_y, instances.offset_y[i] + r);
+    }
+    render_group->bounds.min_x[last] = extents.min_x;
+    render_group->bounds.max_x[last] = extents.max_x;
+    render_group->bounds.min_y[last] = extents.min_y;
+    render_group->bounds.max_y[last] = extents.max_y;
+}
+
+/// @brief: Pushes a glyph run of entry.count glyphs. The caller fills in all of them and then calls end_glyph_run,
+/// which bounds the run by its glyphs. Until then it covers the whole screen.
+auto inline push_glyph_run(RenderGroup* render_group, const RenderEntryGlyphRun& entry, i32 sort_key)
+    -> RenderEntryGlyphRun* {
+    u32 size = sizeof(RenderEntryGlyphRun) + entry.count * sizeof(GlyphRunGlyph);
+    auto* result = (RenderEntryGlyphRun*)push_render_element_(
+        render_group, size, RenderCommands_RenderEntryGlyphRun, sort_key, Full_Extents);
+    *result = entry;
+    return result;
+}
+
+/// @brief: Bounds the last pushed command, a glyph run, by its glyphs.
+auto inline end_glyph_run(RenderGroup* render_group, RenderEntryGlyphRun* run) -> void {
+    i32 last = render_group->sort_entries_offset.count() - 1;
+    Assert(last >= 0);
+    u8* last_entry = render_group->push_buffer + render_group->sort_entries_offset[last] + sizeof(RenderGroupEntryHeader);
+    Assert((u8*)run == last_entry);
+
+    GlyphRunGlyph* glyphs = get_glyph_run_glyphs(run);
+    Rectangle2f extents = Empty_Extents;
+    for (i32 i = 0; i < run->count; i++) {
+        extents.min_x = hm::min(extents.min_x, (f32)glyphs[i].x);
+        extents.min_y = hm::min(extents.min_y, (f32)glyphs[i].y);
+        extents.max_x = hm::max(extents.max_x, (f32)(glyphs[i].x + (glyphs[i].u_max - glyphs[i].u_min)));
+        extents.max_y = hm::max(extents.max_y, (f32)(glyphs[i].y + (glyphs[i].v_max - glyphs[i].v_min)));
+    }
+    render_group->bounds.min_x[last] = extents.min_x;
+    render_group->bounds.max_x[last] = extents.max_x;
+    render_group->bounds.min_y[last] = extents.min_y;
+    render_group->bounds.max_y[last] = extents.max_y;
+}
+
 const i32 MaxTextureId = 1024;
 
 struct FrameBufferHandle {
@@ -313,7 +781,9 @@ struct Color {
 #define RENDERER_INIT(name) void name(void* context, PlatformApi* platform_api, MemoryBlock* memory)
 typedef RENDERER_INIT(renderer_init_fn);
 
-#define RENDERER_ADD_TEXTURE(name) bool name(i32 texture_id, void* data, i32 width, i32 height, i32 bytes_per_pixel)
+// PixelFormat_SoftwareNative data is referenced by the software renderer, not copied, so it has to outlive the texture.
+#define RENDERER_ADD_TEXTURE(name) \
+    bool name(i32 texture_id, void* data, i32 width, i32 height, i32 bytes_per_pixel, PixelFormat pixel_format)
 typedef RENDERER_ADD_TEXTURE(renderer_add_texture_fn);
 
 #define RENDERER_RENDER(name) \
@@ -340,6 +810,12 @@ typedef RENDERER_APPLY_FRAMEBUFFER(renderer_apply_framebuffer_fn);
 typedef RENDERER_GET_COLOR(renderer_get_color_fn);
 // Framebuffer end
 
+// Pipelined, render and apply_framebuffer only record the frame. end_frame presents the previous frame and leaves
+// this one rendering on the workers, so the caller can simulate the next frame meanwhile. One frame of latency.
+// Takes effect at the next begin_frame.
+#define RENDERER_SET_PIPELINED(name) void name(bool is_pipelined)
+typedef RENDERER_SET_PIPELINED(renderer_set_pipelined_fn);
+
 struct RendererApi {
     renderer_init_fn* init;
     renderer_add_texture_fn* add_texture;
@@ -351,4 +827,5 @@ struct RendererApi {
     renderer_create_framebuffer_fn* create_framebuffer;
     renderer_apply_framebuffer_fn* apply_framebuffer;
     renderer_get_color_fn* get_color;
+    renderer_set_pipelined_fn* set_pipelined;
 };
@@ -0,0 +1,1994 @@
+// Platform independent part of the software renderer. Included by the platform layer
+// (win32_software_renderer.cpp, headless_software_renderer.cpp), which defines the page
+// allocation below and presents state.platform_buffer.
+#include <immintrin.h>
+#include <platform/platform.hpp>
+
+#include <math/mat2.hpp>
+#include <math/mat3.hpp>
+#include <math/math.hpp>
+#include <math/simd.hpp>
+#include <math/util.hpp>
+
+#include <core/logger.hpp>
+#include <core/memory.hpp>
+#include <core/memory_arena.hpp>
+#include <core/sort.hpp>
+#include <engine/structs/swap_back_list.hpp>
+// TODO: Move to core
+#include <engine/hm_assert.hpp>
+#include <engine/profiling.hpp>
+
+#include <renderers/cpu_render_algorithms.hpp>
+#include <renderers/renderer.hpp>
+#include <renderers/texture_format.hpp>
+
+#include "../core/lib.cpp"
+#include "../math/unit.cpp"
+#include "core/lib.hpp"
+#include "math/vec3.hpp"
+#include "platform/types.hpp"
+#include "renderer.cpp"
+
+// Implemented by the platform layer. Returns zeroed, page aligned memory.
+internal auto allocate_pages(u64 size) -> void*;
+internal auto free_pages(void* memory) -> void;
+
+enum TextureLayout {
+    // Rows of texels, pitch = width * bytes_per_pixel
+    TextureLayout_Linear,
+    // 4x4 texel blocks, one cache line each, stored row by row. A rotated sprite walks the texture
+    // diagonally, which touches a new row, and a new cache line, for almost every texel in the linear layout.
+    TextureLayout_Blocks4x4,
+};
+
+// Levels below 1x1 are not generated, so this covers textures up to 4096x4096
+const i32 MaxMipCount = 12;
+
+struct SWTexture {
+    void* data;
+    i32 width;
+    i32 height;
+    i32 size;
+    i32 count;
+    i32 pitch;
+    i32 bytes_per_pixel;
+    TextureLayout layout;
+    i32 block_count_x; // Blocks per block row, only used by TextureLayout_Blocks4x4
+
+    // Levels 1 to mip_count, each half the size of the previous one. Same layout as this one.
+    SWTexture* mips;
+    i32 mip_count;
+};
+
+/// @brief: Where texel x, y is in texture->data, in texels.
+auto inline texel_index(SWTexture* texture, i32 x, i32 y) -> i32 {
+    if (texture->layout == TextureLayout_Blocks4x4) {
+        return blocks4x4_texel_index(x, y, texture->block_count_x);
+    }
+    return y * texture->width + x;
+}
+
+auto inline texel_index_v8(SWTexture* texture, __m256i x_v8, __m256i y_v8) -> __m256i {
+    if (texture->layout == TextureLayout_Blocks4x4) {
+        const __m256i three_v8 = _mm256_set1_epi32(3);
+        __m256i block_row_v8 = _mm256_mullo_epi32(_mm256_srli_epi32(y_v8, 2), _mm256_set1_epi32(texture->block_count_x));
+        __m256i block_v8 = _mm256_add_epi32(block_row_v8, _mm256_srli_epi32(x_v8, 2));
+        __m256i in_block_v8 = _mm256_or_si256(                      //
+            _mm256_slli_epi32(_mm256_and_si256(y_v8, three_v8), 2), //
+            _mm256_and_si256(x_v8, three_v8));
+        return _mm256_or_si256(_mm256_slli_epi32(block_v8, 4), in_block_v8);
+    }
+    return _mm256_add_epi32(x_v8, _mm256_mullo_epi32(y_v8, _mm256_set1_epi32(texture->width)));
+}
+
+// The level a bitmap is sampled from
+struct MipSelection {
+    SWTexture* texture;
+    i32 level;
+    f32 scale; // Level texels per base texel
+};
+
+/// @brief: Picks the largest level that is not magnified, from how many base texels one pixel step covers.
+auto inline select_mip_level(SWTexture* texture, vec2 ds_dx, vec2 ds_dy) -> MipSelection {
+    MipSelection result = { texture, 0, 1.0f };
+    f32 texels_per_pixel = sqrtf(hm::max(dot(ds_dx, ds_dx), dot(ds_dy, ds_dy)));
+    if (texture->mip_count > 0 && texels_per_pixel >= 2.0f) {
+        i32 level = hm::min((i32)floorf(log2f(texels_per_pixel)), texture->mip_count);
+        result.texture = &texture->mips[level - 1];
+        result.level = level;
+        result.scale = 1.0f / (f32)(1 << level);
+    }
+    return result;
+}
+
+/// @brief: A sub rect of base texels, min and max inclusive, to the texels of the selected level that cover it.
+auto inline to_mip_texel_rect(MipSelection mip, Rectangle2i rect) -> Rectangle2i {
+    Rectangle2i result;
+    result.min_x = rect.min_x >> mip.level;
+    result.min_y = rect.min_y >> mip.level;
+    result.max_x = hm::min(rect.max_x >> mip.level, mip.texture->width - 1);
+    result.max_y = hm::min(rect.max_y >> mip.level, mip.texture->height - 1);
+    return result;
+}
+
+/// @brief: Base texel coordinate to the selected level. Texel centers are at integer coordinates.
+auto inline to_mip_texel(f32 coordinate, f32 scale) -> f32 {
+    return (coordinate + 0.5f) * scale - 0.5f;
+}
+
+struct AppliedFramebuffer {
+    FrameBufferHandle handle;
+    ivec2 scale;
+};
+
+// The framebuffers applied to the platform buffer during one frame, in order.
+const i32 MaxAppliedFramebuffers = 8;
+struct FrameComposition {
+    AppliedFramebuffer applied[MaxAppliedFramebuffers];
+    i32 count;
+};
+
+// Size of the cells the platform buffer damage is tracked in
+const i32 DamageCellDim = 16;
+
+// A render recorded in pipelined mode. The group is a copy in the renderer's frame arena, so the engine can reuse
+// its memory as soon as render returns.
+struct PendingRender {
+    RenderGroup group;
+    FrameBufferHandle handle;
+    bool is_multithreaded;
+};
+
+// The render and apply_framebuffer calls of one frame, in call order within each kind.
+const i32 MaxPendingRenders = 8;
+struct PendingFrame {
+    PendingRender renders[MaxPendingRenders];
+    i32 render_count;
+    AppliedFramebuffer applies[MaxAppliedFramebuffers];
+    i32 apply_count;
+};
+
+// Framebuffers at least this large do not stay cached from one frame to the next, so their clears and composites
+// use streaming stores instead of evicting what the tiles render from.
+const u64 DefaultStreamingStoreMinSize = MegaBytes(6);
+
+// TODO: This should probably go to an arena
+struct SWRendererState {
+    // What the framebuffers are applied to and the platform presents
+    Framebuffer platform_buffer;
+    StackSwapBackList<Framebuffer, 5> framebuffers;
+    MemoryArena permanent;
+    MemoryArena transient;
+
+    SWTexture textures[MaxTextureId];
+
+    // Unchanged tiles are only re-applied if something under or over them changed
+    u64 frame_index;
+    FrameComposition previous_composition;
+    FrameComposition composition;
+    bool is_composition_broken; // This frame does not apply the same framebuffers as the previous one
+    bool has_skipped_tiles;
+    Array<bool> damage; // One per cell, true if the composite changes this frame
+    i32 damage_count_x;
+
+    u64 streaming_store_min_size;
+
+    // Pipelined mode, see RENDERER_SET_PIPELINED. Frames alternate between the two arenas: one holds the frame
+    // being recorded, the other the one the workers render.
+    bool is_pipelined;
+    bool is_pipelined_requested;
+    bool is_frame_in_flight;
+    MemoryArena frame_arenas[2];
+    u32 recording_arena_index;
+    PendingFrame recording;
+    PendingFrame in_flight;
+    ThreadContext* pipeline_thread_context;
+};
+
+static SWRendererState state = {};
+
+// The texture side of a bitmap, the same for every instance of a batch. Set up once per command.
+struct BitmapTexture {
+    i32 texture_id; // 0 draws the color instead
+    SWTexture* texture;
+    Rectangle2i uv_rect;                   // Base texels, min and max inclusive
+    Rectangle2i mip_uv_rects[MaxMipCount]; // uv_rect on levels 1 to mip_count
+};
+
+/// @brief: A zero uv_max samples the whole texture.
+auto inline setup_bitmap_texture(i32 texture_id, ivec2 uv_min, ivec2 uv_max) -> BitmapTexture {
+    BitmapTexture result;
+    result.texture_id = texture_id;
+    result.texture = &state.textures[texture_id];
+    result.uv_rect = { uv_min.x, uv_max.x, uv_min.y, uv_max.y };
+    if (uv_max.x == 0 || uv_max.y == 0) {
+        // Inclusive, x1 and y1 are clamped to it
+        result.uv_rect.max_x = result.texture->width - 1;
+        result.uv_rect.max_y = result.texture->height - 1;
+    }
+    for (i32 level = 1; level <= result.texture->mip_count; level++) {
+        MipSelection mip = { &result.texture->mips[level - 1], level, 1.0f / (f32)(1 << level) };
+        result.mip_uv_rects[level - 1] = to_mip_texel_rect(mip, result.uv_rect);
+    }
+    return result;
+}
+
+// The part of a bitmap's setup that depends on its offset, scale and rotation, the same for every tile it touches.
+struct BitmapInstance {
+    vec2 offset;
+    vec2 scale;
+    f32 rotation;
+    vec2 bl, tl, tr, br;  // Corners on screen
+    mat2 screen_to_model; // Inverse of rotation * scale, the identity if the quad has no area
+    vec2 texel_scale;     // Base level texels per scaled model unit, u and v
+    Rectangle2i rect;     // Rounded bounds of the corners, not clipped to a tile
+};
+
+/// @brief: Sets up 8 instances at a time. The arrays are read 8 wide, like the padded ones of a batch.
+/// AVX2 has no sine or cosine, so only those are taken lane by lane.
+/// @return: One bit per lane whose rect overlaps clip_rect.
+static auto setup_bitmap_instances(const BitmapTexture* bitmap, Quadrilateral quad, //
+    const f32* offset_x, const f32* offset_y,                                        //
+    const f32* scale_x, const f32* scale_y, const f32* rotation,                     //
+    Rectangle2i clip_rect, BitmapInstance* result) -> u32 {
+    const i32 Lane_Count = 8;
+    f32 cos_r[Lane_Count];
+    f32 sin_r[Lane_Count];
+    for (i32 i = 0; i < Lane_Count; i++) {
+        cos_r[i] = cosf(rotation[i]);
+        sin_r[i] = sinf(rotation[i]);
+    }
+    f32x8 cos_v8 = _mm256_loadu_ps(cos_r);
+    f32x8 sin_v8 = _mm256_loadu_ps(sin_r);
+    f32x8 offset_x_v8 = _mm256_loadu_ps(offset_x);
+    f32x8 offset_y_v8 = _mm256_loadu_ps(offset_y);
+    f32x8 scale_x_v8 = _mm256_loadu_ps(scale_x);
+    f32x8 scale_y_v8 = _mm256_loadu_ps(scale_y);
+
+    // Model to screen is mat2_rotate(rotation) * mat2_scale(scale), its inverse the adjugate over the determinant
+    f32x8 xx_v8 = _mm256_mul_ps(cos_v8, scale_x_v8);
+    f32x8 xy_v8 = _mm256_mul_ps(sin_v8, scale_y_v8);
+    f32x8 yx_v8 = _mm256_mul_ps(_mm256_xor_ps(sin_v8, _mm256_set1_ps(-0.0f)), scale_x_v8);
+    f32x8 yy_v8 = _mm256_mul_ps(cos_v8, scale_y_v8);
+    f32x8 det_v8 = _mm256_sub_ps(_mm256_mul_ps(xx_v8, yy_v8), _mm256_mul_ps(xy_v8, yx_v8));
+    f32x8 abs_det_v8 = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), det_v8);
+    f32x8 has_area_v8 = _mm256_cmp_ps(abs_det_v8, _mm256_set1_ps(hm::Epsilon), _CMP_GE_OQ);
+    f32x8 inv_det_v8 = _mm256_div_ps(_mm256_set1_ps(1.0f), det_v8);
+    // Without an area there is no inverse, inverse() gives the identity then
+    const f32x8 one_v8 = _mm256_set1_ps(1.0f);
+    f32x8 inv_xx_v8 = _mm256_blendv_ps(one_v8, _mm256_mul_ps(yy_v8, inv_det_v8), has_area_v8);
+    f32x8 inv_xy_v8 = _mm256_and_ps(has_area_v8, _mm256_mul_ps(_mm256_xor_ps(xy_v8, _mm256_set1_ps(-0.0f)), inv_det_v8));
+    f32x8 inv_yx_v8 = _mm256_and_ps(has_area_v8, _mm256_mul_ps(_mm256_xor_ps(yx_v8, _mm256_set1_ps(-0.0f)), inv_det_v8));
+    f32x8 inv_yy_v8 = _mm256_blendv_ps(one_v8, _mm256_mul_ps(xx_v8, inv_det_v8), has_area_v8);
+
+    // Corners are quad * M + offset
+    f32x8 corners_x_v8[4];
+    f32x8 corners_y_v8[4];
+    vec2 corners[4] = { quad.bl, quad.tl, quad.tr, quad.br };
+    for (i32 i = 0; i < 4; i++) {
+        f32x8 p_x_v8 = _mm256_set1_ps(corners[i].x);
+        f32x8 p_y_v8 = _mm256_set1_ps(corners[i].y);
+        corners_x_v8[i] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p_x_v8, xx_v8), _mm256_mul_ps(p_y_v8, yx_v8)), offset_x_v8);
+        corners_y_v8[i] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p_x_v8, xy_v8), _mm256_mul_ps(p_y_v8, yy_v8)), offset_y_v8);
+    }
+
+    // Like round_f32_to_i32, half away from zero
+    const f32x8 zero_v8 = _mm256_setzero_ps();
+    const f32x8 half_v8 = _mm256_set1_ps(0.5f);
+    const f32x8 minus_half_v8 = _mm256_set1_ps(-0.5f);
+    f32x8 bounds_v8[4] = {
+        _mm256_min_ps(_mm256_min_ps(corners_x_v8[0], corners_x_v8[1]), _mm256_min_ps(corners_x_v8[2], corners_x_v8[3])),
+        _mm256_max_ps(_mm256_max_ps(corners_x_v8[0], corners_x_v8[1]), _mm256_max_ps(corners_x_v8[2], corners_x_v8[3])),
+        _mm256_min_ps(_mm256_min_ps(corners_y_v8[0], corners_y_v8[1]), _mm256_min_ps(corners_y_v8[2], corners_y_v8[3])),
+        _mm256_max_ps(_mm256_max_ps(corners_y_v8[0], corners_y_v8[1]), _mm256_max_ps(corners_y_v8[2], corners_y_v8[3])),
+    };
+    i32x8 rect_v8[4];
+    for (i32 i = 0; i < 4; i++) {
+        f32x8 round_v8 = _mm256_blendv_ps(minus_half_v8, half_v8, _mm256_cmp_ps(bounds_v8[i], zero_v8, _CMP_GE_OQ));
+        rect_v8[i] = _mm256_cvttps_epi32(_mm256_add_ps(bounds_v8[i], round_v8));
+    }
+    // Clipped to clip_rect, a lane has pixels left if its spans are not empty
+    i32x8 overlaps_v8 = _mm256_and_si256(                                   //
+        _mm256_cmpgt_epi32(rect_v8[1], _mm256_set1_epi32(clip_rect.min_x)), //
+        _mm256_cmpgt_epi32(_mm256_set1_epi32(clip_rect.max_x), rect_v8[0]));
+    overlaps_v8 = _mm256_and_si256(overlaps_v8, _mm256_and_si256(           //
+        _mm256_cmpgt_epi32(rect_v8[3], _mm256_set1_epi32(clip_rect.min_y)), //
+        _mm256_cmpgt_epi32(_mm256_set1_epi32(clip_rect.max_y), rect_v8[2])));
+    overlaps_v8 = _mm256_and_si256(overlaps_v8, _mm256_and_si256( //
+        _mm256_cmpgt_epi32(rect_v8[1], rect_v8[0]),               //
+        _mm256_cmpgt_epi32(rect_v8[3], rect_v8[2])));
+
+    // The sub rect over the quad's size, in model units scaled by the instance
+    f32x8 model_width_v8 = _mm256_set1_ps(quad.br.x - quad.bl.x);
+    f32x8 model_height_v8 = _mm256_set1_ps(quad.tr.y - quad.br.y);
+    f32x8 range_u_v8 = _mm256_set1_ps((f32)(bitmap->uv_rect.max_x - bitmap->uv_rect.min_x));
+    f32x8 range_v_v8 = _mm256_set1_ps((f32)(bitmap->uv_rect.max_y - bitmap->uv_rect.min_y));
+    f32x8 texel_scale_u_v8 = _mm256_div_ps(_mm256_mul_ps(scale_x_v8, range_u_v8), _mm256_mul_ps(model_width_v8, scale_x_v8));
+    f32x8 texel_scale_v_v8 = _mm256_div_ps(_mm256_mul_ps(scale_y_v8, range_v_v8), _mm256_mul_ps(model_height_v8, scale_y_v8));
+
+    // Transposed to one BitmapInstance per lane
+    const i32 Field_Count = 14;
+    f32x8 fields_v8[Field_Count] = {
+        inv_xx_v8, inv_xy_v8, inv_yx_v8, inv_yy_v8,                          //
+        corners_x_v8[0], corners_y_v8[0], corners_x_v8[1], corners_y_v8[1], //
+        corners_x_v8[2], corners_y_v8[2], corners_x_v8[3], corners_y_v8[3], //
+        texel_scale_u_v8, texel_scale_v_v8,                                  //
+    };
+    f32 fields[Field_Count][Lane_Count];
+    for (i32 i = 0; i < Field_Count; i++) {
+        _mm256_storeu_ps(fields[i], fields_v8[i]);
+    }
+    i32 rects[4][Lane_Count];
+    for (i32 i = 0; i < 4; i++) {
+        _mm256_storeu_si256((i32x8*)rects[i], rect_v8[i]);
+    }
+    for (i32 i = 0; i < Lane_Count; i++) {
+        BitmapInstance* instance = &result[i];
+        instance->offset = vec2(offset_x[i], offset_y[i]);
+        instance->scale = vec2(scale_x[i], scale_y[i]);
+        instance->rotation = rotation[i];
+        instance->screen_to_model = mat2(fields[0][i], fields[1][i], fields[2][i], fields[3][i]);
+        instance->bl = vec2(fields[4][i], fields[5][i]);
+        instance->tl = vec2(fields[6][i], fields[7][i]);
+        instance->tr = vec2(fields[8][i], fields[9][i]);
+        instance->br = vec2(fields[10][i], fields[11][i]);
+        instance->texel_scale = vec2(fields[12][i], fields[13][i]);
+        instance->rect = { rects[0][i], rects[1][i], rects[2][i], rects[3][i] };
+    }
+    return (u32)_mm256_movemask_ps(_mm256_castsi256_ps(overlaps_v8));
+}
+
+/// @brief: One bitmap, set up as the first lane of 8 so it draws exactly like the same instance of a batch.
+auto inline setup_bitmap_instance(const BitmapTexture* bitmap, Quadrilateral quad, vec2 offset, vec2 scale,
+    f32 rotation) -> BitmapInstance {
+    f32 offset_x[8] = { offset.x };
+    f32 offset_y[8] = { offset.y };
+    f32 scale_x[8] = { scale.x };
+    f32 scale_y[8] = { scale.y };
+    f32 rotations[8] = { rotation };
+    BitmapInstance result[8];
+    setup_bitmap_instances(bitmap, quad, offset_x, offset_y, scale_x, scale_y, rotations, {}, result);
+    return result[0];
+}
+
+DebugTable* global_debug_table = nullptr;
+
+internal void resize_frame_buffer(Framebuffer* buffer, int width, int height) {
+    // TODO: Bulletproof this
+    // Maybe don't free first, free after, then free first if that fails. I.e. if allocate_pages fails.
+    if (buffer->memory) {
+        free_pages(buffer->memory);
+    }
+    if (buffer->z_buffer.m_data) {
+        free_pages(buffer->z_buffer.m_data);
+    }
+    if (buffer->z_blocks.m_data) {
+        free_pages(buffer->z_blocks.m_data);
+    }
+
+    u64 entry_count = width * height;
+    buffer->width = width;
+    buffer->height = height;
+    buffer->bytes_per_pixel = BYTES_PER_PIXEL;
+    buffer->memory_size = buffer->bytes_per_pixel * (buffer->width * buffer->height);
+    buffer->memory = allocate_pages(buffer->memory_size);
+    buffer->z_buffer.init((f32*)allocate_pages(entry_count * sizeof(f32)), entry_count);
+    buffer->z_block_count_x = z_block_count(width);
+    u64 z_block_count_total = (u64)buffer->z_block_count_x * z_block_count(height);
+    buffer->z_blocks.init((f32*)allocate_pages(z_block_count_total * sizeof(f32)), z_block_count_total);
+    buffer->pitch = buffer->width * buffer->bytes_per_pixel;
+    // Pages are at least 4KB aligned on every platform
+    Assert(is_aligned(buffer->memory, KiloBytes(4)));
+}
+
+auto square(f32 v) -> f32 {
+    return v * v;
+}
+
+auto square_root(f32 v) -> f32 {
+    return sqrtf(v);
+}
+
+inline auto srgb_to_linear1_2(vec4 color) -> color_v8 {
+    color_v8 result = {};
+
+    f32 r = srgb_to_linear1_lookup(color.r);
+    f32 g = srgb_to_linear1_lookup(color.g);
+    f32 b = srgb_to_linear1_lookup(color.b);
+    f32 a = color.a;
+
+    result.r = _mm256_set1_ps(r);
+    result.g = _mm256_set1_ps(g);
+    result.b = _mm256_set1_ps(b);
+    result.a = _mm256_set1_ps(a);
+
+    return result;
+}
+
+// Blends a constant color over a span of pixels: Cout = Cf * Af + Cb * (1 - Af).
+// color is sRGB in [0, 1], with straight alpha. It is premultiplied once per span, so each pixel only
+// costs Cb * (1 - Af) + the constant. The SIMD versions decode and encode through the same tables as the scalar one,
+// so a translucent panel comes out the same color on every CPU.
+typedef void (*blend_span_fn)(u32* dest, i32 count, vec4 color);
+
+static void blend_span_scalar(u32* dest, i32 count, vec4 color) {
+    vec4 color_l1 = premultiply_alpha(srgb_to_linear1(color));
+    f32 one_minus_a = 1.0f - color_l1.a;
+    for (i32 i = 0; i < count; i++) {
+        vec4 dest_l1 = unpack4x8_srgb255_to_linear1(dest[i]);
+        dest[i] = linear1_to_packed8x4_srgb255(color_l1 + dest_l1 * one_minus_a);
+    }
+}
+
+static void blend_span_avx2(u32* dest, i32 count, vec4 color) {
+    // Cf * Af is the same for every pixel
+    vec4 color_l1 = premultiply_alpha(srgb_to_linear1(color));
+    color_v8 src_v8;
+    src_v8.r = _mm256_set1_ps(color_l1.r);
+    src_v8.g = _mm256_set1_ps(color_l1.g);
+    src_v8.b = _mm256_set1_ps(color_l1.b);
+    src_v8.a = _mm256_set1_ps(color_l1.a);
+    const i32x8 lane_index_v8 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    // Panels mostly cover flat or repeating backgrounds, like the check pattern clear. A block of pixels that is the
+    // same as the previous one gets the same result, without decoding and encoding it again.
+    // Zero blends to the color.
+    i32x8 previous_dest_v8 = _mm256_setzero_si256();
+    i32x8 previous_result_v8 = linear1_to_packed8x4_srgb255_v8(src_v8);
+
+    for (i32 i = 0; i < count; i += AVX2_LANE_COUNT) {
+        i32* d = (i32*)(dest + i);
+        i32x8 mask_v8 = _mm256_cmpgt_epi32(_mm256_set1_epi32(count - i), lane_index_v8);
+        i32x8 packed_v8 = count - i >= AVX2_LANE_COUNT ? _mm256_loadu_si256((i32x8*)d) : _mm256_maskload_epi32(d, mask_v8);
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(packed_v8, previous_dest_v8)) == -1) {
+            packed_v8 = previous_result_v8;
+        }
+        else {
+            previous_dest_v8 = packed_v8;
+            packed_v8 = linear1_to_packed8x4_srgb255_v8(blend_premultiplied_v8(unpack4x8_srgb255_to_linear1_v8(packed_v8), src_v8));
+            previous_result_v8 = packed_v8;
+        }
+
+        if (count - i >= AVX2_LANE_COUNT) {
+            _mm256_storeu_si256((i32x8*)d, packed_v8);
+        }
+        else {
+            _mm256_maskstore_epi32(d, mask_v8, packed_v8);
+        }
+    }
+}
+
+static void blend_span_avx512(u32* dest, i32 count, vec4 color) {
+    vec4 color_l1 = premultiply_alpha(srgb_to_linear1(color));
+    const f32x16 src_r_v16 = _mm512_set1_ps(color_l1.r);
+    const f32x16 src_g_v16 = _mm512_set1_ps(color_l1.g);
+    const f32x16 src_b_v16 = _mm512_set1_ps(color_l1.b);
+    const f32x16 src_a_v16 = _mm512_set1_ps(color_l1.a);
+    const f32x16 one_minus_a_v16 = _mm512_set1_ps(1.0f - color_l1.a);
+    // Like blend_span_avx2, a block that is the same as the previous one reuses its result. Zero blends to the color.
+    color_v16 src_v16 = { src_r_v16, src_g_v16, src_b_v16, src_a_v16 };
+    i32x16 previous_dest_v16 = _mm512_setzero_si512();
+    i32x16 previous_result_v16 = linear1_to_packed8x4_srgb255_v16(src_v16);
+
+    for (i32 i = 0; i < count; i += AVX512_LANE_COUNT) {
+        i32 remaining = hm::min(count - i, AVX512_LANE_COUNT);
+        __mmask16 mask = (__mmask16)((1u << remaining) - 1);
+        i32x16 packed_v16 = _mm512_maskz_loadu_epi32(mask, dest + i);
+
+        if (_mm512_cmpeq_epi32_mask(packed_v16, previous_dest_v16) == 0xFFFF) {
+            packed_v16 = previous_result_v16;
+        }
+        else {
+            previous_dest_v16 = packed_v16;
+            color_v16 blended = unpack4x8_srgb255_to_linear1_v16(packed_v16);
+            blended.r = _mm512_fmadd_ps(blended.r, one_minus_a_v16, src_r_v16);
+            blended.g = _mm512_fmadd_ps(blended.g, one_minus_a_v16, src_g_v16);
+            blended.b = _mm512_fmadd_ps(blended.b, one_minus_a_v16, src_b_v16);
+            blended.a = _mm512_fmadd_ps(blended.a, one_minus_a_v16, src_a_v16);
+            packed_v16 = linear1_to_packed8x4_srgb255_v16(blended);
+            previous_result_v16 = packed_v16;
+        }
+        _mm512_mask_storeu_epi32(dest + i, mask, packed_v16);
+    }
+}
+
+global_variable blend_span_fn blend_span = blend_span_scalar;
+
+/// @brief: Fills a span with color, blending it over the existing pixels if it is translucent.
+static void fill_span(u32* dest, i32 count, vec4 color, u32 color_packed) {
+    if (count <= 0 || color.a <= 0.0f) {
+        return;
+    }
+    if (color.a >= 1.0f) {
+        set_memory_u32(dest, color_packed, count);
+    }
+    else {
+        blend_span(dest, count, color);
+    }
+}
+
+static void draw_rectangle(Rectangle2f rect, vec4 color, f32 border_thickness, vec4 border_color, Tile* tile, Framebuffer* buffer) {
+    if (color.a <= 0.0f) {
+        return;
+    }
+    u32 color_packed = pack_color_8x4(color);
+
+    i32 min_x = round_f32_to_i32(rect.min_x);
+    i32 max_x = round_f32_to_i32(rect.max_x);
+    i32 min_y = round_f32_to_i32(rect.min_y);
+    i32 max_y = round_f32_to_i32(rect.max_y);
+
+    i32 border_min_x = min_x;
+    i32 border_max_x = max_x;
+    i32 border_min_y = min_y;
+    i32 border_max_y = max_y;
+
+    min_x += round_f32_to_i32(border_thickness);
+    max_x -= round_f32_to_i32(border_thickness);
+    min_y += round_f32_to_i32(border_thickness);
+    max_y -= round_f32_to_i32(border_thickness);
+
+    min_x = hm::max(tile->rect.min_x, min_x);
+    max_x = hm::min(tile->rect.max_x, max_x);
+    min_y = hm::max(tile->rect.min_y, min_y);
+    max_y = hm::min(tile->rect.max_y, max_y);
+
+    border_min_x = hm::max(tile->rect.min_x, border_min_x);
+    border_max_x = hm::min(tile->rect.max_x, border_max_x);
+    border_min_y = hm::max(tile->rect.min_y, border_min_y);
+    border_max_y = hm::min(tile->rect.max_y, border_max_y);
+
+    if (border_min_y < border_max_y && border_min_x < border_max_x) {
+        tile->is_dirty = true;
+    }
+    else {
+        return;
+    }
+
+    // The tile may only see part of the border, so keep every span inside the clipped border rect.
+    i32 border_width = border_max_x - border_min_x;
+    i32 left_border_count = hm::min(hm::max(min_x - border_min_x, 0), border_width);
+    i32 x_count = hm::min(hm::max(max_x - min_x, 0), border_width - left_border_count);
+    i32 right_border_count = border_width - left_border_count - x_count;
+    i32 top_border_end = hm::min(hm::max(min_y, border_min_y), border_max_y);
+    i32 bottom_border_start = hm::min(hm::max(max_y, top_border_end), border_max_y);
+
+    u32 border_color_packed = pack_color_8x4(border_color);
+    for (i32 y = border_min_y; y < top_border_end; y++) {
+        u32* dest = (u32*)((u8*)buffer->memory + (y * buffer->pitch) + (border_min_x * buffer->bytes_per_pixel));
+        fill_span(dest, border_width, border_color, border_color_packed);
+    }
+    for (i32 y = top_border_end; y < bottom_border_start; y++) {
+        u32* dest = (u32*)((u8*)buffer->memory + (y * buffer->pitch) + (border_min_x * buffer->bytes_per_pixel));
+        fill_span(dest, left_border_count, border_color, border_color_packed);
+        dest += left_border_count;
+        fill_span(dest, x_count, color, color_packed);
+        dest += x_count;
+        fill_span(dest, right_border_count, border_color, border_color_packed);
+    }
+    for (i32 y = bottom_border_start; y < border_max_y; y++) {
+        u32* dest = (u32*)((u8*)buffer->memory + (y * buffer->pitch) + (border_min_x * buffer->bytes_per_pixel));
+        fill_span(dest, border_width, border_color, border_color_packed);
+    }
+}
+
+/// @brief: Writes count pixels alternating between first and second, starting with first.
+static void fill_check_pattern_row(u32* dest, i32 count, u32 first, u32 second, bool is_streaming) {
+    i32 i = 0;
+    // Streaming stores need aligned addresses, the unaligned head is written with plain stores either way.
+    for (; i < count && !is_aligned(dest + i, 32); i++) {
+        dest[i] = i % 2 == 0 ? first : second;
+    }
+    i32x8 pattern_v8 = i % 2 == 0 ? _mm256_setr_epi32(first, second, first, second, first, second, first, second)
+                                  : _mm256_setr_epi32(second, first, second, first, second, first, second, first);
+    for (; i + AVX2_LANE_COUNT <= count; i += AVX2_LANE_COUNT) {
+        if (is_streaming) {
+            _mm256_stream_si256((__m256i*)(dest + i), pattern_v8);
+        }
+        else {
+            _mm256_store_si256((__m256i*)(dest + i), pattern_v8);
+        }
+    }
+    for (; i < count; i++) {
+        dest[i] = i % 2 == 0 ? first : second;
+    }
+}
+
+static void clear_check_pattern(Framebuffer& buffer, Tile* tile, vec4 color1, vec4 color2, bool is_streaming) {
+    tile->is_dirty = true;
+    u32 packed_color1 = pack_color_8x4(color1);
+    u32 packed_color2 = pack_color_8x4(color2);
+
+    i32 min_x = hm::max(tile->rect.min_x, 0);
+    i32 max_x = hm::min(tile->rect.max_x, buffer.width);
+    i32 min_y = hm::max(tile->rect.min_y, 0);
+    i32 max_y = hm::min(tile->rect.max_y, buffer.height);
+
+    for (i32 y = min_y; y < max_y; y++) {
+        u32* pixel_dest = ((u32*)buffer.memory + (y * buffer.width)) + (min_x);
+        bool is_even = (y + min_x) % 2 == 0;
+        fill_check_pattern_row(pixel_dest, max_x - min_x, //
+            is_even ? packed_color1 : packed_color2,        //
+            is_even ? packed_color2 : packed_color1, is_streaming);
+    }
+    if (is_streaming) {
+        _mm_sfence();
+    }
+    tile->is_depth_initialized = false;
+}
+
+static auto clear(i32 client_width, i32 client_height, vec4 color, Tile* tile, Framebuffer* buffer, bool is_streaming) {
+    tile->is_depth_initialized = false;
+    if (tile->is_initialized == false) {
+        tile->is_dirty = true;
+        tile->is_initialized = true;
+    }
+    else if (tile->is_dirty == false) {
+        return;
+    }
+    u32 color_packed = pack_color_8x4(color);
+
+    for (i32 y = tile->rect.min_y; y < tile->rect.max_y; y++) {
+        u32* dest = (u32*)((u8*)buffer->memory + (y * buffer->pitch) + (tile->rect.min_x * buffer->bytes_per_pixel));
+        if (is_streaming) {
+            set_memory_u32_stream(dest, color_packed, tile->rect.max_x - tile->rect.min_x);
+        }
+        else {
+            set_memory_u32(dest, color_packed, tile->rect.max_x - tile->rect.min_x);
+        }
+    }
+    if (is_streaming) {
+        _mm_sfence();
+    }
+
+    tile->is_dirty = false;
+}
+
+auto color_channel_f32_to_u8(f32 channel) {
+    u8 result = 0;
+    if (channel < 0) {
+        result = 0;
+    }
+    else if (channel > 255.0f) {
+        result = 255;
+    }
+    else {
+        result = (u8)(channel + 0.5f);
+    }
+    return result;
+}
+
+static auto draw_bitmap_scalar(BitmapTexture* bitmap, //
+    Quadrilateral quad,                                  //
+    BitmapInstance* instance,                            //
+    vec4 color,                                          //
+    f32 border_thickness, vec4 border_color,             //
+    Tile* tile, Framebuffer* buffer                      //
+) -> void {
+    f32 model_width = (quad.br.x - quad.bl.x);
+    f32 model_height = (quad.tr.y - quad.br.y);
+
+    vec2 translation = instance->offset;
+    f32 rotation = instance->rotation;
+    mat2 M_c_to_m = instance->screen_to_model;
+
+    vec2 bl_c = instance->bl;
+    vec2 tl_c = instance->tl;
+    vec2 tr_c = instance->tr;
+    vec2 br_c = instance->br;
+
+    vec2 bl_border_c = {}, tl_border_c = {}, tr_border_c = {}, br_border_c = {};
+    if (border_thickness > 0.0f) {
+        mat2 rot_mat = mat2_rotate(rotation);
+        mat2 scale_mat = mat2_scale(instance->scale);
+
+        bl_border_c = quad.bl * scale_mat;
+        tl_border_c = quad.tl * scale_mat;
+        tr_border_c = quad.tr * scale_mat;
+        br_border_c = quad.br * scale_mat;
+
+        bl_border_c = bl_border_c + vec2(border_thickness, border_thickness);
+        tl_border_c = tl_border_c + vec2(border_thickness, -border_thickness);
+        tr_border_c = tr_border_c + vec2(-border_thickness, -border_thickness);
+        br_border_c = br_border_c + vec2(-border_thickness, border_thickness);
+
+        bl_border_c = bl_border_c * rot_mat;
+        tl_border_c = tl_border_c * rot_mat;
+        tr_border_c = tr_border_c * rot_mat;
+        br_border_c = br_border_c * rot_mat;
+
+        bl_border_c = bl_border_c + translation;
+        tl_border_c = tl_border_c + translation;
+        tr_border_c = tr_border_c + translation;
+        br_border_c = br_border_c + translation;
+    }
+
+    i32 min_x = hm::max(instance->rect.min_x, tile->rect.min_x);
+    i32 max_x = hm::min(instance->rect.max_x, tile->rect.max_x);
+    i32 min_y = hm::max(instance->rect.min_y, tile->rect.min_y);
+    i32 max_y = hm::min(instance->rect.max_y, tile->rect.max_y);
+
+    vec2 edge1 = tl_c - bl_c;
+    vec2 edge2 = tr_c - tl_c;
+    vec2 edge3 = br_c - tr_c;
+    vec2 edge4 = bl_c - br_c;
+
+    vec2 edge1_border = tl_border_c - bl_border_c;
+    vec2 edge2_border = tr_border_c - tl_border_c;
+    vec2 edge3_border = br_border_c - tr_border_c;
+    vec2 edge4_border = bl_border_c - br_border_c;
+
+    SWTexture* texture = bitmap->texture;
+    i32 u_min = bitmap->uv_rect.min_x;
+    i32 u_max = bitmap->uv_rect.max_x;
+    i32 v_min = bitmap->uv_rect.min_y;
+    i32 v_max = bitmap->uv_rect.max_y;
+
+    f32 scaled_du = instance->texel_scale.x;
+    f32 scaled_dv = instance->texel_scale.y;
+
+    vec2 ds_dx = vec2(M_c_to_m.xx * scaled_du, M_c_to_m.xy * scaled_dv);
+    vec2 ds_dy = vec2(M_c_to_m.yx * scaled_du, M_c_to_m.yy * scaled_dv);
+
+    // model space, but scaled!
+    f32 start_x_m = (f32)min_x - translation.x;
+    f32 start_y_m = (f32)min_y - translation.y;
+
+    // Start coordinate for the "current" texel row in texel space
+    f32 texel_u_row = (start_x_m * M_c_to_m.xx + start_y_m * M_c_to_m.yx + model_width * 0.5f) * scaled_du + (f32)u_min;
+    f32 texel_v_row = (start_x_m * M_c_to_m.xy + start_y_m * M_c_to_m.yy + model_height * 0.5f) * scaled_dv + (f32)v_min;
+
+    // Minified, sample a smaller level instead. The sub rect shrinks with it.
+    MipSelection mip = select_mip_level(texture, ds_dx, ds_dy);
+    if (mip.level > 0) {
+        texture = mip.texture;
+        Rectangle2i uv_rect = bitmap->mip_uv_rects[mip.level - 1];
+        u_min = uv_rect.min_x;
+        u_max = uv_rect.max_x;
+        v_min = uv_rect.min_y;
+        v_max = uv_rect.max_y;
+        ds_dx = ds_dx * mip.scale;
+        ds_dy = ds_dy * mip.scale;
+        texel_u_row = to_mip_texel(texel_u_row, mip.scale);
+        texel_v_row = to_mip_texel(texel_v_row, mip.scale);
+    }
+
+    // Fills an untextured bitmap and tints a textured one. White leaves the texels as they are.
+    vec4 default_color_l1 = premultiply_alpha(srgb_to_linear1(color));
+    bool is_white = color.r >= 1.0f && color.g >= 1.0f && color.b >= 1.0f && color.a >= 1.0f;
+    vec4 border_color_l1 = premultiply_alpha(srgb_to_linear1(border_color));
+    for (int y = min_y; y < max_y; y++) {
+        f32 u = texel_u_row;
+        f32 v = texel_v_row;
+        for (int x = min_x; x < max_x; x++) {
+            u8* dest = ((u8*)buffer->memory + (y * buffer->pitch) + (x * buffer->bytes_per_pixel));
+            u32* pixel = (u32*)dest;
+
+            vec2 camera_point{ (f32)x + 0.5f, (f32)y + 0.5f };
+
+            bool is_inside = true;
+            if (rotation != 0.0f) {
+                f32 dot1 = dot(camera_point - bl_c, edge1);
+                f32 dot2 = dot(camera_point - tl_c, edge2);
+                f32 dot3 = dot(camera_point - tr_c, edge3);
+                f32 dot4 = dot(camera_point - br_c, edge4);
+                is_inside = dot1 > 0 && dot2 > 0 && dot3 > 0 && dot4 > 0;
+            }
+
+            if (is_inside) {
+                bool is_on_border = false;
+                if (border_thickness > 0.0f) {
+                    f32 dot1 = dot(camera_point - bl_border_c, edge1_border);
+                    f32 dot2 = dot(camera_point - tl_border_c, edge2_border);
+                    f32 dot3 = dot(camera_point - tr_border_c, edge3_border);
+                    f32 dot4 = dot(camera_point - br_border_c, edge4_border);
+                    is_on_border = !(dot1 > 0 && dot2 > 0 && dot3 > 0 && dot4 > 0);
+                }
+
+                // Premultiplied, like the textures
+                vec4 src_color_l1;
+                if (is_on_border) {
+                    src_color_l1 = border_color_l1;
+                }
+                else {
+                    if (bitmap->texture_id == 0) {
+                        src_color_l1 = default_color_l1;
+                    }
+                    else {
+                        i32 x0 = (i32)floor(u);
+                        i32 y0 = (i32)floor(v);
+                        i32 x1 = x0 + 1;
+                        i32 y1 = y0 + 1;
+
+                        x0 = clamp(x0, u_min, u_max);
+                        y0 = clamp(y0, v_min, v_max);
+                        x1 = clamp(x1, u_min, u_max);
+                        y1 = clamp(y1, v_min, v_max);
+
+                        f32 u_frac = clamp(u - (f32)x0, 0.0f, 1.0f);
+                        f32 v_frac = clamp(v - (f32)y0, 0.0f, 1.0f);
+
+                        Assert(texture->bytes_per_pixel == 4);
+                        u32* data = (u32*)texture->data;
+                        // Bilinear filtering
+                        vec4 texel00_l1 = unpack4x8_srgb255_to_linear1(data[texel_index(texture, x0, y0)]);
+                        vec4 texel10_l1 = unpack4x8_srgb255_to_linear1(data[texel_index(texture, x1, y0)]);
+                        vec4 texel01_l1 = unpack4x8_srgb255_to_linear1(data[texel_index(texture, x0, y1)]);
+                        vec4 texel11_l1 = unpack4x8_srgb255_to_linear1(data[texel_index(texture, x1, y1)]);
+
+                        src_color_l1 = lerp(                       //
+                            lerp(texel00_l1, u_frac, texel10_l1),  //
+                            v_frac,                                //
+                            lerp(texel01_l1, u_frac, texel11_l1)); //
+                        if (!is_white) {
+                            src_color_l1 = src_color_l1 * default_color_l1;
+                        }
+                    }
+                }
+
+                // Cout = Cf + Cb * (1 - Af). Transparent texels leave the pixel alone, opaque ones do not read it.
+                if (src_color_l1.a <= 0.0f) {
+                }
+                else if (src_color_l1.a >= 1.0f) {
+                    *pixel = linear1_to_packed8x4_srgb255(src_color_l1);
+                }
+                else {
+                    vec4 dest_l1 = unpack4x8_srgb255_to_linear1(*pixel);
+                    *pixel = linear1_to_packed8x4_srgb255(src_color_l1 + dest_l1 * (1.0f - src_color_l1.a));
+                }
+            }
+            u += ds_dx.x;
+            v += ds_dx.y;
+        }
+        texel_u_row += ds_dy.x;
+        texel_v_row += ds_dy.y;
+    }
+}
+
+static auto draw_bitmap_avx2(                //
+    BitmapTexture* bitmap,                   //
+    Quadrilateral quad,                      //
+    BitmapInstance* instance,                //
+    vec4 color,                              //
+    f32 border_thickness, vec4 border_color, //
+    Tile* tile, Framebuffer* buffer          //
+) -> void {
+    f32 model_width = (quad.br.x - quad.bl.x);
+    f32 model_height = (quad.tr.y - quad.br.y);
+
+    vec2 translation = instance->offset;
+    f32 rotation = instance->rotation;
+    mat2 M_c_to_m = instance->screen_to_model;
+
+    vec2 bl_c = instance->bl;
+    vec2 tl_c = instance->tl;
+    vec2 tr_c = instance->tr;
+    vec2 br_c = instance->br;
+
+    i32 min_x = hm::max(instance->rect.min_x, tile->rect.min_x);
+    i32 max_x = hm::min(instance->rect.max_x, tile->rect.max_x);
+    i32 min_y = hm::max(instance->rect.min_y, tile->rect.min_y);
+    i32 max_y = hm::min(instance->rect.max_y, tile->rect.max_y);
+
+    vec2 edge1 = tl_c - bl_c;
+    vec2 edge2 = tr_c - tl_c;
+    vec2 edge3 = br_c - tr_c;
+    vec2 edge4 = bl_c - br_c;
+
+    SWTexture* texture = bitmap->texture;
+    i32 u_min = bitmap->uv_rect.min_x;
+    i32 u_max = bitmap->uv_rect.max_x;
+    i32 v_min = bitmap->uv_rect.min_y;
+    i32 v_max = bitmap->uv_rect.max_y;
+
+    f32 scaled_du = instance->texel_scale.x;
+    f32 scaled_dv = instance->texel_scale.y;
+
+    vec2 ds_dx = vec2(M_c_to_m.xx * scaled_du, M_c_to_m.xy * scaled_dv);
+    vec2 ds_dy = vec2(M_c_to_m.yx * scaled_du, M_c_to_m.yy * scaled_dv);
+
+    // model space, but scaled!
+    f32 start_x_m = (f32)min_x - translation.x;
+    f32 start_y_m = (f32)min_y - translation.y;
+
+    // Start coordinate for the "current" texel row in texel space
+    f32 texel_u_row = (start_x_m * M_c_to_m.xx + start_y_m * M_c_to_m.yx + model_width * 0.5f) * scaled_du + (f32)u_min;
+    f32 texel_v_row = (start_x_m * M_c_to_m.xy + start_y_m * M_c_to_m.yy + model_height * 0.5f) * scaled_dv + (f32)v_min;
+
+    // Minified, sample a smaller level instead. The sub rect shrinks with it.
+    MipSelection mip = select_mip_level(texture, ds_dx, ds_dy);
+    if (mip.level > 0) {
+        texture = mip.texture;
+        Rectangle2i uv_rect = bitmap->mip_uv_rects[mip.level - 1];
+        u_min = uv_rect.min_x;
+        u_max = uv_rect.max_x;
+        v_min = uv_rect.min_y;
+        v_max = uv_rect.max_y;
+        ds_dx = ds_dx * mip.scale;
+        ds_dy = ds_dy * mip.scale;
+        texel_u_row = to_mip_texel(texel_u_row, mip.scale);
+        texel_v_row = to_mip_texel(texel_v_row, mip.scale);
+    }
+
+    // Premultiplied, like the textures. Fills an untextured bitmap and tints a textured one.
+    color_v8 default_color_l1_v8 = srgb_to_linear1_2(color);
+    default_color_l1_v8.r = _mm256_mul_ps(default_color_l1_v8.r, default_color_l1_v8.a);
+    default_color_l1_v8.g = _mm256_mul_ps(default_color_l1_v8.g, default_color_l1_v8.a);
+    default_color_l1_v8.b = _mm256_mul_ps(default_color_l1_v8.b, default_color_l1_v8.a);
+    bool is_white = color.r >= 1.0f && color.g >= 1.0f && color.b >= 1.0f && color.a >= 1.0f;
+    for (int y = min_y; y < max_y; y++) {
+        /*f32 u = texel_u_row;*/
+        /*f32 v = texel_v_row;*/
+
+        __m256 u_v8 = _mm256_set1_ps(texel_u_row);
+        __m256 v_v8 = _mm256_set1_ps(texel_v_row);
+        {
+            __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+            __m256 du_dx_v8 = _mm256_set1_ps(ds_dx.x);
+            __m256 dv_dx_v8 = _mm256_set1_ps(ds_dx.y);
+            u_v8 = _mm256_fmadd_ps(lane, du_dx_v8, u_v8);
+            v_v8 = _mm256_fmadd_ps(lane, dv_dx_v8, v_v8);
+        }
+        const u32 Lane_Width = 8;
+        const __m256i lane_index_v8 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        for (int x = min_x; x < max_x; x += Lane_Width) {
+            u8* dest = ((u8*)buffer->memory + (y * buffer->pitch) + (x * buffer->bytes_per_pixel));
+            u32* pixel = (u32*)dest;
+
+            __m256i is_inside_v8 = _mm256_set1_epi32(0xFFFFFFFF);
+            if (rotation != 0.0f) {
+                // Pixel centers, like draw_bitmap_scalar
+                __m256 cp_x_v8 = _mm256_set1_ps((f32)x + 0.5f);
+                __m256 incr_v8 = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+                cp_x_v8 = _mm256_add_ps(cp_x_v8, incr_v8);
+                __m256 cp_y_v8 = _mm256_set1_ps((f32)y + 0.5f);
+
+                __m256 dot1_v8;
+                {
+                    __m256 x_v8 = _mm256_set1_ps(bl_c.x);
+                    __m256 y_v8 = _mm256_set1_ps(bl_c.y);
+
+                    x_v8 = _mm256_sub_ps(cp_x_v8, x_v8);
+                    y_v8 = _mm256_sub_ps(cp_y_v8, y_v8);
+
+                    __m256 edge1_x_v8 = _mm256_set1_ps(edge1.x);
+                    __m256 edge1_y_v8 = _mm256_set1_ps(edge1.y);
+
+                    dot1_v8 = dot(x_v8, y_v8, edge1_x_v8, edge1_y_v8);
+                }
+                __m256 dot2_v8;
+                {
+                    __m256 x_v8 = _mm256_set1_ps(tl_c.x);
+                    __m256 y_v8 = _mm256_set1_ps(tl_c.y);
+
+                    x_v8 = _mm256_sub_ps(cp_x_v8, x_v8);
+                    y_v8 = _mm256_sub_ps(cp_y_v8, y_v8);
+
+                    __m256 edge2_x_v8 = _mm256_set1_ps(edge2.x);
+                    __m256 edge2_y_v8 = _mm256_set1_ps(edge2.y);
+
+                    dot2_v8 = dot(x_v8, y_v8, edge2_x_v8, edge2_y_v8);
+                }
+                __m256 dot3_v8;
+                {
+                    __m256 x_v8 = _mm256_set1_ps(tr_c.x);
+                    __m256 y_v8 = _mm256_set1_ps(tr_c.y);
+
+                    x_v8 = _mm256_sub_ps(cp_x_v8, x_v8);
+                    y_v8 = _mm256_sub_ps(cp_y_v8, y_v8);
+
+                    __m256 edge3_x_v8 = _mm256_set1_ps(edge3.x);
+                    __m256 edge3_y_v8 = _mm256_set1_ps(edge3.y);
+
+                    dot3_v8 = dot(x_v8, y_v8, edge3_x_v8, edge3_y_v8);
+                }
+                __m256 dot4_v8;
+                {
+                    __m256 x_v8 = _mm256_set1_ps(br_c.x);
+                    __m256 y_v8 = _mm256_set1_ps(br_c.y);
+
+                    x_v8 = _mm256_sub_ps(cp_x_v8, x_v8);
+                    y_v8 = _mm256_sub_ps(cp_y_v8, y_v8);
+
+                    __m256 edge4_x_v8 = _mm256_set1_ps(edge4.x);
+                    __m256 edge4_y_v8 = _mm256_set1_ps(edge4.y);
+
+                    dot4_v8 = dot(x_v8, y_v8, edge4_x_v8, edge4_y_v8);
+                }
+                // is_inside = dot1 > 0 && dot2 > 0 && dot3 > 0 && dot4 > 0;
+                {
+                    const __m256 zero_v8 = _mm256_setzero_ps();
+                    __m256 is_inside_dot1_v8 = _mm256_cmp_ps(dot1_v8, zero_v8, _CMP_GT_OQ);
+                    __m256 is_inside_dot2_v8 = _mm256_cmp_ps(dot2_v8, zero_v8, _CMP_GT_OQ);
+                    __m256 is_inside_dot3_v8 = _mm256_cmp_ps(dot3_v8, zero_v8, _CMP_GT_OQ);
+                    __m256 is_inside_dot4_v8 = _mm256_cmp_ps(dot4_v8, zero_v8, _CMP_GT_OQ);
+
+                    __m256 is_inside_v8f = _mm256_and_ps(is_inside_dot1_v8, is_inside_dot2_v8);
+                    is_inside_v8f = _mm256_and_ps(is_inside_v8f, is_inside_dot3_v8);
+                    is_inside_v8f = _mm256_and_ps(is_inside_v8f, is_inside_dot4_v8);
+                    is_inside_v8 = _mm256_castps_si256(is_inside_v8f);
+                }
+            }
+
+            color_v8 src_color_l1_v8 = {};
+            if (bitmap->texture_id == 0) {
+                src_color_l1_v8 = default_color_l1_v8;
+            }
+            else {
+                __m256i one_v8 = _mm256_set1_epi32(1);
+                __m256i x0_v8 = _mm256_cvttps_epi32(_mm256_floor_ps(u_v8));
+                __m256i y0_v8 = _mm256_cvttps_epi32(_mm256_floor_ps(v_v8));
+                __m256i x1_v8 = _mm256_add_epi32(x0_v8, one_v8);
+                __m256i y1_v8 = _mm256_add_epi32(y0_v8, one_v8);
+
+                __m256 u_frac_v8 = _mm256_sub_ps(u_v8, _mm256_floor_ps(u_v8));
+                __m256 v_frac_v8 = _mm256_sub_ps(v_v8, _mm256_floor_ps(v_v8));
+
+                x0_v8 = clamp_i32_v8(u_min, x0_v8, u_max);
+                x1_v8 = clamp_i32_v8(u_min, x1_v8, u_max);
+                y0_v8 = clamp_i32_v8(v_min, y0_v8, v_max);
+                y1_v8 = clamp_i32_v8(v_min, y1_v8, v_max);
+
+                Assert(texture->bytes_per_pixel == 4);
+                u32* data = (u32*)texture->data;
+                // Bilinear filtering
+                __m256i texel_idx_00_v8 = texel_index_v8(texture, x0_v8, y0_v8);
+                __m256i texel_idx_10_v8 = texel_index_v8(texture, x1_v8, y0_v8);
+                __m256i texel_idx_01_v8 = texel_index_v8(texture, x0_v8, y1_v8);
+                __m256i texel_idx_11_v8 = texel_index_v8(texture, x1_v8, y1_v8);
+
+                __m256i texel00_srgba255_v8 = _mm256_i32gather_epi32((const i32*)data, texel_idx_00_v8, sizeof(u32));
+                __m256i texel01_srgba255_v8 = _mm256_i32gather_epi32((const i32*)data, texel_idx_01_v8, sizeof(u32));
+                __m256i texel10_srgba255_v8 = _mm256_i32gather_epi32((const i32*)data, texel_idx_10_v8, sizeof(u32));
+                __m256i texel11_srgba255_v8 = _mm256_i32gather_epi32((const i32*)data, texel_idx_11_v8, sizeof(u32));
+
+                color_v8 texel00_v8 = get_color(texel00_srgba255_v8);
+                color_v8 texel10_v8 = get_color(texel10_srgba255_v8);
+                color_v8 texel01_v8 = get_color(texel01_srgba255_v8);
+                color_v8 texel11_v8 = get_color(texel11_srgba255_v8);
+
+                src_color_l1_v8 = lerp(                      //
+                    lerp(texel00_v8, u_frac_v8, texel10_v8), //
+                    v_frac_v8,                               //
+                    lerp(texel01_v8, u_frac_v8, texel11_v8)  //
+                );
+                if (!is_white) {
+                    src_color_l1_v8.r = _mm256_mul_ps(src_color_l1_v8.r, default_color_l1_v8.r);
+                    src_color_l1_v8.g = _mm256_mul_ps(src_color_l1_v8.g, default_color_l1_v8.g);
+                    src_color_l1_v8.b = _mm256_mul_ps(src_color_l1_v8.b, default_color_l1_v8.b);
+                    src_color_l1_v8.a = _mm256_mul_ps(src_color_l1_v8.a, default_color_l1_v8.a);
+                }
+            }
+
+            // Only lanes inside the quad and the span, with some coverage, are written
+            __m256i in_span_v8 = _mm256_cmpgt_epi32(_mm256_set1_epi32(max_x - x), lane_index_v8);
+            __m256 is_visible_v8 = _mm256_cmp_ps(src_color_l1_v8.a, _mm256_setzero_ps(), _CMP_GT_OQ);
+            __m256i write_mask_v8 = _mm256_and_si256(_mm256_and_si256(is_inside_v8, in_span_v8), _mm256_castps_si256(is_visible_v8));
+            i32 write_bits = _mm256_movemask_ps(_mm256_castsi256_ps(write_mask_v8));
+            if (write_bits != 0) {
+                // Premultiplied, so opaque lanes are the texel itself and do not need the destination
+                __m256 is_opaque_v8 = _mm256_cmp_ps(src_color_l1_v8.a, _mm256_set1_ps(1.0f), _CMP_GE_OQ);
+                i32 opaque_bits = _mm256_movemask_ps(is_opaque_v8);
+                color_v8 result_color_v8 = src_color_l1_v8;
+                if ((write_bits & opaque_bits) != write_bits) {
+                    __m256i destination_v8 = _mm256_maskload_epi32((const i32*)pixel, write_mask_v8);
+                    result_color_v8 = blend_premultiplied_v8(get_color(destination_v8), src_color_l1_v8);
+                }
+
+                __m256i pixel_v8 = pack4x8_linear1_to_srgb255(result_color_v8);
+                if (write_bits == 0xFF) {
+                    _mm256_storeu_si256((__m256i*)pixel, pixel_v8);
+                }
+                else {
+                    _mm256_maskstore_epi32((i32*)pixel, write_mask_v8, pixel_v8);
+                }
+            }
+
+            {
+                __m256 du_dx_v8 = _mm256_set1_ps(Lane_Width * ds_dx.x);
+                __m256 dv_dx_v8 = _mm256_set1_ps(Lane_Width * ds_dx.y);
+                u_v8 = _mm256_add_ps(u_v8, du_dx_v8);
+                v_v8 = _mm256_add_ps(v_v8, dv_dx_v8);
+            }
+        }
+        texel_u_row += ds_dy.x;
+        texel_v_row += ds_dy.y;
+    }
+}
+
+typedef void (*draw_bitmap_fn)(BitmapTexture* bitmap, //
+    Quadrilateral quad,                                //
+    BitmapInstance* instance,                          //
+    vec4 color,                                        //
+    f32 border_thickness, vec4 border_color,           //
+    Tile* tile, Framebuffer* buffer);
+// Both stay available so they can be benchmarked against each other.
+global_variable draw_bitmap_fn draw_bitmap = draw_bitmap_avx2;
+
+/// @brief: Draws the instances of a batch that touch the tile. A tile is binned the whole batch, so 8 instances at
+/// a time are set up and tested against the tile first, and only the ones that overlap it are drawn. The texture is
+/// set up once for all of them.
+static auto draw_bitmap_batch(RenderEntryBitmapBatch* entry, Tile* tile, Framebuffer* buffer) -> void {
+    BitmapBatchInstances instances = get_bitmap_batch_instances(entry);
+    BitmapTexture bitmap = setup_bitmap_texture(entry->texture_id, entry->uv_min, entry->uv_max);
+
+    // The arrays are padded to whole registers
+    for (i32 i = 0; i < entry->count; i += 8) {
+        BitmapInstance setups[8];
+        u32 overlap_bits = setup_bitmap_instances(&bitmap, entry->quad, //
+            instances.offset_x + i, instances.offset_y + i,              //
+            instances.scale_x + i, instances.scale_y + i,                //
+            instances.rotation + i, tile->rect, setups);
+        // The padding lanes are not instances
+        overlap_bits &= (1u << hm::min(entry->count - i, 8)) - 1;
+        while (overlap_bits != 0) {
+            i32 lane = (i32)_tzcnt_u32(overlap_bits);
+            overlap_bits &= overlap_bits - 1;
+            draw_bitmap(&bitmap, entry->quad, &setups[lane], instances.color[i + lane], 0.0f, vec4(0.0f), tile, buffer);
+        }
+    }
+}
+
+// Copies one glyph of a glyph run to whole pixels, no filtering. color is sRGB with straight alpha, like the
+// bitmaps', and multiplies the texels, the atlas holds the coverage.
+typedef void (*blit_glyph_fn)(GlyphRunGlyph glyph, vec4 color, SWTexture* texture, Tile* tile, Framebuffer* buffer);
+
+/// @brief: The pixels of the glyph inside the tile. Empty if min >= max.
+auto inline glyph_tile_rect(GlyphRunGlyph glyph, Tile* tile) -> Rectangle2i {
+    Rectangle2i result;
+    result.min_x = hm::max(glyph.x, tile->rect.min_x);
+    result.max_x = hm::min(glyph.x + (glyph.u_max - glyph.u_min), tile->rect.max_x);
+    result.min_y = hm::max(glyph.y, tile->rect.min_y);
+    result.max_y = hm::min(glyph.y + (glyph.v_max - glyph.v_min), tile->rect.max_y);
+    return result;
+}
+
+static auto blit_glyph_scalar(GlyphRunGlyph glyph, vec4 color, SWTexture* texture, Tile* tile, Framebuffer* buffer) -> void {
+    Rectangle2i rect = glyph_tile_rect(glyph, tile);
+    if (rect.min_x >= rect.max_x || rect.min_y >= rect.max_y) {
+        return;
+    }
+
+    // Premultiplied, like the textures. White leaves the texels as they are.
+    vec4 color_l1 = premultiply_alpha(srgb_to_linear1(color));
+    bool is_white = color.r >= 1.0f && color.g >= 1.0f && color.b >= 1.0f && color.a >= 1.0f;
+    u32* data = (u32*)texture->data;
+    for (i32 y = rect.min_y; y < rect.max_y; y++) {
+        i32 v = glyph.v_min + (y - glyph.y);
+        i32 u = glyph.u_min + (rect.min_x - glyph.x);
+        u32* pixel = (u32*)((u8*)buffer->memory + (y * buffer->pitch) + (rect.min_x * buffer->bytes_per_pixel));
+        for (i32 x = rect.min_x; x < rect.max_x; x++, u++, pixel++) {
+            u32 texel = data[texel_index(texture, u, v)];
+            u32 coverage = texel >> 24;
+            if (coverage == 0) {
+                continue;
+            }
+            if (is_white && coverage == 0xFF) {
+                *pixel = texel;
+                continue;
+            }
+
+            vec4 src_color_l1 = unpack4x8_srgb255_to_linear1(texel) * color_l1;
+            if (src_color_l1.a >= 1.0f) {
+                *pixel = linear1_to_packed8x4_srgb255(src_color_l1);
+            }
+            else {
+                vec4 dest_l1 = unpack4x8_srgb255_to_linear1(*pixel);
+                *pixel = linear1_to_packed8x4_srgb255(src_color_l1 + dest_l1 * (1.0f - src_color_l1.a));
+            }
+        }
+    }
+}
+
+static auto blit_glyph_avx2(GlyphRunGlyph glyph, vec4 color, SWTexture* texture, Tile* tile, Framebuffer* buffer) -> void {
+    Rectangle2i rect = glyph_tile_rect(glyph, tile);
+    if (rect.min_x >= rect.max_x || rect.min_y >= rect.max_y) {
+        return;
+    }
+
+    color_v8 color_l1_v8 = srgb_to_linear1_2(color);
+    color_l1_v8.r = _mm256_mul_ps(color_l1_v8.r, color_l1_v8.a);
+    color_l1_v8.g = _mm256_mul_ps(color_l1_v8.g, color_l1_v8.a);
+    color_l1_v8.b = _mm256_mul_ps(color_l1_v8.b, color_l1_v8.a);
+    bool is_white = color.r >= 1.0f && color.g >= 1.0f && color.b >= 1.0f && color.a >= 1.0f;
+
+    const i32* data = (const i32*)texture->data;
+    const __m256i lane_index_v8 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i zero_v8 = _mm256_setzero_si256();
+    const __m256i opaque_v8 = _mm256_set1_epi32(0xFF);
+    for (i32 y = rect.min_y; y < rect.max_y; y++) {
+        __m256i v_v8 = _mm256_set1_epi32(glyph.v_min + (y - glyph.y));
+        for (i32 x = rect.min_x; x < rect.max_x; x += AVX2_LANE_COUNT) {
+            u32* pixel = (u32*)((u8*)buffer->memory + (y * buffer->pitch) + (x * buffer->bytes_per_pixel));
+            __m256i in_span_v8 = _mm256_cmpgt_epi32(_mm256_set1_epi32(rect.max_x - x), lane_index_v8);
+            __m256i u_v8 = _mm256_add_epi32(_mm256_set1_epi32(glyph.u_min + (x - glyph.x)), lane_index_v8);
+
+            // Lanes past the glyph would read past the atlas row, they are not gathered
+            __m256i texel_v8 = _mm256_mask_i32gather_epi32(zero_v8, data, texel_index_v8(texture, u_v8, v_v8), in_span_v8, sizeof(u32));
+            __m256i coverage_v8 = _mm256_srli_epi32(texel_v8, 24);
+            __m256i write_mask_v8 = _mm256_andnot_si256(_mm256_cmpeq_epi32(coverage_v8, zero_v8), in_span_v8);
+            i32 write_bits = _mm256_movemask_ps(_mm256_castsi256_ps(write_mask_v8));
+            if (write_bits == 0) {
+                continue;
+            }
+
+            __m256i pixel_v8;
+            i32 opaque_bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(coverage_v8, opaque_v8)));
+            if (is_white && (write_bits & opaque_bits) == write_bits) {
+                // Already in the framebuffer format
+                pixel_v8 = texel_v8;
+            }
+            else {
+                color_v8 src_color_l1_v8 = get_color(texel_v8);
+                src_color_l1_v8.r = _mm256_mul_ps(src_color_l1_v8.r, color_l1_v8.r);
+                src_color_l1_v8.g = _mm256_mul_ps(src_color_l1_v8.g, color_l1_v8.g);
+                src_color_l1_v8.b = _mm256_mul_ps(src_color_l1_v8.b, color_l1_v8.b);
+                src_color_l1_v8.a = _mm256_mul_ps(src_color_l1_v8.a, color_l1_v8.a);
+                __m256i destination_v8 = _mm256_maskload_epi32((const i32*)pixel, write_mask_v8);
+                pixel_v8 = pack4x8_linear1_to_srgb255(blend_premultiplied_v8(get_color(destination_v8), src_color_l1_v8));
+            }
+
+            if (write_bits == 0xFF) {
+                _mm256_storeu_si256((__m256i*)pixel, pixel_v8);
+            }
+            else {
+                _mm256_maskstore_epi32((i32*)pixel, write_mask_v8, pixel_v8);
+            }
+        }
+    }
+}
+
+// Both stay available so they can be benchmarked against each other.
+global_variable blit_glyph_fn blit_glyph = blit_glyph_avx2;
+
+static auto draw_glyph_run(RenderEntryGlyphRun* entry, Tile* tile, Framebuffer* buffer) -> void {
+    SWTexture* texture = &state.textures[entry->texture_id];
+    Assert(texture->data && texture->bytes_per_pixel == 4);
+    GlyphRunGlyph* glyphs = get_glyph_run_glyphs(entry);
+    for (i32 i = 0; i < entry->count; i++) {
+        Assert(glyphs[i].u_max <= texture->width && glyphs[i].v_max <= texture->height);
+        blit_glyph(glyphs[i], entry->color, texture, tile, buffer);
+    }
+}
+
+/// @brief: Picks the fastest variant the CPU supports of every kernel that has several.
+auto software_renderer_select_kernels() -> void {
+    select_triangle_rasterizer(TriangleRasterizer_HalfSpace);
+    if (cpu_supports_avx512f()) {
+        blend_span = blend_span_avx512;
+        transform_vertices = transform_vertices_avx512;
+        light_vertices = light_vertices_avx512;
+    }
+    else {
+        blend_span = blend_span_avx2;
+        transform_vertices = transform_vertices_avx2;
+        light_vertices = light_vertices_avx2;
+    }
+    draw_bitmap = draw_bitmap_avx2;
+    blit_glyph = blit_glyph_avx2;
+}
+
+/// @brief: Platform independent part of the renderer init. The platform creates the platform buffer after.
+auto software_renderer_init(PlatformApi* platform_api, MemoryBlock* memory) -> void {
+    initialize_core_lib();
+    initialize_renderer_lib();
+    software_renderer_select_kernels();
+    log_info("Using software renderer.");
+
+    HM_ASSERT(memory != nullptr);
+    HM_ASSERT(memory->data != nullptr);
+    state.permanent.init(memory->data, memory->size);
+    state.streaming_store_min_size = DefaultStreamingStoreMinSize;
+    state.frame_arenas[0] = *state.permanent.allocate_arena(MegaBytes(10));
+    state.frame_arenas[1] = *state.permanent.allocate_arena(MegaBytes(10));
+    state.transient = state.frame_arenas[0];
+
+    Platform = platform_api;
+    global_debug_table = Platform->debug_table;
+
+    SWTexture* null_texture = &state.textures[0];
+    null_texture->height = 1;
+    null_texture->width = 1;
+    null_texture->count = 1;
+    null_texture->bytes_per_pixel = BYTES_PER_PIXEL;
+    null_texture->size = null_texture->count * null_texture->bytes_per_pixel;
+    null_texture->data = allocate<u32>(state.permanent);
+    u32* data = (u32*)null_texture->data;
+    *data = pack_color_8x4(vec4(1.0f, 0.0f, 0.0f, 1.0f));
+}
+
+/// @brief: Fills in the description of one level, without the texels.
+static auto init_texture_level(SWTexture* texture, i32 width, i32 height, TextureLayout layout) -> void {
+    texture->width = width;
+    texture->height = height;
+    texture->bytes_per_pixel = BYTES_PER_PIXEL;
+    texture->count = width * height;
+    texture->pitch = width * texture->bytes_per_pixel;
+    texture->layout = layout;
+    texture->block_count_x = blocks4x4_block_count(width);
+    i32 stored_count = texture->count;
+    if (layout == TextureLayout_Blocks4x4) {
+        stored_count = blocks4x4_texel_count(width, height);
+    }
+    texture->size = stored_count * texture->bytes_per_pixel;
+}
+
+/// @brief: Allocates the texels of one level. Partial blocks of the 4x4 layout are padded, the samplers never read the padding.
+static auto allocate_texture_level(SWTexture* texture, i32 width, i32 height, TextureLayout layout) -> void {
+    init_texture_level(texture, width, height, layout);
+    // Cache line aligned, so every 4x4 block is exactly one line
+    texture->data = state.permanent.allocate(texture->size, { .alignment = 64, .flags = ArenaPushFlag_ClearToZero });
+}
+
+/// @brief: Box filters every level from the one before it, in linear space, until one side is 1 texel.
+static auto generate_mips(SWTexture* texture) -> void {
+    i32 mip_count = 0;
+    for (i32 w = texture->width, h = texture->height; (w > 1 || h > 1) && mip_count < MaxMipCount; mip_count++) {
+        w = hm::max(w / 2, 1);
+        h = hm::max(h / 2, 1);
+    }
+    texture->mip_count = mip_count;
+    texture->mips = allocate<SWTexture>(state.permanent, mip_count);
+
+    SWTexture* source = texture;
+    for (i32 level = 0; level < mip_count; level++) {
+        SWTexture* mip = &texture->mips[level];
+        allocate_texture_level(mip, hm::max(source->width / 2, 1), hm::max(source->height / 2, 1), texture->layout);
+
+        u32* src = (u32*)source->data;
+        u32* dest = (u32*)mip->data;
+        for (i32 y = 0; y < mip->height; y++) {
+            i32 y0 = hm::min(2 * y, source->height - 1);
+            i32 y1 = hm::min(2 * y + 1, source->height - 1);
+            for (i32 x = 0; x < mip->width; x++) {
+                i32 x0 = hm::min(2 * x, source->width - 1);
+                i32 x1 = hm::min(2 * x + 1, source->width - 1);
+                vec4 sum = unpack4x8_srgb255_to_linear1(src[texel_index(source, x0, y0)]) +
+                           unpack4x8_srgb255_to_linear1(src[texel_index(source, x1, y0)]) +
+                           unpack4x8_srgb255_to_linear1(src[texel_index(source, x0, y1)]) +
+                           unpack4x8_srgb255_to_linear1(src[texel_index(source, x1, y1)]);
+                dest[texel_index(mip, x, y)] = linear1_to_packed8x4_srgb255(sum * 0.25f);
+            }
+        }
+        source = mip;
+    }
+}
+
+// What software_renderer_add_texture stores textures as
+global_variable TextureLayout default_texture_layout = TextureLayout_Blocks4x4;
+
+/// @brief: Like software_renderer_add_texture, but with the layout picked by the caller.
+/// PixelFormat_SoftwareNative data is already in TextureLayout_Blocks4x4 and is used where it is.
+auto software_renderer_add_texture_with_layout(i32 texture_id, void* data, i32 width, i32 height, i32 bytes_per_pixel,
+    PixelFormat pixel_format, TextureLayout layout) -> bool {
+    Assert(texture_id != 0);
+    if (texture_id >= MaxTextureId) {
+        // TODO: Return empty texture
+        log_error("Max texture id is %d, %d provided.", MaxTextureId, texture_id);
+        HM_ASSERT(false);
+        return false;
+    }
+
+    SWTexture* texture = &state.textures[texture_id];
+    if (texture->data == nullptr) {
+        Assert(bytes_per_pixel == BYTES_PER_PIXEL);
+        if (pixel_format == PixelFormat_SoftwareNative) {
+            // Baked by the asset builder, nothing to convert or copy
+            Assert(layout == TextureLayout_Blocks4x4);
+            Assert(((u64)data & 3) == 0);
+            init_texture_level(texture, width, height, TextureLayout_Blocks4x4);
+            texture->data = data;
+        }
+        else {
+            allocate_texture_level(texture, width, height, layout);
+
+            // The framebuffers are ARGB, like Windows wants them. Premultiplied once here, so the samplers blend
+            // with Cf + Cb * (1 - Af) and filter without dark fringes.
+            u32* source = (u32*)data;
+            u32* dest = (u32*)texture->data;
+            for (i32 y = 0; y < height; y++) {
+                for (i32 x = 0; x < width; x++) {
+                    dest[texel_index(texture, x, y)] = rgba8_to_software_native_texel(*source++);
+                }
+            }
+        }
+        generate_mips(texture);
+        log_info("Texture added");
+        return true;
+    }
+    else {
+        return false;
+    }
+}
+
+RENDERER_ADD_TEXTURE(software_renderer_add_texture) {
+    return software_renderer_add_texture_with_layout(texture_id, data, width, height, bytes_per_pixel, pixel_format,
+        default_texture_layout);
+}
+
+// Screen space geometry of one tri-mesh command, shared by every tile that renders it.
+struct MeshGeometry {
+    Array<ScreenMesh> instances;
+};
+
+struct TransformMeshInstanceJob {
+    RenderEntryTriMesh* entry;
+    MeshInstance* instance;
+    ProjectedMeshInstance projected;
+    ScreenMesh* result;
+    MemoryArena* arena;
+    i32 width;
+    i32 height;
+};
+
+static PLATFORM_WORK_QUEUE_CALLBACK(execute_project_mesh_instance_job) {
+    TransformMeshInstanceJob* job = (TransformMeshInstanceJob*)data;
+    Assert(job);
+    Assert(job->entry);
+
+    TIMED_BLOCK("project_mesh_instance");
+    RenderEntryTriMesh* entry = job->entry;
+    job->projected = project_mesh_instance(        //
+        entry->model,                              //
+        *job->instance,                            //
+        entry->world_to_view,                      //
+        entry->view_to_clip,                       //
+        entry->camera_position,                    //
+        entry->is_lit ? &entry->lights : nullptr,  //
+        job->width, job->height, *job->arena);
+}
+
+static PLATFORM_WORK_QUEUE_CALLBACK(execute_clip_mesh_instance_job) {
+    TransformMeshInstanceJob* job = (TransformMeshInstanceJob*)data;
+    Assert(job);
+
+    TIMED_BLOCK("clip_mesh_instance");
+    *job->result = clip_mesh_instance(job->projected, *job->instance, job->width, job->height, *job->arena);
+}
+
+static auto execute_transform_mesh_instance_jobs(ThreadContext* thread_context, bool is_multithreaded,
+    List<TransformMeshInstanceJob>& jobs, platform_work_queue_callback* callback) -> void {
+    for (i32 i = 0; i < jobs.count(); i++) {
+        if (is_multithreaded) {
+            Platform->add_work_queue_entry(thread_context->queue, callback, &jobs[i]);
+        }
+        else {
+            callback(thread_context, &jobs[i]);
+        }
+    }
+    if (is_multithreaded) {
+        Platform->complete_all_work(thread_context);
+    }
+}
+
+/// @brief: Transforms, culls, clips and projects every mesh instance in the group exactly once, before
+/// any tile is rendered. Each instance gets its own sub arenas so the work can be spread across the queue.
+/// Runs in two rounds: how much clipping can grow is only bounded per triangle that is clipped, so the clip
+/// arenas are sized once the projection has set those triangles aside.
+/// @return: One MeshGeometry per command, indexed like group->sort_entries_offset. Empty for non-mesh commands.
+auto transform_meshes(ThreadContext* thread_context, bool is_multithreaded, RenderGroup* group, Framebuffer* buffer,
+    MemoryArena* arena) -> Array<MeshGeometry> {
+    auto result = Array<MeshGeometry>::create(group->sort_entries_offset.count(), arena);
+
+    u32 job_count = 0;
+    for (u32 i = 0; i < result.count(); i++) {
+        auto* header = (RenderGroupEntryHeader*)(group->push_buffer + group->sort_entries_offset[i]);
+        if (header->type == RenderCommands_RenderEntryTriMesh || header->type == RenderCommands_RenderEntryTriMeshWireframe) {
+            auto* entry = (RenderEntryTriMesh*)((u8*)header + sizeof(*header));
+            job_count += entry->instances.count();
+        }
+    }
+    if (job_count == 0) {
+        return result;
+    }
+
+    auto jobs = List<TransformMeshInstanceJob>::create(job_count, *arena);
+    for (u32 i = 0; i < result.count(); i++) {
+        auto* header = (RenderGroupEntryHeader*)(group->push_buffer + group->sort_entries_offset[i]);
+        if (header->type != RenderCommands_RenderEntryTriMesh && header->type != RenderCommands_RenderEntryTriMeshWireframe) {
+            continue;
+        }
+        auto* entry = (RenderEntryTriMesh*)((u8*)header + sizeof(*header));
+        result[i].instances = Array<ScreenMesh>::create(entry->instances.count(), arena);
+        const MeshLights* lights = entry->is_lit ? &entry->lights : nullptr;
+        u64 arena_size = project_mesh_instance_arena_size(entry->model.vertex_count, entry->model.triangles.count(),
+            lights);
+        for (u32 instance_idx = 0; instance_idx < entry->instances.count(); instance_idx++) {
+            TransformMeshInstanceJob job = {};
+            job.entry = entry;
+            job.instance = &entry->instances[instance_idx];
+            job.result = &result[i].instances[instance_idx];
+            job.arena = arena->allocate_arena(arena_size);
+            job.width = buffer->width;
+            job.height = buffer->height;
+            jobs.push(job);
+        }
+    }
+    execute_transform_mesh_instance_jobs(thread_context, is_multithreaded, jobs, execute_project_mesh_instance_job);
+
+    for (i32 i = 0; i < jobs.count(); i++) {
+        jobs[i].arena = arena->allocate_arena(clip_mesh_instance_arena_size(jobs[i].projected));
+    }
+    execute_transform_mesh_instance_jobs(thread_context, is_multithreaded, jobs, execute_clip_mesh_instance_job);
+
+    return result;
+}
+
+auto execute_render_commands(i32 job_id, RenderGroup* group, //
+    Array<MeshGeometry> meshes,                              //
+    i32* command_indices, i32 command_count,                 //
+    Tile* tile,                                              //
+    Framebuffer* framebuffer, MemoryArena& transient) -> void {
+
+    bool is_large_framebuffer = (u64)framebuffer->memory_size >= state.streaming_store_min_size;
+    for (i32 i = 0; i < command_count; i++) {
+        // Streaming a clear that later commands blend over would make them read it back from memory
+        bool is_streaming_clear = is_large_framebuffer && i == command_count - 1;
+        u64 base_address = group->sort_entries_offset[command_indices[i]];
+        RenderGroupEntryHeader* header = (RenderGroupEntryHeader*)(group->push_buffer + base_address);
+        base_address += sizeof(RenderGroupEntryHeader);
+
+        void* data = (u8*)header + sizeof(*header);
+        switch (header->type) {
+        case RenderCommands_RenderEntryClear: {
+            TIMED_BLOCK("render_entry_clear");
+            RenderEntryClear* entry = (RenderEntryClear*)data;
+            clear(framebuffer->width, framebuffer->height, entry->color, tile, framebuffer, is_streaming_clear);
+            base_address += sizeof(*entry);
+        } break;
+        case RenderCommands_RenderEntryClearCheckPattern: {
+            TIMED_BLOCK("clear_check_pattern");
+            auto* entry = (RenderEntryClearCheckPattern*)data;
+            clear_check_pattern(*framebuffer, tile, entry->color1, entry->color2, is_streaming_clear);
+            base_address += sizeof(*entry);
+        } break;
+        case RenderCommands_RenderEntryLine: {
+            TIMED_BLOCK("render_entry_line");
+            RenderEntryLine* entry = (RenderEntryLine*)data;
+            render_line_gambetta(entry->start, entry->end, entry->color, tile->rect, *framebuffer, transient);
+            base_address += sizeof(*entry);
+        } break;
+        case RenderCommands_RenderEntryCircle: {
+            TIMED_BLOCK("render_entry_circle");
+            auto entry = (RenderEntryCircle*)data;
+            render_circle_bresenham(entry->P, entry->radius, entry->color, tile->rect, *framebuffer);
+            base_address += sizeof(*entry);
+        } break;
+        case RenderCommands_RenderEntryFilledCircle: {
+            TIMED_BLOCK("render_filled_circle");
+            auto entry = (RenderEntryFilledCircle*)data;
+            render_filled_circle_bresenham(entry->P, entry->radius, entry->color, tile->rect, *framebuffer);
+            base_address += sizeof(*entry);
+        } break;
+        case RenderCommands_RenderEntryTriangle: {
+            TIMED_BLOCK("render_entry_triangle");
+            auto entry = (RenderEntryTriangle*)data;
+            render_triangle_writeframe_gambetta(entry->P0, entry->P1, entry->P2, entry->color, tile->rect, *framebuffer, transient);
+            base_address += sizeof(*entry);
+        } break;
+        case RenderCommands_RenderEntryFilledTriangle: {
+            TIMED_BLOCK("render_entry_filled_triangle");
+            auto entry = (RenderEntryFilledTriangle*)data;
+            initialize_tile_depth(*framebuffer, tile);
+            render_triangle_filled(entry->P0, entry->P1, entry->P2, entry->color, tile->rect, *framebuffer, transient);
+            base_address += sizeof(*entry);
+        } break;
+        case RenderCommands_RenderEntryShadedTriangle: {
+            TIMED_BLOCK("render_entry_shaded_triangle");
+            auto entry = (RenderEntryShadedTriangle*)data;
+            render_shaded_triangle_gambetta(entry->P0, entry->P1, entry->P2, entry->h0, entry->h1, entry->h2,
+                entry->color, tile->rect, *framebuffer, transient);
+            base_address += sizeof(*entry);
+        } break;
+        case RenderCommands_RenderEntryTriMesh: {
+            TIMED_BLOCK("render_entry_tri_mesh");
+            auto entry = (RenderEntryTriMesh*)data;
+            initialize_tile_depth(*framebuffer, tile);
+            for (const auto& mesh : meshes[command_indices[i]].instances) {
+                render_screen_mesh(mesh, false, tile->rect, *framebuffer, transient);
+            }
+            base_address += sizeof(*entry);
+        } break;
+        case RenderCommands_RenderEntryTriMeshWireframe: {
+            TIMED_BLOCK("render_entry_wireframe");
+            auto entry = (RenderEntryTriMesh*)data;
+            for (const auto& mesh : meshes[command_indices[i]].instances) {
+                render_screen_mesh(mesh, true, tile->rect, *framebuffer, transient);
+            }
+            base_address += sizeof(*entry);
+        } break;
+        case RenderCommands_RenderEntryBitmap: {
+            TIMED_BLOCK("render_entry_bitmap");
+            auto* entry = (RenderEntryBitmap*)data;
+            BitmapTexture bitmap = setup_bitmap_texture(entry->texture_id, entry->uv_min, entry->uv_max);
+            BitmapInstance instance = setup_bitmap_instance(&bitmap, entry->quad, entry->offset, entry->scale, entry->rotation);
+            draw_bitmap(&bitmap, entry->quad, &instance, entry->color,  //
+                entry->border_thickness, entry->border_color, //
+                tile, framebuffer);
+            base_address += sizeof(*entry);
+        } break;
+        case RenderCommands_RenderEntryBitmapBatch: {
+            TIMED_BLOCK("render_entry_bitmap_batch");
+            auto* entry = (RenderEntryBitmapBatch*)data;
+            draw_bitmap_batch(entry, tile, framebuffer);
+            base_address += sizeof(*entry) + bitmap_batch_instances_size(entry->count);
+        } break;
+        case RenderCommands_RenderEntryGlyphRun: {
+            TIMED_BLOCK("render_entry_glyph_run");
+            auto* entry = (RenderEntryGlyphRun*)data;
+            draw_glyph_run(entry, tile, framebuffer);
+            base_address += sizeof(*entry) + entry->count * sizeof(GlyphRunGlyph);
+        } break;
+        case RenderCommands_RenderEntryQuad: {
+            TIMED_BLOCK("render_entry_quad");
+            auto* entry = (RenderEntryQuad*)data;
+            draw_rectangle(                                   //
+                entry->quad,                                  //
+                entry->color,                                 //
+                entry->border_thickness, entry->border_color, //
+                tile, framebuffer                             //
+            );
+            base_address += sizeof(*entry);
+        } break;
+        default: InvalidCodePath;
+        }
+    }
+}
+
+struct RenderTileJob {
+    i32 id;
+    RenderGroup* group;
+    Array<MeshGeometry> meshes;
+    i32* command_indices;
+    i32 command_count;
+    Tile* tile;
+    Framebuffer* framebuffer;
+};
+
+static PLATFORM_WORK_QUEUE_CALLBACK(execute_render_tile_job) {
+    RenderTileJob* job = (RenderTileJob*)data;
+
+    Assert(job);
+    Assert(job->group);
+
+    TIMED_BLOCK("execute_render_commands");
+    execute_render_commands(job->id, job->group, job->meshes, job->command_indices, job->command_count, job->tile,
+        job->framebuffer, context->scratch);
+    memory_barrier(); // TODO: remove?
+}
+
+/// @brief: Renders group into the framebuffer. With is_waiting false, the tile jobs are left running on the queue
+/// and the caller has to complete the work before the framebuffer is read or rendered to again.
+static auto render_group(ThreadContext* thread_context, bool is_multithreaded, RenderGroup* group, //
+    FrameBufferHandle handle, bool is_waiting) -> void {
+    Framebuffer* buffer = &state.framebuffers[handle.v];
+    buffer->rendered_frame = state.frame_index;
+    i32* command_render_order = radix_sort_indices(group->sort_keys.data(), group->sort_keys.count(), &state.transient);
+    Array<MeshGeometry> meshes = {};
+    {
+        TIMED_BLOCK("transform_meshes");
+        meshes = transform_meshes(thread_context, is_multithreaded, group, buffer, &state.transient);
+    }
+    if (is_multithreaded) {
+        TileBins bins = {};
+        {
+            TIMED_BLOCK("bin_render_commands");
+            bins = bin_render_commands(group, command_render_order, buffer, &state.transient);
+        }
+        u64* command_hashes = nullptr;
+        {
+            TIMED_BLOCK("hash_render_commands");
+            command_hashes = hash_render_commands(group, &state.transient);
+        }
+        Array<RenderTileJob> render_tile_jobs = Array<RenderTileJob>::create(buffer->tiles.count(), &state.transient);
+
+        for (u32 i = 0; i < buffer->tiles.count(); i++) {
+            Tile* tile = &buffer->tiles[i];
+            i32 command_count = tile_bins_count(&bins, i);
+            u64 content_hash = hash_tile_commands(command_hashes, tile_bins_commands(&bins, i), command_count);
+            // The tile still holds the result of exactly these commands.
+            tile->is_unchanged = content_hash != 0 && content_hash == tile->content_hash;
+            tile->content_hash = content_hash;
+            if (command_count == 0 || tile->is_unchanged) {
+                continue;
+            }
+            RenderTileJob* job = &render_tile_jobs[i];
+            job->id = i;
+            job->tile = &buffer->tiles[i];
+            job->group = group;
+            job->meshes = meshes;
+            job->command_indices = tile_bins_commands(&bins, i);
+            job->command_count = command_count;
+            job->framebuffer = buffer;
+
+            Platform->add_work_queue_entry(thread_context->queue, execute_render_tile_job, job);
+        }
+
+        if (is_waiting) {
+            Platform->complete_all_work(thread_context);
+        }
+    }
+    else {
+        Rectangle2i clip_rect = {};
+        i32 width = buffer->width;
+        i32 height = buffer->height;
+        clip_rect.max_x = width;
+        clip_rect.max_y = height;
+        Tile tile = {};
+        tile.rect = clip_rect;
+        execute_render_commands(1, group, meshes, command_render_order, group->sort_keys.count(), &tile, buffer, state.transient);
+
+        for (u32 i = 0; i < buffer->tiles.count(); i++) {
+            buffer->tiles[i].is_dirty = true;
+            buffer->tiles[i].is_unchanged = false;
+            buffer->tiles[i].content_hash = 0;
+            // The full screen tile may have skipped a pending depth clear.
+            buffer->tiles[i].is_depth_initialized = false;
+        }
+    }
+}
+
+RENDERER_RENDER(software_renderer_render) {
+    if (state.is_pipelined) {
+        Assert(state.recording.render_count < MaxPendingRenders);
+        MemoryArena* arena = &state.frame_arenas[state.recording_arena_index];
+        PendingRender* pending = &state.recording.renders[state.recording.render_count++];
+        pending->group = copy_render_group(group, arena);
+        pending->handle = handle;
+        pending->is_multithreaded = is_multithreaded;
+        state.pipeline_thread_context = thread_context;
+        return;
+    }
+    render_group(thread_context, is_multithreaded, group, handle, true);
+}
+
+/// @brief: Starts the renderer's own frame: what is rendered and composited from here on belongs to it.
+static auto begin_render_frame() -> void {
+    state.frame_index++;
+    state.composition.count = 0;
+    state.is_composition_broken = false;
+    state.has_skipped_tiles = false;
+    state.damage = {};
+}
+
+auto apply_framebuffer_tiles_all(FrameComposition* composition) -> void;
+
+static auto end_render_frame() -> void {
+    bool is_same_composition = !state.is_composition_broken && state.composition.count == state.previous_composition.count;
+    if (!is_same_composition && state.has_skipped_tiles) {
+        // Tiles were skipped expecting the same framebuffers as last frame, so the composite may be stale.
+        TIMED_BLOCK("apply_framebuffer_fallback");
+        apply_framebuffer_tiles_all(&state.composition);
+    }
+    state.previous_composition = state.composition;
+}
+
+static auto composite_framebuffer(ThreadContext* thread_context, FrameBufferHandle handle, ivec2 scale) -> void;
+
+/// @brief: Waits for the tiles of the frame in flight, then composites it into the platform buffer.
+static auto finish_frame_in_flight() -> void {
+    if (!state.is_frame_in_flight) {
+        return;
+    }
+    TIMED_BLOCK("finish_frame_in_flight");
+    ThreadContext* thread_context = state.pipeline_thread_context;
+    Platform->complete_all_work(thread_context);
+    for (i32 i = 0; i < state.in_flight.apply_count; i++) {
+        AppliedFramebuffer* applied = &state.in_flight.applies[i];
+        composite_framebuffer(thread_context, applied->handle, applied->scale);
+    }
+    end_render_frame();
+    state.is_frame_in_flight = false;
+}
+
+/// @brief: Starts rendering the recorded frame and returns without waiting for the tiles.
+static auto submit_recorded_frame() -> void {
+    if (state.recording.render_count == 0 && state.recording.apply_count == 0) {
+        return;
+    }
+    TIMED_BLOCK("submit_recorded_frame");
+    state.in_flight = state.recording;
+    // The copies of the groups are in the recording arena, what the frame allocates from here on goes after them.
+    state.transient = state.frame_arenas[state.recording_arena_index];
+    begin_render_frame();
+
+    ThreadContext* thread_context = state.pipeline_thread_context;
+    for (i32 i = 0; i < state.in_flight.render_count; i++) {
+        PendingRender* pending = &state.in_flight.renders[i];
+        for (i32 j = 0; j < i; j++) {
+            if (state.in_flight.renders[j].handle.v == pending->handle.v) {
+                // The tiles of the earlier render into the same framebuffer have to be done first
+                Platform->complete_all_work(thread_context);
+                break;
+            }
+        }
+        render_group(thread_context, pending->is_multithreaded, &pending->group, pending->handle, false);
+    }
+    state.is_frame_in_flight = true;
+}
+
+RENDERER_BEGIN_FRAME(software_renderer_begin_frame) {
+    if (state.is_pipelined != state.is_pipelined_requested) {
+        // Leaving pipelined mode composites the frame in flight, this frame is drawn over it. It is never presented.
+        finish_frame_in_flight();
+        state.is_pipelined = state.is_pipelined_requested;
+    }
+
+    if (state.is_pipelined) {
+        // The other arena belongs to the frame in flight
+        state.recording_arena_index = !state.recording_arena_index;
+        state.frame_arenas[state.recording_arena_index].clear_to_zero();
+        state.recording.render_count = 0;
+        state.recording.apply_count = 0;
+        return;
+    }
+    state.transient.clear_to_zero();
+    begin_render_frame();
+}
+
+/// @brief: Platform independent part of the end of a frame. The platform presents state.platform_buffer after.
+/// Pipelined, that is the previous frame, and this one starts rendering while the platform presents it.
+auto software_renderer_end_frame() -> void {
+    if (state.is_pipelined) {
+        finish_frame_in_flight();
+        submit_recorded_frame();
+        return;
+    }
+    end_render_frame();
+}
+
+/// @brief: Takes effect at the next begin_frame.
+auto software_renderer_set_pipelined(bool is_pipelined) -> void {
+    state.is_pipelined_requested = is_pipelined;
+}
+
+RENDERER_CREATE_FRAMEBUFFER(software_renderer_create_framebuffer) {
+    Assert(!state.framebuffers.is_full());
+
+    FrameBufferHandle handle = { .v = (i32)state.framebuffers.count() };
+    Framebuffer* f = state.framebuffers.push();
+    resize_frame_buffer(f, width, height);
+    f->tiles = generate_tiles(f->width, f->height, f->width / 8, f->height / 5, &state.permanent);
+    return handle;
+}
+
+struct ApplyFramebufferJob {
+    i32 id;
+    Framebuffer* framebuffer;
+    Tile* tile;
+    ivec2 scale;
+};
+static PLATFORM_WORK_QUEUE_CALLBACK(execute_apply_frame_buffer_job) {
+    TIMED_BLOCK("execute_apply_frame_buffer_job");
+    auto job = (ApplyFramebufferJob*)data;
+    Assert(job);
+
+    if ((u64)state.platform_buffer.memory_size >= state.streaming_store_min_size) {
+        apply_frame_buffer_stream(job->framebuffer, job->tile, &state.platform_buffer, job->scale);
+    }
+    else {
+        apply_frame_buffer(job->framebuffer, job->tile, &state.platform_buffer, job->scale);
+    }
+    memory_barrier(); // TODO: remove?
+}
+
+auto apply_framebuffer_tiles_all(FrameComposition* composition) -> void {
+    for (i32 i = 0; i < composition->count; i++) {
+        AppliedFramebuffer* applied = &composition->applied[i];
+        Framebuffer* buffer = &state.framebuffers[applied->handle.v];
+        for (u32 tile_idx = 0; tile_idx < buffer->tiles.count(); tile_idx++) {
+            apply_frame_buffer(buffer, &buffer->tiles[tile_idx], &state.platform_buffer, applied->scale);
+        }
+    }
+}
+
+auto get_tile_dest_rect(Tile* tile, ivec2 scale) -> Rectangle2i {
+    Framebuffer* dest = &state.platform_buffer;
+    Rectangle2i result;
+    result.min_x = hm::min(tile->rect.min_x * scale.x, dest->width);
+    result.max_x = hm::min(tile->rect.max_x * scale.x, dest->width);
+    result.min_y = hm::min(tile->rect.min_y * scale.y, dest->height);
+    result.max_y = hm::min(tile->rect.max_y * scale.y, dest->height);
+    return result;
+}
+
+/// @brief: Marks the platform buffer cells covered by every tile that changed this frame, in any of the
+/// framebuffers applied last frame. Computed once, before the first framebuffer is applied.
+auto compute_frame_damage() -> void {
+    Framebuffer* dest = &state.platform_buffer;
+    state.damage_count_x = (dest->width + DamageCellDim - 1) / DamageCellDim;
+    i32 damage_count_y = (dest->height + DamageCellDim - 1) / DamageCellDim;
+    state.damage = Array<bool>::create(state.damage_count_x * damage_count_y, &state.transient);
+
+    for (i32 i = 0; i < state.previous_composition.count; i++) {
+        AppliedFramebuffer* applied = &state.previous_composition.applied[i];
+        Framebuffer* buffer = &state.framebuffers[applied->handle.v];
+        if (buffer->rendered_frame != state.frame_index) {
+            continue;
+        }
+        for (u32 tile_idx = 0; tile_idx < buffer->tiles.count(); tile_idx++) {
+            Tile* tile = &buffer->tiles[tile_idx];
+            if (tile->is_unchanged) {
+                continue;
+            }
+            Rectangle2i rect = get_tile_dest_rect(tile, applied->scale);
+            for (i32 y = rect.min_y / DamageCellDim; y * DamageCellDim < rect.max_y; y++) {
+                for (i32 x = rect.min_x / DamageCellDim; x * DamageCellDim < rect.max_x; x++) {
+                    state.damage[y * state.damage_count_x + x] = true;
+                }
+            }
+        }
+    }
+}
+
+auto is_damaged(Rectangle2i rect) -> bool {
+    for (i32 y = rect.min_y / DamageCellDim; y * DamageCellDim < rect.max_y; y++) {
+        for (i32 x = rect.min_x / DamageCellDim; x * DamageCellDim < rect.max_x; x++) {
+            if (state.damage[y * state.damage_count_x + x]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static auto composite_framebuffer(ThreadContext* thread_context, FrameBufferHandle handle, ivec2 scale) -> void {
+    Framebuffer* buffer = &state.framebuffers[handle.v];
+
+    // Skipping tiles relies on the platform buffer holding last frame's composite, built from the same
+    // framebuffers in the same order.
+    i32 apply_idx = state.composition.count;
+    if (apply_idx == 0) {
+        compute_frame_damage();
+    }
+    if (apply_idx < MaxAppliedFramebuffers) {
+        state.composition.applied[apply_idx] = { .handle = handle, .scale = scale };
+        state.composition.count++;
+    }
+    else {
+        state.is_composition_broken = true;
+    }
+    if (apply_idx >= state.previous_composition.count ||
+        state.previous_composition.applied[apply_idx].handle.v != handle.v ||
+        state.previous_composition.applied[apply_idx].scale.x != scale.x ||
+        state.previous_composition.applied[apply_idx].scale.y != scale.y) {
+        state.is_composition_broken = true;
+    }
+
+    Array<ApplyFramebufferJob> jobs = Array<ApplyFramebufferJob>::create(buffer->tiles.count(), &state.transient);
+    for (u32 i = 0; i < buffer->tiles.count(); i++) {
+        Tile* tile = &buffer->tiles[i];
+        bool is_unchanged = buffer->rendered_frame != state.frame_index || tile->is_unchanged;
+        if (!state.is_composition_broken && is_unchanged && !is_damaged(get_tile_dest_rect(tile, scale))) {
+            state.has_skipped_tiles = true;
+            continue;
+        }
+
+        ApplyFramebufferJob* job = &jobs[i];
+        job->id = i;
+        job->framebuffer = &state.framebuffers[handle.v];
+        job->tile = &buffer->tiles[i];
+
+        job->scale = scale;
+        Platform->add_work_queue_entry(thread_context->queue, execute_apply_frame_buffer_job, job);
+    }
+
+    Platform->complete_all_work(thread_context);
+}
+
+RENDERER_APPLY_FRAMEBUFFER(software_renderer_apply_framebuffer) {
+    if (state.is_pipelined) {
+        Assert(state.recording.apply_count < MaxAppliedFramebuffers);
+        state.recording.applies[state.recording.apply_count++] = { .handle = handle, .scale = scale };
+        state.pipeline_thread_context = thread_context;
+        return;
+    }
+    composite_framebuffer(thread_context, handle, scale);
+}
+
+RENDERER_GET_COLOR(software_renderer_get_color) {
+    Color result = {};
+    return result;
+}
+
@@ -0,0 +1,86 @@
+#pragma once
+
+// The texel layout the software renderer samples, shared with the asset builder so bitmaps can be
+// baked in it and referenced by the renderer without a conversion pass.
+#include <cstring>
+
+#include <platform/types.hpp>
+
+#include <core/color.hpp>
+#include <engine/hugin_file_formats.hpp>
+
+const i32 TextureBlockDim = 4;
+
+/// @brief: Where texel x, y is in a texture of 4x4 texel blocks, in texels. Blocks are stored row by row.
+auto inline blocks4x4_texel_index(i32 x, i32 y, i32 block_count_x) -> i32 {
+    i32 block = (y >> 2) * block_count_x + (x >> 2);
+    return (block << 4) | ((y & 3) << 2) | (x & 3);
+}
+
+auto inline blocks4x4_block_count(i32 texels) -> i32 {
+    return (texels + TextureBlockDim - 1) / TextureBlockDim;
+}
+
+/// @brief: Texels stored for a width x height texture in 4x4 blocks. Partial blocks are padded.
+auto inline blocks4x4_texel_count(i32 width, i32 height) -> i32 {
+    return blocks4x4_block_count(width) * blocks4x4_block_count(height) * TextureBlockDim * TextureBlockDim;
+}
+
+/// @brief: Size of the texels of a width x height bitmap in an asset file.
+auto inline pixel_format_size(PixelFormat format, i32 width, i32 height) -> u64 {
+    switch (format) {
+    case PixelFormat_RGBA8: return (u64)width * height * sizeof(u32);
+    case PixelFormat_SoftwareNative: return (u64)blocks4x4_texel_count(width, height) * sizeof(u32);
+    }
+    InvalidCodePath;
+    return 0;
+}
+
+/// @brief: One straight alpha RGBA8 texel to ARGB, premultiplied in linear space.
+auto inline rgba8_to_software_native_texel(u32 rgba) -> u32 {
+    u8 red = (rgba >> 0) & 0xFF;
+    u8 green = (rgba >> 8) & 0xFF;
+    u8 blue = (rgba >> 16) & 0xFF;
+    u8 alpha = (rgba >> 24) & 0xFF;
+    u32 straight = alpha << 24 | red << 16 | green << 8 | blue;
+    return linear1_to_packed8x4_srgb255(premultiply_alpha(unpack4x8_srgb255_to_linear1(straight)));
+}
+
+/// @brief: The inverse of rgba8_to_software_native_texel, for renderers that want straight alpha.
+auto inline software_native_to_rgba8_texel(u32 argb) -> u32 {
+    vec4 color = unpack4x8_srgb255_to_linear1(argb);
+    if (color.a > 0.0f) {
+        f32 inv_a = 1.0f / color.a;
+        color.r = hm::min(color.r * inv_a, 1.0f);
+        color.g = hm::min(color.g * inv_a, 1.0f);
+        color.b = hm::min(color.b * inv_a, 1.0f);
+    }
+    u32 packed = linear1_to_packed8x4_srgb255(color);
+    u32 red = (packed >> 16) & 0xFF;
+    u32 green = (packed >> 8) & 0xFF;
+    u32 blue = (packed >> 0) & 0xFF;
+    u32 alpha = (packed >> 24) & 0xFF;
+    return alpha << 24 | blue << 16 | green << 8 | red;
+}
+
+/// @brief: Converts a straight alpha RGBA8 bitmap to PixelFormat_SoftwareNative.
+/// dest holds blocks4x4_texel_count(width, height) texels, the padding is zeroed.
+auto inline convert_rgba8_to_software_native(const u32* source, i32 width, i32 height, u32* dest) -> void {
+    i32 block_count_x = blocks4x4_block_count(width);
+    memset(dest, 0, blocks4x4_texel_count(width, height) * sizeof(u32));
+    for (i32 y = 0; y < height; y++) {
+        for (i32 x = 0; x < width; x++) {
+            dest[blocks4x4_texel_index(x, y, block_count_x)] = rgba8_to_software_native_texel(*source++);
+        }
+    }
+}
+
+/// @brief: Converts a PixelFormat_SoftwareNative bitmap back to straight alpha RGBA8 rows.
+auto inline convert_software_native_to_rgba8(const u32* source, i32 width, i32 height, u32* dest) -> void {
+    i32 block_count_x = blocks4x4_block_count(width);
+    for (i32 y = 0; y < height; y++) {
+        for (i32 x = 0; x < width; x++) {
+            *dest++ = software_native_to_rgba8_texel(source[blocks4x4_texel_index(x, y, block_count_x)]);
+        }
+    }
+}
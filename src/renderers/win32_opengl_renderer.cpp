@@ -9,6 +9,7 @@
 #include "math/mat3.hpp"
 
 #include <renderers/renderer.hpp>
+#include <renderers/texture_format.hpp>
 #include <renderers/win32_renderer.hpp>
 
 #include "../core/lib.cpp"
@@ -358,9 +359,18 @@ extern "C" __declspec(dllexport) RENDERER_ADD_TEXTURE(win32_renderer_add_texture
         // set texture filtering parameters
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // Assets are baked for the software renderer, back to straight RGBA rows. GL copies the texels.
+        void* rgba = data;
+        if (pixel_format == PixelFormat_SoftwareNative) {
+            rgba = malloc((u64)width * height * sizeof(u32));
+            convert_software_native_to_rgba8((u32*)data, width, height, (u32*)rgba);
+        }
         // load image, create texture and generate mipmaps
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
         glGenerateMipmap(GL_TEXTURE_2D);
+        if (rgba != data) {
+            free(rgba);
+        }
 
         glBindTexture(GL_TEXTURE_2D, 0);
         return true;
@@ -394,6 +404,29 @@ extern "C" __declspec(dllexport) RENDERER_RENDER(win32_renderer_render) {
 
             base_address += sizeof(*entry);
         } break;
+        case RenderCommands_RenderEntryBitmapBatch: {
+            auto* entry = (RenderEntryBitmapBatch*)data;
+            BitmapBatchInstances instances = get_bitmap_batch_instances(entry);
+            for (i32 i = 0; i < entry->count; i++) {
+                draw_bitmap(entry->quad, vec2(instances.offset_x[i], instances.offset_y[i]),
+                    vec2(instances.scale_x[i], instances.scale_y[i]), instances.rotation[i], instances.color[i],
+                    entry->texture_id, group->screen_width, group->screen_height);
+            }
+
+            base_address += sizeof(*entry) + bitmap_batch_instances_size(entry->count);
+        } break;
+        case RenderCommands_RenderEntryGlyphRun: {
+            auto* entry = (RenderEntryGlyphRun*)data;
+            GlyphRunGlyph* glyphs = get_glyph_run_glyphs(entry);
+            Quadrilateral quad = { .bl = vec2(-0.5f, -0.5f), .tl = vec2(-0.5f, 0.5f), .tr = vec2(0.5f, 0.5f), .br = vec2(0.5f, -0.5f) };
+            for (i32 i = 0; i < entry->count; i++) {
+                vec2 size = vec2((f32)(glyphs[i].u_max - glyphs[i].u_min), (f32)(glyphs[i].v_max - glyphs[i].v_min));
+                vec2 offset = vec2((f32)glyphs[i].x + size.x * 0.5f, (f32)glyphs[i].y + size.y * 0.5f);
+                draw_bitmap(quad, offset, size, 0.0f, entry->color, entry->texture_id, group->screen_width, group->screen_height);
+            }
+
+            base_address += sizeof(*entry) + entry->count * sizeof(GlyphRunGlyph);
+        } break;
         default: InvalidCodePath;
         }
     }
@@ -21,4 +21,5 @@ static const char* win32_renderer_exports[] = {
     "win32_renderer_create_framebuffer",
     "win32_renderer_apply_framebuffer",
     "win32_renderer_get_color",
+    "win32_renderer_set_pipelined",
 };
@@ -1381,6 +1381,8 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
             if (current_input->o.is_pressed_this_frame()) {
                 global_is_reloading_renderer = true;
 
+                // A pipelined renderer can still have the last frame on the workers
+                platform.complete_all_work(main_thread);
                 ZeroSize(Renderer_Total_Memory_Size, renderer_memory.data);
                 // renderer_type = renderer_type == RendererType_Software ? RendererType_OpenGL : RendererType_Software;
 
@@ -1535,7 +1537,10 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
                 &engine_memory, &engine_input   //
             );
         }
-        global_debug_table->event_index = 0;
+        else {
+            // debug_frame_end swaps the event array, workers rendering a pipelined frame keep recording into it
+            global_debug_table->event_index = 0;
+        }
 
         auto prev_input_idx = curr_input_idx;
         curr_input_idx = curr_input_idx == 0 ? 1 : 0;
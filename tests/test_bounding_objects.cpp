@@ -0,0 +1,48 @@
+#include "doctest.h"
+
+#include <math/bounding_objects.hpp>
+
+TEST_CASE("AABB: set_points spans the points") {
+    // All negative, so an empty box seeded with the smallest positive f32 would get it wrong
+    vec4 points[3] = { vec4(-1.0f, -5.0f, -2.0f, 1.0f), vec4(-3.0f, -4.0f, -6.0f, 1.0f), vec4(-2.0f, -7.0f, -1.0f, 1.0f) };
+    AABB bbox;
+    AABB_set_points(bbox, Array<vec4>(points, 3));
+    CHECK(bbox.min.x == -3.0f);
+    CHECK(bbox.min.y == -7.0f);
+    CHECK(bbox.min.z == -6.0f);
+    CHECK(bbox.max.x == -1.0f);
+    CHECK(bbox.max.y == -4.0f);
+    CHECK(bbox.max.z == -1.0f);
+
+    CHECK(AABB_corner(bbox, 0).x == -3.0f);
+    CHECK(AABB_corner(bbox, 7).z == -1.0f);
+    CHECK(AABB_corner(bbox, 5).y == -7.0f);
+}
+
+TEST_CASE("AABB: transform bounds the transformed corners") {
+    AABB bbox;
+    bbox.min = vec3(-1.0f, -2.0f, 0.0f);
+    bbox.max = vec3(3.0f, 1.0f, 2.0f);
+    // Rotation by 90 degrees around z with a scale on x, then a translation. Row vectors, x goes to y.
+    // clang-format off
+    mat4 M(0.0f,  2.0f, 0.0f, 0.0f,
+          -1.0f,  0.0f, 0.0f, 0.0f,
+           0.0f,  0.0f, 1.0f, 0.0f,
+          10.0f, 20.0f, 30.0f, 1.0f);
+    // clang-format on
+    AABB result = AABB_transform(bbox, M);
+    CHECK(result.min.x == doctest::Approx(9.0f));
+    CHECK(result.max.x == doctest::Approx(12.0f));
+    CHECK(result.min.y == doctest::Approx(18.0f));
+    CHECK(result.max.y == doctest::Approx(26.0f));
+    CHECK(result.min.z == doctest::Approx(30.0f));
+    CHECK(result.max.z == doctest::Approx(32.0f));
+
+    for (i32 i = 0; i < 8; i++) {
+        vec4 p = AABB_corner(bbox, i) * M;
+        CHECK(p.x >= result.min.x);
+        CHECK(p.x <= result.max.x);
+        CHECK(p.y >= result.min.y);
+        CHECK(p.y <= result.max.y);
+    }
+}
@@ -14,16 +14,22 @@ int main(int argc, char** argv) {
 #include <math/mat2.cpp>
 #include <math/mat3.cpp>
 #include <math/mat4.cpp>
+#include <math/quat.cpp>
+#include <math/transform.cpp>
 #include <math/vec2.cpp>
 #include <math/vec3.cpp>
 
 #include "memory_arena_test.cpp"
 #include "structs/test_swap_back_list.cpp"
+#include "test_bounding_objects.cpp"
 #include "test_mat2.cpp"
 #include "test_mat3.cpp"
 #include "test_mat4.cpp"
 #include "test_render_line_bresenham.cpp"
+#include "test_render_mesh.cpp"
+#include "test_render_triangle.cpp"
 #include "test_renderer.cpp"
 #include "test_simd.cpp"
 #include "test_sort.cpp"
 #include "test_string8.cpp"
+#include "test_texture_format.cpp"
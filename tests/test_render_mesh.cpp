@@ -0,0 +1,506 @@
+#include "doctest.h"
+
+#include <core/mesh.hpp>
+#include <renderers/cpu_render_algorithms.hpp>
+
+static auto transform_vertices_kernels() -> Array<transform_vertices_fn> {
+    static transform_vertices_fn kernels[2] = {
+        transform_vertices_avx2,
+        transform_vertices_avx512,
+    };
+    return Array<transform_vertices_fn>(kernels, cpu_supports_avx512f() ? 2 : 1);
+}
+
+static auto test_model_to_clip(vec3 position) -> mat4 {
+    Transform transform = {};
+    transform.position = position;
+    transform.rotation = angle_axis(0.6f, normalized(vec3(0.2f, 1.0f, 0.3f)));
+    transform.scale = vec3(1.0f, 1.0f, 1.0f);
+    mat4 world_to_view = lookAt(vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 1.0f, 0.0f));
+    return transform.to_mat4() * world_to_view * perspective(60.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+}
+
+TEST_CASE("transform_vertices SIMD paths match the scalar path and project_vertex") {
+    MemoryArena arena = {};
+    arena.init(malloc(KiloBytes(256)), KiloBytes(256));
+
+    // Not a multiple of a batch, and partly outside of the view
+    const u32 count = 37;
+    auto vertices = Array<vec4>::create(count, arena);
+    for (u32 i = 0; i < count; i++) {
+        f32 t = (f32)i / (f32)count;
+        vertices[i] = vec4(cosf(t * 17.0f) * 4.0f, sinf(t * 11.0f) * 3.0f, cosf(t * 5.0f) * 3.0f, 1.0f);
+    }
+    VertexPositions positions = create_vertex_positions(vertices, arena);
+    mat4 model_to_clip = test_model_to_clip(vec3(0.0f, 0.0f, 4.0f));
+    const i32 width = 320;
+    const i32 height = 180;
+
+    ProjectedVertices expected = create_projected_vertices(count, arena);
+    transform_vertices_scalar(positions, count, model_to_clip, width, height, &expected);
+    i32 inside_count = 0;
+    for (u32 i = 0; i < count; i++) {
+        vec4 clip = vertices[i] * model_to_clip;
+        REQUIRE_EQ(expected.clip_codes[i] == 0, is_inside_view(clip));
+        if (expected.clip_codes[i] == 0) {
+            vec3 P = project_vertex(clip, width, height);
+            REQUIRE_EQ(expected.x[i], doctest::Approx(P.x));
+            REQUIRE_EQ(expected.y[i], doctest::Approx(P.y));
+            REQUIRE_EQ(expected.inv_w[i], doctest::Approx(P.z));
+            inside_count++;
+        }
+    }
+    REQUIRE(inside_count > 0);
+    REQUIRE(inside_count < (i32)count);
+
+    for (auto transform : transform_vertices_kernels()) {
+        ProjectedVertices projected = create_projected_vertices(count, arena);
+        transform(positions, count, model_to_clip, width, height, &projected);
+        for (u32 i = 0; i < count; i++) {
+            REQUIRE_EQ(projected.clip_codes[i], expected.clip_codes[i]);
+            if (expected.clip_codes[i] == 0) {
+                REQUIRE_EQ(projected.x[i], doctest::Approx(expected.x[i]));
+                REQUIRE_EQ(projected.y[i], doctest::Approx(expected.y[i]));
+                REQUIRE_EQ(projected.inv_w[i], doctest::Approx(expected.inv_w[i]));
+            }
+        }
+    }
+    free(arena.m_memory);
+}
+
+TEST_CASE("clip_triangles_against_guard_band only clips against the planes it is asked to") {
+    MemoryArena arena = {};
+    arena.init(malloc(KiloBytes(64)), KiloBytes(64));
+    auto vertices = Array<vec4>::create(3, arena);
+    vertices[0] = vec4(-10.0f, 0.0f, 0.0f, 1.0f);
+    vertices[1] = vec4(1.0f, 1.0f, 0.0f, 1.0f);
+    vertices[2] = vec4(1.0f, -1.0f, 0.0f, 1.0f);
+    auto triangles = Array<ivec3>::create(1, arena);
+    triangles[0] = ivec3(0, 1, 2);
+
+    // No planes, no passes
+    ClippedTriangles unclipped = clip_triangles_against_guard_band(vertices, Array<vec4>(), triangles, 0, arena);
+    REQUIRE_EQ(unclipped.vertices.data(), vertices.data());
+    REQUIRE_EQ(unclipped.triangles.data(), triangles.data());
+
+    // Inside the guard band in y and in front of the near plane, so nothing is cut
+    unclipped = clip_triangles_against_guard_band(vertices, Array<vec4>(), triangles, ClipCode_GuardBandY | ClipCode_NegativeZ, arena);
+    REQUIRE_EQ(unclipped.triangles.count(), 1);
+    REQUIRE_EQ(unclipped.vertices[0].x, -10.0f);
+
+    // One vertex past the guard band, the triangle is cut into two at it
+    ClippedTriangles clipped = clip_triangles_against_guard_band(vertices, Array<vec4>(), triangles, ClipCode_GuardBandX, arena);
+    REQUIRE_EQ(clipped.triangles.count(), 2);
+    for (auto triangle : clipped.triangles) {
+        for (i32 i = 0; i < 3; i++) {
+            vec4 v = clipped.vertices[triangle.v[i]];
+            REQUIRE(v.x >= -GuardBandScale * v.w - 0.001f);
+        }
+    }
+    free(arena.m_memory);
+}
+
+TEST_CASE("clip_triangles_against_guard_band shares the vertices it keeps") {
+    MemoryArena arena = {};
+    arena.init(malloc(KiloBytes(64)), KiloBytes(64));
+    // A quad of two triangles sharing the 0-2 edge, reaching past the left of the guard band
+    auto vertices = Array<vec4>::create(4, arena);
+    vertices[0] = vec4(-10.0f, -1.0f, 0.0f, 1.0f);
+    vertices[1] = vec4(1.0f, -1.0f, 0.0f, 1.0f);
+    vertices[2] = vec4(1.0f, 1.0f, 0.0f, 1.0f);
+    vertices[3] = vec4(-10.0f, 1.0f, 0.0f, 1.0f);
+    auto triangles = Array<ivec3>::create(2, arena);
+    triangles[0] = ivec3(0, 1, 2);
+    triangles[1] = ivec3(0, 2, 3);
+
+    // In front of the near plane, so the pass keeps everything, once
+    ClippedTriangles kept = clip_triangles_against_guard_band(vertices, Array<vec4>(), triangles, ClipCode_NegativeZ, arena);
+    REQUIRE_EQ(kept.triangles.count(), 2);
+    REQUIRE_EQ(kept.vertices.count(), 4);
+    REQUIRE_EQ(kept.triangles[0].x, kept.triangles[1].x);
+    REQUIRE_EQ(kept.triangles[0].z, kept.triangles[1].y);
+
+    // Vertex 2 is kept by both triangles and 1 by one of them. Each triangle cuts two edges, and the intersection on the
+    // 0-2 edge they share is made once.
+    ClippedTriangles clipped = clip_triangles_against_guard_band(vertices, Array<vec4>(), triangles, ClipCode_GuardBandX, arena);
+    REQUIRE_EQ(clipped.triangles.count(), 3);
+    REQUIRE_EQ(clipped.vertices.count(), 5);
+    for (u32 i = 0; i < clipped.vertices.count(); i++) {
+        for (u32 j = i + 1; j < clipped.vertices.count(); j++) {
+            REQUIRE_FALSE(clipped.vertices[i] == clipped.vertices[j]);
+        }
+    }
+    for (auto triangle : clipped.triangles) {
+        for (i32 i = 0; i < 3; i++) {
+            vec4 v = clipped.vertices[triangle.v[i]];
+            REQUIRE(v.x >= -GuardBandScale * v.w - 0.001f);
+        }
+    }
+    free(arena.m_memory);
+}
+
+TEST_CASE("test_bounds_against_frustum culls instances off the view and spares the inside ones clipping") {
+    AABB bounds;
+    bounds.min = vec3(-1.0f, -1.0f, -1.0f);
+    bounds.max = vec3(1.0f, 1.0f, 1.0f);
+
+    REQUIRE_EQ(test_bounds_against_frustum(bounds, test_model_to_clip(vec3(0.0f, 0.0f, 6.0f))), FrustumTest_Inside);
+    // Partly off the side of the view, inside the guard band
+    REQUIRE_EQ(test_bounds_against_frustum(bounds, test_model_to_clip(vec3(-5.5f, 0.0f, 6.0f))), FrustumTest_Inside);
+    REQUIRE_EQ(test_bounds_against_frustum(bounds, test_model_to_clip(vec3(-40.0f, 0.0f, 6.0f))), FrustumTest_Outside);
+    REQUIRE_EQ(test_bounds_against_frustum(bounds, test_model_to_clip(vec3(0.0f, 30.0f, 6.0f))), FrustumTest_Outside);
+    REQUIRE_EQ(test_bounds_against_frustum(bounds, test_model_to_clip(vec3(0.0f, 0.0f, -6.0f))), FrustumTest_Outside);
+    REQUIRE_EQ(test_bounds_against_frustum(bounds, test_model_to_clip(vec3(0.0f, 0.0f, 2000.0f))), FrustumTest_Outside);
+    // Across the near plane
+    REQUIRE_EQ(test_bounds_against_frustum(bounds, test_model_to_clip(vec3(0.0f, 0.0f, 0.5f))), FrustumTest_Intersecting);
+    // From inside the view to past the side of the guard band
+    AABB wide_bounds;
+    wide_bounds.min = vec3(-1.0f, -100.0f, -1.0f);
+    wide_bounds.max = vec3(1.0f, 1.0f, 1.0f);
+    REQUIRE_EQ(test_bounds_against_frustum(wide_bounds, test_model_to_clip(vec3(0.0f, 0.0f, 6.0f))), FrustumTest_Intersecting);
+}
+
+TEST_CASE("transform_mesh_instance only clips the triangles that cross the near plane or the guard band") {
+    MemoryArena arena = {};
+    arena.init(malloc(MegaBytes(1)), MegaBytes(1));
+    TriMesh cube = {};
+    generate_cube_mesh(&cube, &arena);
+    auto colors = Array<vec4>::create(1, arena);
+    colors[0] = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    mat4 world_to_view = lookAt(vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 1.0f, 0.0f));
+    mat4 view_to_clip = perspective(60.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+    vec4 camera_position = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    const i32 width = 320;
+    const i32 height = 180;
+
+    MeshInstance instance = {};
+    instance.transform.rotation = angle_axis(0.6f, normalized(vec3(0.2f, 1.0f, 0.3f)));
+    instance.transform.scale = vec3(1.0f, 1.0f, 1.0f);
+    instance.colors = colors;
+
+    SUBCASE("inside the view") {
+        instance.transform.position = vec3(0.0f, 0.0f, 6.0f);
+        ScreenMesh mesh = transform_mesh_instance(
+            cube, instance, world_to_view, view_to_clip, camera_position, nullptr, width, height, arena);
+        REQUIRE(mesh.triangles.count() > 0);
+        REQUIRE_EQ(mesh.vertices.count(), cube.vertex_count);
+        for (auto triangle : mesh.triangles) {
+            for (i32 i = 0; i < 3; i++) {
+                vec3 P = mesh.vertices[triangle.v[i]];
+                REQUIRE(is_inside(ivec2((i32)P.x, (i32)P.y), mesh.bounds));
+            }
+        }
+    }
+
+    SUBCASE("crossing the side of the view, inside the guard band") {
+        instance.transform.position = vec3(-5.5f, 0.0f, 6.0f);
+        ScreenMesh mesh = transform_mesh_instance(
+            cube, instance, world_to_view, view_to_clip, camera_position, nullptr, width, height, arena);
+        // Left to the rasterizer, so no vertices are added and some are off the screen
+        REQUIRE(mesh.triangles.count() > 0);
+        REQUIRE_EQ(mesh.vertices.count(), cube.vertex_count);
+        bool is_any_off_screen = false;
+        for (auto triangle : mesh.triangles) {
+            for (i32 i = 0; i < 3; i++) {
+                vec3 P = mesh.vertices[triangle.v[i]];
+                is_any_off_screen = is_any_off_screen || P.x < 0.0f || P.x > (f32)(width - 1);
+            }
+        }
+        REQUIRE(is_any_off_screen);
+        REQUIRE(mesh.bounds.min_x >= 0);
+        REQUIRE(mesh.bounds.max_x <= width);
+    }
+
+    SUBCASE("crossing the near plane") {
+        // Far enough for the camera to be outside of the cube, close enough for it to cross a near plane at 1
+        instance.transform.position = vec3(0.0f, 0.0f, 2.2f);
+        mat4 view_to_clip_near = perspective(60.0f, 16.0f / 9.0f, 1.0f, 1000.0f);
+        ScreenMesh mesh = transform_mesh_instance(
+            cube, instance, world_to_view, view_to_clip_near, camera_position, nullptr, width, height, arena);
+        REQUIRE(mesh.vertices.count() > cube.vertex_count);
+        for (auto triangle : mesh.triangles) {
+            for (i32 i = 0; i < 3; i++) {
+                // In front of the camera, 1/w is positive
+                REQUIRE(mesh.vertices[triangle.v[i]].z > 0.0f);
+            }
+        }
+    }
+
+    SUBCASE("behind the camera") {
+        instance.transform.position = vec3(0.0f, 0.0f, -6.0f);
+        ScreenMesh mesh = transform_mesh_instance(
+            cube, instance, world_to_view, view_to_clip, camera_position, nullptr, width, height, arena);
+        REQUIRE_EQ(mesh.triangles.count(), 0);
+    }
+    free(arena.m_memory);
+}
+
+TEST_CASE("a triangle crossing all six clip planes fits the arenas sized for it") {
+    MemoryArena arena = {};
+    arena.init(malloc(MegaBytes(1)), MegaBytes(1));
+
+    // Identity model and view transforms, so the model space corners land on the rows of view_to_clip. In front of
+    // the near plane, behind the far plane and past the guard band on every side, cut a little more by every pass.
+    auto vertices = Array<vec4>::create(3, arena);
+    vertices[0] = vec4(1.0f, 0.0f, 0.0f, 1.0f);
+    vertices[1] = vec4(0.0f, 1.0f, 0.0f, 1.0f);
+    vertices[2] = vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    mat4 view_to_clip = {};
+    view_to_clip.x_basis = vec4(-51.0f, -54.0f, -9.3f, 9.4f);
+    view_to_clip.y_basis = vec4(59.0f, 61.0f, 4.2f, 3.0f);
+    view_to_clip.z_basis = vec4(11.0f, 42.0f, -10.1f, 2.7f);
+    view_to_clip.w_basis = vec4(0.0f, 0.0f, 0.0f, 0.0f);
+
+    TriMesh triangle = {};
+    triangle.positions = create_vertex_positions(vertices, arena);
+    triangle.vertex_count = 3;
+    triangle.triangles = Array<ivec3>::create(1, arena);
+    triangle.triangles[0] = ivec3(0, 1, 2);
+    triangle.normals = Array<vec3>::create(1, arena);
+    triangle.normals[0] = vec3(-1.0f, -1.0f, -1.0f);
+    AABB_set_points(triangle.bounds, vertices);
+    auto colors = Array<vec4>::create(1, arena);
+    colors[0] = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+
+    MeshInstance instance = {};
+    instance.transform.rotation = angle_axis(0.0f, vec3(0.0f, 1.0f, 0.0f));
+    instance.transform.scale = vec3(1.0f, 1.0f, 1.0f);
+    instance.colors = colors;
+    mat4 world_to_view = mat4_identity();
+    vec4 camera_position = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    const i32 width = 320;
+    const i32 height = 180;
+
+    MemoryArena* project_arena = arena.allocate_arena(project_mesh_instance_arena_size(3, 1, nullptr));
+    ProjectedMeshInstance projected = project_mesh_instance(
+        triangle, instance, world_to_view, view_to_clip, camera_position, nullptr, width, height, *project_arena);
+    REQUIRE_EQ(projected.clip_triangles.count(), 1);
+    REQUIRE_EQ(projected.clip_codes, ClipCodes_GuardBand);
+
+    // Allocating past the sized arena would crash and burn
+    MemoryArena* clip_arena = arena.allocate_arena(clip_mesh_instance_arena_size(projected));
+    ScreenMesh mesh = clip_mesh_instance(projected, instance, width, height, *clip_arena);
+    // The passes compound, far past the 8 triangles of a single cut by the near plane and a guard band corner
+    REQUIRE(mesh.triangles.count() > 8);
+    REQUIRE(mesh.bounds.min_x < mesh.bounds.max_x);
+    REQUIRE(mesh.bounds.min_y < mesh.bounds.max_y);
+    // The guard band in screen space, and a pixel for the rounding of the clipped vertices
+    f32 min_x = (0.5f - 0.5f * GuardBandScale) * (f32)(width - 1) - 1.0f;
+    f32 max_x = (0.5f + 0.5f * GuardBandScale) * (f32)(width - 1) + 1.0f;
+    f32 min_y = (0.5f - 0.5f * GuardBandScale) * (f32)(height - 1) - 1.0f;
+    f32 max_y = (0.5f + 0.5f * GuardBandScale) * (f32)(height - 1) + 1.0f;
+    for (auto triangle_indices : mesh.triangles) {
+        for (i32 i = 0; i < 3; i++) {
+            vec3 P = mesh.vertices[triangle_indices.v[i]];
+            REQUIRE(P.z > 0.0f);
+            REQUIRE(in_range(min_x, P.x, max_x));
+            REQUIRE(in_range(min_y, P.y, max_y));
+        }
+    }
+    free(arena.m_memory);
+}
+
+static auto light_vertices_kernels() -> Array<light_vertices_fn> {
+    static light_vertices_fn kernels[2] = {
+        light_vertices_avx2,
+        light_vertices_avx512,
+    };
+    return Array<light_vertices_fn>(kernels, cpu_supports_avx512f() ? 2 : 1);
+}
+
+TEST_CASE("calculate_vertex_normals points the cube's corners away from its center") {
+    MemoryArena arena = {};
+    arena.init(malloc(KiloBytes(64)), KiloBytes(64));
+    TriMesh cube = {};
+    generate_cube_mesh(&cube, &arena);
+    REQUIRE(cube.vertex_normals.x.count() >= cube.vertex_count);
+    for (u32 i = 0; i < cube.vertex_count; i++) {
+        vec3 N = vec3(cube.vertex_normals.x[i], cube.vertex_normals.y[i], cube.vertex_normals.z[i]);
+        REQUIRE_EQ(len(N), doctest::Approx(1.0f));
+        vec3 P = get_vertex_position(cube.positions, i).xyz();
+        REQUIRE(dot(N, P) > 0.0f);
+    }
+    free(arena.m_memory);
+}
+
+TEST_CASE("light_vertices SIMD paths match the scalar path and the lighting formula") {
+    MemoryArena arena = {};
+    arena.init(malloc(KiloBytes(256)), KiloBytes(256));
+
+    // Not a multiple of a batch, facing every way
+    const u32 count = 37;
+    auto vertices = Array<vec4>::create(count, arena);
+    VertexNormals normals = {};
+    normals.x = Array<f32>::create(vertex_batch_padded_count(count), arena);
+    normals.y = Array<f32>::create(vertex_batch_padded_count(count), arena);
+    normals.z = Array<f32>::create(vertex_batch_padded_count(count), arena);
+    for (u32 i = 0; i < count; i++) {
+        f32 t = (f32)i / (f32)count;
+        vertices[i] = vec4(cosf(t * 17.0f) * 4.0f, sinf(t * 11.0f) * 3.0f, cosf(t * 5.0f) * 3.0f, 1.0f);
+        vec3 N = normalized(vec3(sinf(t * 13.0f), cosf(t * 7.0f), sinf(t * 3.0f) + 0.1f));
+        normals.x[i] = N.x;
+        normals.y[i] = N.y;
+        normals.z[i] = N.z;
+    }
+    VertexPositions positions = create_vertex_positions(vertices, arena);
+
+    MeshLights lights = {};
+    lights.ambient.color = vec4(0.1f, 0.2f, 0.3f, 1.0f);
+    lights.directional = Array<DirectionalLight>::create(1, arena);
+    lights.directional[0].L = vec4(0.0f, 0.6f, -0.8f, 0.0f);
+    lights.directional[0].color = vec4(0.5f, 0.4f, 0.3f, 1.0f);
+    lights.point = Array<PointLight>::create(1, arena);
+    lights.point[0].P = vec4(1.0f, -2.0f, 0.5f, 1.0f);
+    lights.point[0].color = vec4(0.2f, 0.3f, 0.6f, 1.0f);
+
+    VertexLight expected = create_vertex_light(count, arena);
+    light_vertices_scalar(positions, normals, count, lights, &expected);
+    for (u32 i = 0; i < count; i++) {
+        vec3 N = vec3(normals.x[i], normals.y[i], normals.z[i]);
+        vec3 L_point = normalized(vec3(lights.point[0].P.x, lights.point[0].P.y, lights.point[0].P.z) -
+                                  vec3(vertices[i].x, vertices[i].y, vertices[i].z));
+        f32 directional = hm::max(dot(N, vec3(0.0f, 0.6f, -0.8f)), 0.0f);
+        f32 point = hm::max(dot(N, L_point), 0.0f);
+        REQUIRE_EQ(expected.r[i], doctest::Approx(0.1f + 0.5f * directional + 0.2f * point));
+        REQUIRE_EQ(expected.g[i], doctest::Approx(0.2f + 0.4f * directional + 0.3f * point));
+        REQUIRE_EQ(expected.b[i], doctest::Approx(0.3f + 0.3f * directional + 0.6f * point));
+    }
+
+    for (auto light : light_vertices_kernels()) {
+        VertexLight result = create_vertex_light(count, arena);
+        light(positions, normals, count, lights, &result);
+        for (u32 i = 0; i < count; i++) {
+            REQUIRE_EQ(result.r[i], doctest::Approx(expected.r[i]).epsilon(1e-5));
+            REQUIRE_EQ(result.g[i], doctest::Approx(expected.g[i]).epsilon(1e-5));
+            REQUIRE_EQ(result.b[i], doctest::Approx(expected.b[i]).epsilon(1e-5));
+        }
+    }
+    free(arena.m_memory);
+}
+
+// The light of the lit mesh test at a cube vertex: a gray ambient and a gray light shining down the view
+static auto expected_cube_vertex_light(const TriMesh& cube, const mat4& M_to_W, i32 i) -> f32 {
+    vec4 N = vec4(cube.vertex_normals.x[i], cube.vertex_normals.y[i], cube.vertex_normals.z[i], 0.0f) * M_to_W;
+    return 0.2f + 0.5f * hm::max(dot(normalized(N.xyz()), vec3(0.0f, 0.0f, -1.0f)), 0.0f);
+}
+
+TEST_CASE("transform_mesh_instance gives every triangle of a lit mesh its corner colors") {
+    MemoryArena arena = {};
+    arena.init(malloc(MegaBytes(1)), MegaBytes(1));
+    TriMesh cube = {};
+    generate_cube_mesh(&cube, &arena);
+    auto colors = Array<vec4>::create(1, arena);
+    colors[0] = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    mat4 world_to_view = lookAt(vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 1.0f, 0.0f));
+    vec4 camera_position = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+    MeshLights lights = {};
+    lights.ambient.color = vec4(0.2f, 0.2f, 0.2f, 1.0f);
+    lights.directional = Array<DirectionalLight>::create(1, arena);
+    lights.directional[0].L = vec4(0.0f, 0.0f, -1.0f, 0.0f);
+    lights.directional[0].color = vec4(0.5f, 0.5f, 0.5f, 1.0f);
+
+    MeshInstance instance = {};
+    instance.transform.rotation = angle_axis(0.6f, normalized(vec3(0.2f, 1.0f, 0.3f)));
+    instance.transform.scale = vec3(1.0f, 1.0f, 1.0f);
+    instance.colors = colors;
+
+    SUBCASE("inside the view") {
+        instance.transform.position = vec3(0.0f, 0.0f, 6.0f);
+        ScreenMesh mesh = transform_mesh_instance(cube, instance, world_to_view,
+            perspective(60.0f, 16.0f / 9.0f, 0.1f, 1000.0f), camera_position, &lights, 320, 180, arena);
+        REQUIRE(mesh.triangles.count() > 0);
+        REQUIRE_EQ(mesh.corner_colors.count(), 3 * mesh.triangles.count());
+
+        // Nothing is clipped, so the corners are the cube's vertices, shaded by the light of their averaged normal
+        mat4 M_to_W = instance.transform.to_mat4();
+        vec4 white_l1 = srgb_to_linear1(colors[0]);
+        vec4 ambient = shade_color(white_l1, 0.2f, 0.2f, 0.2f);
+        bool is_lit_past_ambient = false;
+        for (u32 i = 0; i < mesh.triangles.count(); i++) {
+            for (i32 j = 0; j < 3; j++) {
+                i32 vertex_idx = mesh.triangles[i].v[j];
+                REQUIRE(vertex_idx < (i32)cube.vertex_count);
+                f32 light = expected_cube_vertex_light(cube, M_to_W, vertex_idx);
+                vec4 expected = shade_color(white_l1, light, light, light);
+                vec4 color = mesh.corner_colors[3 * i + j];
+                // One step of the sRGB lookup either way
+                REQUIRE(fabsf(color.r - expected.r) <= 1.0f / 255.0f);
+                REQUIRE(fabsf(color.g - expected.g) <= 1.0f / 255.0f);
+                REQUIRE(fabsf(color.b - expected.b) <= 1.0f / 255.0f);
+                REQUIRE_EQ(color.a, 1.0f);
+                is_lit_past_ambient |= color.r > ambient.r;
+            }
+        }
+        REQUIRE(is_lit_past_ambient);
+    }
+
+    SUBCASE("crossing the near plane") {
+        instance.transform.position = vec3(0.0f, 0.0f, 2.2f);
+        mat4 view_to_clip = perspective(60.0f, 16.0f / 9.0f, 1.0f, 1000.0f);
+        ScreenMesh mesh = transform_mesh_instance(cube, instance, world_to_view, view_to_clip, camera_position,
+            &lights, 320, 180, arena);
+        REQUIRE(mesh.vertices.count() > cube.vertex_count);
+        REQUIRE_EQ(mesh.corner_colors.count(), 3 * mesh.triangles.count());
+
+        // The clipper keeps the cube's vertices in front of the near plane and makes new ones on the edges crossing it,
+        // lit between the edge's two vertices
+        mat4 M_to_W = instance.transform.to_mat4();
+        mat4 M_to_Clip = M_to_W * world_to_view * view_to_clip;
+        vec4 white_l1 = srgb_to_linear1(colors[0]);
+        u32 made_count = 0;
+        for (u32 i = 0; i < mesh.triangles.count(); i++) {
+            for (i32 j = 0; j < 3; j++) {
+                i32 vertex_idx = mesh.triangles[i].v[j];
+                if (vertex_idx < (i32)cube.vertex_count) {
+                    continue;
+                }
+                vec3 P = mesh.vertices[vertex_idx];
+                vec4 color = mesh.corner_colors[3 * i + j];
+                bool is_kept = false;
+                for (u32 k = 0; k < cube.vertex_count; k++) {
+                    vec4 A = get_vertex_position(cube.positions, k) * M_to_Clip;
+                    vec3 Q = project_vertex(A, 320, 180);
+                    if (A.z + A.w < 0.0f || fabsf(Q.x - P.x) > 0.01f || fabsf(Q.y - P.y) > 0.01f) {
+                        continue;
+                    }
+                    f32 light = expected_cube_vertex_light(cube, M_to_W, k);
+                    REQUIRE(fabsf(color.r - shade_color(white_l1, light, light, light).r) <= 1.0f / 255.0f);
+                    is_kept = true;
+                }
+                if (is_kept) {
+                    continue;
+                }
+                bool is_on_edge = false;
+                for (ivec3 triangle : cube.triangles) {
+                    for (i32 k = 0; k < 3; k++) {
+                        i32 a = triangle.v[k];
+                        i32 b = triangle.v[(k + 1) % 3];
+                        vec4 A = get_vertex_position(cube.positions, a) * M_to_Clip;
+                        vec4 B = get_vertex_position(cube.positions, b) * M_to_Clip;
+                        f32 d_a = A.z + A.w;
+                        f32 d_b = B.z + B.w;
+                        if ((d_a < 0.0f) == (d_b < 0.0f)) {
+                            continue;
+                        }
+                        vec3 Q = project_vertex(lerp(A, -d_a / (d_b - d_a), B), 320, 180);
+                        if (fabsf(Q.x - P.x) > 0.01f || fabsf(Q.y - P.y) > 0.01f) {
+                            continue;
+                        }
+                        f32 light_a = expected_cube_vertex_light(cube, M_to_W, a);
+                        f32 light_b = expected_cube_vertex_light(cube, M_to_W, b);
+                        vec4 color_a = shade_color(white_l1, light_a, light_a, light_a);
+                        vec4 color_b = shade_color(white_l1, light_b, light_b, light_b);
+                        REQUIRE(color.r >= hm::min(color_a.r, color_b.r) - 1.0f / 255.0f);
+                        REQUIRE(color.r <= hm::max(color_a.r, color_b.r) + 1.0f / 255.0f);
+                        is_on_edge = true;
+                    }
+                }
+                REQUIRE(is_on_edge);
+                made_count++;
+            }
+        }
+        REQUIRE(made_count > 0);
+    }
+    free(arena.m_memory);
+}
@@ -0,0 +1,179 @@
+#include "doctest.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <renderers/cpu_render_algorithms.hpp>
+
+static Framebuffer make_depth_buffer(i32 width, i32 height) {
+    Framebuffer buffer;
+    buffer.bytes_per_pixel = 4;
+    buffer.height = height;
+    buffer.width = width;
+    buffer.pitch = buffer.width * buffer.bytes_per_pixel;
+    buffer.memory_size = buffer.width * buffer.height * buffer.bytes_per_pixel;
+    buffer.memory = calloc(1, buffer.memory_size);
+    buffer.z_buffer = Array<f32>((f32*)calloc(width * height, sizeof(f32)), width * height);
+    buffer.z_block_count_x = z_block_count(width);
+    i32 block_count = buffer.z_block_count_x * z_block_count(height);
+    buffer.z_blocks = Array<f32>((f32*)calloc(block_count, sizeof(f32)), block_count);
+    return buffer;
+}
+
+static void free_depth_buffer(Framebuffer& buffer) {
+    free(buffer.memory);
+    free(buffer.z_buffer.data());
+    free(buffer.z_blocks.data());
+}
+
+static auto half_space_rasterizers() -> Array<render_triangle_filled_fn> {
+    static render_triangle_filled_fn rasterizers[2] = {
+        render_triangle_filled_half_space_avx2,
+        render_triangle_filled_half_space_avx512,
+    };
+    return Array<render_triangle_filled_fn>(rasterizers, cpu_supports_avx512f() ? 2 : 1);
+}
+
+TEST_CASE("half space rasterizer covers a quad made of two triangles without gaps") {
+    MemoryArena arena = {};
+    for (auto rasterize : half_space_rasterizers()) {
+        Framebuffer buffer = make_depth_buffer(37, 21);
+        Rectangle2i rect = { 0, buffer.width, 0, buffer.height };
+        f32 w = (f32)buffer.width;
+        f32 h = (f32)buffer.height;
+        rasterize(vec3(0, 0, 0.5f), vec3(w, 0, 0.5f), vec3(w, h, 0.5f), vec4(1, 0, 0, 1), rect, buffer, arena);
+        rasterize(vec3(0, 0, 0.5f), vec3(w, h, 0.5f), vec3(0, h, 0.5f), vec4(0, 1, 0, 1), rect, buffer, arena);
+
+        for (i32 y = 0; y < buffer.height; y++) {
+            for (i32 x = 0; x < buffer.width; x++) {
+                REQUIRE_NE(*buffer.get_pixel(x, y), 0);
+            }
+        }
+        free_depth_buffer(buffer);
+    }
+}
+
+TEST_CASE("half space rasterizer only writes inside the clip rect") {
+    MemoryArena arena = {};
+    for (auto rasterize : half_space_rasterizers()) {
+        Framebuffer buffer = make_depth_buffer(40, 36);
+        Rectangle2i rect = { 5, 21, 3, 30 };
+        rasterize(vec3(-10, -10, 0.5f), vec3(80, -10, 0.5f), vec3(-10, 80, 0.5f), vec4(1, 1, 1, 1), rect, buffer, arena);
+
+        for (i32 y = 0; y < buffer.height; y++) {
+            for (i32 x = 0; x < buffer.width; x++) {
+                bool is_inside = x >= rect.min_x && x < rect.max_x && y >= rect.min_y && y < rect.max_y;
+                REQUIRE_EQ(*buffer.get_pixel(x, y) != 0, is_inside);
+            }
+        }
+        free_depth_buffer(buffer);
+    }
+}
+
+TEST_CASE("half space rasterizer rejects pixels behind the depth buffer") {
+    MemoryArena arena = {};
+    for (auto rasterize : half_space_rasterizers()) {
+        Framebuffer buffer = make_depth_buffer(16, 16);
+        Rectangle2i rect = { 0, buffer.width, 0, buffer.height };
+        vec3 P0 = vec3(-1, -1, 0);
+        vec3 P1 = vec3(40, -1, 0);
+        vec3 P2 = vec3(-1, 40, 0);
+
+        // 1/w, so the larger z is closer
+        P0.z = P1.z = P2.z = 0.8f;
+        rasterize(P0, P1, P2, vec4(1, 0, 0, 1), rect, buffer, arena);
+        P0.z = P1.z = P2.z = 0.2f;
+        rasterize(P0, P1, P2, vec4(0, 1, 0, 1), rect, buffer, arena);
+
+        u32 red = pack_color_8x4(vec4(1, 0, 0, 1));
+        REQUIRE_EQ(*buffer.get_pixel(0, 0), red);
+        REQUIRE_EQ(*buffer.get_pixel(15, 15), red);
+        REQUIRE_EQ(buffer.z_buffer[0], doctest::Approx(0.8f));
+        free_depth_buffer(buffer);
+    }
+}
+
+TEST_CASE("shaded half space rasterizer matches the filled one when the corners agree") {
+    MemoryArena arena = {};
+    render_triangle_shaded_fn shaded_rasterizers[2] = {
+        render_triangle_shaded_half_space_avx2,
+        render_triangle_shaded_half_space_avx512,
+    };
+    auto filled_rasterizers = half_space_rasterizers();
+    for (u32 i = 0; i < filled_rasterizers.count(); i++) {
+        Framebuffer filled = make_depth_buffer(37, 21);
+        Framebuffer shaded = make_depth_buffer(37, 21);
+        Rectangle2i rect = { 0, filled.width, 0, filled.height };
+        vec3 P0 = vec3(-3.0f, 2.5f, 0.5f);
+        vec3 P1 = vec3(30.2f, -1.0f, 0.25f);
+        vec3 P2 = vec3(12.7f, 25.0f, 0.75f);
+        vec4 color = vec4(0.25f, 0.5f, 0.75f, 1.0f);
+        filled_rasterizers[i](P0, P1, P2, color, rect, filled, arena);
+        shaded_rasterizers[i](P0, P1, P2, color, color, color, rect, shaded, arena);
+        REQUIRE_EQ(memcmp(filled.memory, shaded.memory, filled.memory_size), 0);
+        REQUIRE_EQ(memcmp(filled.z_buffer.data(), shaded.z_buffer.data(), filled.z_buffer.count() * sizeof(f32)), 0);
+
+        // Blends between the corners when they do not
+        memset(shaded.memory, 0, shaded.memory_size);
+        memset(shaded.z_buffer.data(), 0, shaded.z_buffer.count() * sizeof(f32));
+        memset(shaded.z_blocks.data(), 0, shaded.z_blocks.count() * sizeof(f32));
+        shaded_rasterizers[i](vec3(0, 0, 0.5f), vec3(37, 0, 0.5f), vec3(0, 37, 0.5f), vec4(1, 0, 0, 1),
+            vec4(0, 0, 1, 1), vec4(0, 0, 1, 1), rect, shaded, arena);
+        u32 near_red = *shaded.get_pixel(0, 0);
+        u32 near_blue = *shaded.get_pixel(30, 2);
+        REQUIRE(((near_red >> 16) & 0xFF) > (near_red & 0xFF));
+        REQUIRE(((near_blue >> 16) & 0xFF) < (near_blue & 0xFF));
+        free_depth_buffer(filled);
+        free_depth_buffer(shaded);
+    }
+}
+
+TEST_CASE("half space rasterizer raises the coarse depth of the blocks it writes") {
+    MemoryArena arena = {};
+    for (auto rasterize : half_space_rasterizers()) {
+        Framebuffer buffer = make_depth_buffer(36, 20);
+        Rectangle2i rect = { 0, buffer.width, 0, buffer.height };
+        vec3 P0 = vec3(-1, -1, 0.5f);
+        vec3 P1 = vec3(80, -1, 0.5f);
+        vec3 P2 = vec3(-1, 80, 0.5f);
+        rasterize(P0, P1, P2, vec4(1, 0, 0, 1), rect, buffer, arena);
+
+        // Every block is covered, including the ones cut by the buffer edge.
+        for (u32 i = 0; i < buffer.z_blocks.count(); i++) {
+            REQUIRE_EQ(buffer.z_blocks[i], doctest::Approx(0.5f));
+        }
+
+        // Hidden behind the first triangle, so every block is rejected and nothing is written.
+        P0.z = P1.z = P2.z = 0.25f;
+        rasterize(P0, P1, P2, vec4(0, 1, 0, 1), rect, buffer, arena);
+        REQUIRE_EQ(*buffer.get_pixel(20, 10), pack_color_8x4(vec4(1, 0, 0, 1)));
+
+        reset_z_blocks(buffer, rect);
+        REQUIRE_EQ(buffer.z_blocks[0], 0.0f);
+        free_depth_buffer(buffer);
+    }
+}
+
+TEST_CASE("initialize_tile_depth clears a tile's depth once, on first use") {
+    Framebuffer buffer = make_depth_buffer(32, 16);
+    for (u32 i = 0; i < buffer.z_buffer.count(); i++) {
+        buffer.z_buffer[i] = 0.5f;
+    }
+    for (u32 i = 0; i < buffer.z_blocks.count(); i++) {
+        buffer.z_blocks[i] = 0.5f;
+    }
+
+    Tile tile = { .rect = { 0, 16, 0, 16 } };
+    initialize_tile_depth(buffer, &tile);
+    REQUIRE(tile.is_depth_initialized);
+    REQUIRE_EQ(buffer.z_buffer[15 * buffer.width + 15], 0.0f);
+    REQUIRE_EQ(*get_z_block(buffer, 8, 8), 0.0f);
+    // Outside of the tile is left alone
+    REQUIRE_EQ(buffer.z_buffer[15 * buffer.width + 16], 0.5f);
+    REQUIRE_EQ(*get_z_block(buffer, 16, 0), 0.5f);
+
+    // Already initialized, so depth written since is kept
+    buffer.z_buffer[0] = 0.75f;
+    initialize_tile_depth(buffer, &tile);
+    REQUIRE_EQ(buffer.z_buffer[0], 0.75f);
+    free_depth_buffer(buffer);
+}
@@ -94,42 +94,22 @@ static void fill_solid(Framebuffer& buffer, u32 color) {
             buffer.set_pixel(x, y, color);
 }
 
-// Golden reference for a full-canvas nearest-neighbor scale of a src_w x src_h
-// quadrant pattern into `dest` (offset 0,0, apply width/height == dest width/height).
+// Golden reference for a nearest-neighbor integer scale of a src_w x src_h
+// quadrant pattern into `dest`.
 static void fill_expected_scaled_quadrants(Framebuffer& dest, i32 src_w, i32 src_h) {
-    f32 scale_x = (f32)dest.width / src_w;
-    f32 scale_y = (f32)dest.height / src_h;
+    i32 scale_x = dest.width / src_w;
+    i32 scale_y = dest.height / src_h;
     i32 half_w = src_w / 2;
     i32 half_h = src_h / 2;
     for (i32 y = 0; y < dest.height; y++) {
-        i32 src_y = (i32)(y / scale_y);
+        i32 src_y = y / scale_y;
         for (i32 x = 0; x < dest.width; x++) {
-            i32 src_x = (i32)(x / scale_x);
+            i32 src_x = x / scale_x;
             dest.set_pixel(x, y, quadrant_color(src_x, src_y, half_w, half_h));
         }
     }
 }
 
-// Golden reference for placing an unscaled src_w x src_h quadrant pattern into
-// `dest` at (offset_x, offset_y), clipped to dest bounds, with `background`
-// everywhere else.
-static void fill_expected_translated_quadrants(Framebuffer& dest, u32 background, i32 src_w, i32 src_h, i32 offset_x, i32 offset_y) {
-    i32 half_w = src_w / 2;
-    i32 half_h = src_h / 2;
-    for (i32 y = 0; y < dest.height; y++) {
-        for (i32 x = 0; x < dest.width; x++) {
-            i32 src_x = x - offset_x;
-            i32 src_y = y - offset_y;
-            if (src_x >= 0 && src_x < src_w && src_y >= 0 && src_y < src_h) {
-                dest.set_pixel(x, y, quadrant_color(src_x, src_y, half_w, half_h));
-            }
-            else {
-                dest.set_pixel(x, y, background);
-            }
-        }
-    }
-}
-
 // Checkerboard: every other pixel is transparent (0), forcing per-pixel
 // select/masking behaviour rather than a single block copy/skip.
 static void fill_checkerboard(Framebuffer& buffer, u32 opaque_color) {
@@ -138,97 +118,159 @@ static void fill_checkerboard(Framebuffer& buffer, u32 opaque_color) {
             buffer.set_pixel(x, y, ((x + y) % 2 == 0) ? opaque_color : 0);
 }
 
-TEST_CASE_FIXTURE(RendererArenaFixture, "apply_frame_buffer copies a matching-size buffer 1:1 (32x32)") {
-    Framebuffer src = create_frame_buffer(arena, 32, 32);
-    Framebuffer dest = create_frame_buffer(arena, 32, 32);
-    fill_quadrants(src);
-
-    string8 src_str = buffer_to_string(src, arena);
-    INFO("src:\n", src_str.data);
-    apply_frame_buffer(&src, &dest, dest.width, dest.height, 0, 0, 0, 32);
-    string8 dest_str = buffer_to_string(dest, arena);
-    INFO("dest:\n", dest_str.data);
-
-    REQUIRE(string8_equal(dest_str, src_str));
+static void apply_whole_frame_buffer(apply_frame_buffer_fn apply, Framebuffer* src, Framebuffer* dest, ivec2 scale) {
+    Tile tile = {};
+    tile.rect = { 0, src->width, 0, src->height };
+    tile.is_dirty = true;
+    apply(src, &tile, dest, scale);
 }
 
-TEST_CASE_FIXTURE(RendererArenaFixture, "apply_frame_buffer skips transparent src pixels, leaving dest untouched (32x35)") {
-    // Width must be a multiple of the AVX512 path's 16-wide lane count (see the
-    // `(end_x - start_x) % LANE_COUNT == 0` assert in apply_frame_buffer_AVX512);
-    // only the height is free to be an arbitrary value.
-    Framebuffer src = create_frame_buffer(arena, 32, 35);
-    Framebuffer dest = create_frame_buffer(arena, 32, 35);
-    fill_checkerboard(src, Color_Opaque);
-    fill_solid(dest, Color_Sentinel);
-
-    Framebuffer expected = create_frame_buffer(arena, 32, 35);
-    for (i32 y = 0; y < expected.height; y++)
-        for (i32 x = 0; x < expected.width; x++)
-            expected.set_pixel(x, y, ((x + y) % 2 == 0) ? Color_Opaque : Color_Sentinel);
-
-    INFO("src (checkerboard, '.' = transparent):\n", buffer_to_string(src, arena).data);
-    apply_frame_buffer(&src, &dest, dest.width, dest.height, 0, 0, 0, dest.height);
-    string8 dest_str = buffer_to_string(dest, arena);
-    string8 expected_str = buffer_to_string(expected, arena);
-    INFO("dest:\n", dest_str.data);
-
-    REQUIRE(string8_equal(dest_str, expected_str));
+// Every apply_frame_buffer path this CPU can run, the scalar reference first.
+static auto apply_frame_buffer_paths() -> Array<apply_frame_buffer_fn> {
+    static apply_frame_buffer_fn paths[5];
+    u32 count = 0;
+    paths[count++] = apply_frame_buffer_scalar;
+    if (cpu_supports_avx2()) {
+        paths[count++] = apply_frame_buffer_AVX2;
+        paths[count++] = apply_frame_buffer_stream_AVX2;
+    }
+    if (cpu_supports_avx512f()) {
+        paths[count++] = apply_frame_buffer_AVX512;
+        paths[count++] = apply_frame_buffer_stream_AVX512;
+    }
+    return Array<apply_frame_buffer_fn>(paths, count);
 }
 
-TEST_CASE_FIXTURE(RendererArenaFixture, "apply_frame_buffer nearest-neighbor upscales quadrants by an exact 2x (32x32 -> 64x64)") {
-    Framebuffer src = create_frame_buffer(arena, 32, 32);
-    Framebuffer dest = create_frame_buffer(arena, 64, 64);
-    fill_quadrants(src);
-
-    Framebuffer expected = create_frame_buffer(arena, 64, 64);
-    fill_expected_scaled_quadrants(expected, src.width, src.height);
-
-    INFO("src:\n", buffer_to_string(src, arena).data);
-    apply_frame_buffer(&src, &dest, dest.width, dest.height, 0, 0, 0, 64);
-    string8 dest_str = buffer_to_string(dest, arena);
-    string8 expected_str = buffer_to_string(expected, arena);
-    INFO("dest:\n", dest_str.data);
-
-    REQUIRE(string8_equal(dest_str, expected_str));
+TEST_CASE_FIXTURE(RendererArenaFixture, "apply_frame_buffer copies a matching-size buffer 1:1 (32x32)") {
+    for (auto apply : apply_frame_buffer_paths()) {
+        Framebuffer src = create_frame_buffer(arena, 32, 32);
+        Framebuffer dest = create_frame_buffer(arena, 32, 32);
+        fill_quadrants(src);
+
+        string8 src_str = buffer_to_string(src, arena);
+        INFO("src:\n", src_str.data);
+        apply_whole_frame_buffer(apply, &src, &dest, { 1, 1 });
+        string8 dest_str = buffer_to_string(dest, arena);
+        INFO("dest:\n", dest_str.data);
+
+        REQUIRE(string8_equal(dest_str, src_str));
+        arena.clear();
+    }
 }
 
-TEST_CASE_FIXTURE(RendererArenaFixture,
-    "apply_frame_buffer places an unscaled block at an offset inside a larger canvas (32x32 into 64x64 at 16,16)") {
-    Framebuffer src = create_frame_buffer(arena, 32, 32);
-    Framebuffer dest = create_frame_buffer(arena, 64, 64);
-    fill_quadrants(src);
-    fill_solid(dest, Color_Sentinel);
-
-    Framebuffer expected = create_frame_buffer(arena, 64, 64);
-    fill_expected_translated_quadrants(expected, Color_Sentinel, src.width, src.height, 16, 16);
-
-    INFO("src:\n", buffer_to_string(src, arena).data);
-    apply_frame_buffer(&src, &dest, src.width, src.height, 16, 16, 0, 64);
-    string8 dest_str = buffer_to_string(dest, arena);
-    string8 expected_str = buffer_to_string(expected, arena);
-    INFO("dest:\n", dest_str.data);
+TEST_CASE_FIXTURE(RendererArenaFixture, "apply_frame_buffer skips transparent src pixels, leaving dest untouched (37x35)") {
+    for (auto apply : apply_frame_buffer_paths()) {
+        Framebuffer src = create_frame_buffer(arena, 37, 35);
+        Framebuffer dest = create_frame_buffer(arena, 37, 35);
+        fill_checkerboard(src, Color_Opaque);
+        fill_solid(dest, Color_Sentinel);
+
+        Framebuffer expected = create_frame_buffer(arena, 37, 35);
+        for (i32 y = 0; y < expected.height; y++)
+            for (i32 x = 0; x < expected.width; x++)
+                expected.set_pixel(x, y, ((x + y) % 2 == 0) ? Color_Opaque : Color_Sentinel);
+
+        INFO("src (checkerboard, '.' = transparent):\n", buffer_to_string(src, arena).data);
+        apply_whole_frame_buffer(apply, &src, &dest, { 1, 1 });
+        string8 dest_str = buffer_to_string(dest, arena);
+        string8 expected_str = buffer_to_string(expected, arena);
+        INFO("dest:\n", dest_str.data);
+
+        REQUIRE(string8_equal(dest_str, expected_str));
+        arena.clear();
+    }
+}
 
-    REQUIRE(string8_equal(dest_str, expected_str));
+TEST_CASE_FIXTURE(RendererArenaFixture, "apply_frame_buffer nearest-neighbor upscales quadrants by integer scales") {
+    i32 scales[] = { 2, 3, 4, 8 };
+    for (auto apply : apply_frame_buffer_paths()) {
+        for (i32 scale : scales) {
+            Framebuffer src = create_frame_buffer(arena, 14, 12);
+            Framebuffer dest = create_frame_buffer(arena, src.width * scale, src.height * scale);
+            fill_quadrants(src);
+
+            Framebuffer expected = create_frame_buffer(arena, dest.width, dest.height);
+            fill_expected_scaled_quadrants(expected, src.width, src.height);
+
+            INFO("scale: ", scale);
+            apply_whole_frame_buffer(apply, &src, &dest, { scale, scale });
+            string8 dest_str = buffer_to_string(dest, arena);
+            string8 expected_str = buffer_to_string(expected, arena);
+            INFO("dest:\n", dest_str.data);
+
+            REQUIRE(string8_equal(dest_str, expected_str));
+            arena.clear();
+        }
+    }
 }
 
-TEST_CASE_FIXTURE(RendererArenaFixture,
-    "apply_frame_buffer clips a positive offset that overhangs the far edge of dest (32x32 src into 32x32 dest at "
-    "16,16)") {
-    Framebuffer src = create_frame_buffer(arena, 32, 32);
-    Framebuffer dest = create_frame_buffer(arena, 32, 32);
-    fill_quadrants(src);
-    fill_solid(dest, Color_Sentinel);
+TEST_CASE_FIXTURE(RendererArenaFixture, "apply_frame_buffer SIMD paths match the scalar path tile by tile") {
+    ivec2 scales[] = { { 1, 1 }, { 2, 2 }, { 3, 3 }, { 4, 4 }, { 8, 8 }, { 3, 2 } };
+    Array<apply_frame_buffer_fn> paths = apply_frame_buffer_paths();
+    for (ivec2 scale : scales) {
+        Framebuffer src = create_frame_buffer(arena, 27, 12);
+        src.tiles = generate_tiles(src.width, src.height, 9, 4, &arena);
+        fill_quadrants(src);
+        for (i32 y = 0; y < src.height; y++)
+            for (i32 x = (y % 3); x < src.width; x += 3)
+                src.set_pixel(x, y, 0);
+
+        Framebuffer expected = create_frame_buffer(arena, src.width * scale.x, src.height * scale.y);
+        fill_solid(expected, Color_Sentinel);
+        for (auto& tile : src.tiles) {
+            tile.is_dirty = true;
+            apply_frame_buffer_scalar(&src, &tile, &expected, scale);
+        }
+        string8 expected_str = buffer_to_string(expected, arena);
+
+        // One dest for every path, the 8x8 buffers do not fit the arena once per path
+        Framebuffer dest = create_frame_buffer(arena, expected.width, expected.height);
+        for (u32 i = 1; i < paths.count(); i++) {
+            fill_solid(dest, Color_Sentinel);
+            // Every other tile, so writing outside a tile shows up as a mismatch.
+            for (u32 tile_idx = 0; tile_idx < src.tiles.count(); tile_idx += 2) {
+                paths[i](&src, &src.tiles[tile_idx], &dest, scale);
+            }
+            for (u32 tile_idx = 1; tile_idx < src.tiles.count(); tile_idx += 2) {
+                paths[i](&src, &src.tiles[tile_idx], &dest, scale);
+            }
 
-    Framebuffer expected = create_frame_buffer(arena, 32, 32);
-    fill_expected_translated_quadrants(expected, Color_Sentinel, src.width, src.height, 16, 16);
+            INFO("scale: ", scale.x, "x", scale.y, ", path: ", i);
+            string8 dest_str = buffer_to_string(dest, arena);
+            INFO("dest:\n", dest_str.data);
+            REQUIRE(string8_equal(dest_str, expected_str));
+        }
+        arena.clear();
+    }
+}
 
-    INFO("src:\n", buffer_to_string(src, arena).data);
-    apply_frame_buffer(&src, &dest, src.width, src.height, 16, 16, 0, 32);
-    string8 dest_str = buffer_to_string(dest, arena);
-    string8 expected_str = buffer_to_string(expected, arena);
-    INFO("dest:\n", dest_str.data);
+TEST_CASE_FIXTURE(RendererArenaFixture, "apply_frame_buffer only writes the dest rect of the given tile") {
+    for (auto apply : apply_frame_buffer_paths()) {
+        Framebuffer src = create_frame_buffer(arena, 32, 32);
+        Framebuffer dest = create_frame_buffer(arena, 64, 64);
+        fill_quadrants(src);
+        fill_solid(dest, Color_Sentinel);
+
+        Tile tile = {};
+        tile.rect = { 8, 24, 8, 24 };
+        tile.is_dirty = true;
+        apply(&src, &tile, &dest, { 2, 2 });
+
+        for (i32 y = 0; y < dest.height; y++) {
+            for (i32 x = 0; x < dest.width; x++) {
+                bool is_inside = x >= 16 && x < 48 && y >= 16 && y < 48;
+                u32 expected = is_inside ? quadrant_color(x / 2, y / 2, 16, 16) : Color_Sentinel;
+                REQUIRE_EQ(*dest.get_pixel(x, y), expected);
+            }
+        }
 
-    REQUIRE(string8_equal(dest_str, expected_str));
+        // A clean tile is not applied at all
+        tile.is_dirty = false;
+        fill_solid(dest, Color_Sentinel);
+        apply(&src, &tile, &dest, { 2, 2 });
+        REQUIRE_EQ(*dest.get_pixel(20, 20), Color_Sentinel);
+        arena.clear();
+    }
 }
 
 TEST_CASE_FIXTURE(RendererArenaFixture, "Set chunk dirty") {
@@ -250,3 +292,303 @@ TEST_CASE_FIXTURE(RendererArenaFixture, "Set chunk dirty") {
     REQUIRE(tiles[127].rect.min_y == height - tile_dim_y);
     REQUIRE(tiles[127].rect.max_y == height);
 }
+
+static RenderGroup create_render_group(MemoryArena& arena, i32 max_command_count) {
+    RenderGroup group = {};
+    group.max_push_buffer_size = KiloBytes(64);
+    group.push_buffer = allocate<u8>(arena, group.max_push_buffer_size);
+    init_render_group_commands(&group, &arena, max_command_count);
+    return group;
+}
+
+static void push_white_quad(RenderGroup* group, f32 min_x, f32 min_y, f32 max_x, f32 max_y) {
+    RenderEntryQuad quad = {};
+    quad.quad = { .min_x = min_x, .max_x = max_x, .min_y = min_y, .max_y = max_y };
+    quad.color = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    push_quad(group, quad, 0);
+}
+
+TEST_CASE_FIXTURE(RendererArenaFixture, "bin_render_commands only bins commands into the tiles they overlap") {
+    Framebuffer buffer = create_frame_buffer(arena, 64, 64);
+    buffer.tiles = generate_tiles(buffer.width, buffer.height, 16, 16, &arena);
+
+    RenderGroup group = create_render_group(arena, 16);
+    push_clear(&group, {}, 0);
+    push_white_quad(&group, 2.0f, 2.0f, 10.0f, 10.0f);    // tile (0, 0)
+    push_white_quad(&group, 20.0f, 20.0f, 40.0f, 24.0f);  // tiles (1, 1) and (2, 1)
+    push_white_quad(&group, 100.0f, 0.0f, 120.0f, 10.0f); // off screen
+
+    i32 order[4] = { 0, 1, 2, 3 };
+    TileBins bins = bin_render_commands(&group, order, &buffer, &arena);
+    REQUIRE(bins.tile_count == 16);
+
+    REQUIRE(tile_bins_count(&bins, 0) == 2);
+    CHECK(tile_bins_commands(&bins, 0)[0] == 0);
+    CHECK(tile_bins_commands(&bins, 0)[1] == 1);
+
+    REQUIRE(tile_bins_count(&bins, 5) == 2);
+    CHECK(tile_bins_commands(&bins, 5)[1] == 2);
+    REQUIRE(tile_bins_count(&bins, 6) == 2);
+    CHECK(tile_bins_commands(&bins, 6)[1] == 2);
+
+    for (i32 i = 0; i < bins.tile_count; i++) {
+        if (i != 0 && i != 5 && i != 6) {
+            REQUIRE(tile_bins_count(&bins, i) == 1);
+            CHECK(tile_bins_commands(&bins, i)[0] == 0);
+        }
+    }
+}
+
+TEST_CASE_FIXTURE(RendererArenaFixture, "bin_render_commands keeps render order within a tile") {
+    Framebuffer buffer = create_frame_buffer(arena, 32, 32);
+    buffer.tiles = generate_tiles(buffer.width, buffer.height, 16, 16, &arena);
+
+    RenderGroup group = create_render_group(arena, 4);
+    push_white_quad(&group, 2.0f, 2.0f, 4.0f, 4.0f);
+    push_white_quad(&group, 2.0f, 2.0f, 4.0f, 4.0f);
+    push_white_quad(&group, 2.0f, 2.0f, 4.0f, 4.0f);
+
+    i32 order[3] = { 2, 0, 1 };
+    TileBins bins = bin_render_commands(&group, order, &buffer, &arena);
+    REQUIRE(tile_bins_count(&bins, 0) == 3);
+    CHECK(tile_bins_commands(&bins, 0)[0] == 2);
+    CHECK(tile_bins_commands(&bins, 0)[1] == 0);
+    CHECK(tile_bins_commands(&bins, 0)[2] == 1);
+    CHECK(tile_bins_count(&bins, 3) == 0);
+}
+
+TEST_CASE_FIXTURE(RendererArenaFixture, "copy_render_group bins like the source after the source is reused") {
+    Framebuffer buffer = create_frame_buffer(arena, 64, 64);
+    buffer.tiles = generate_tiles(buffer.width, buffer.height, 16, 16, &arena);
+
+    RenderGroup group = create_render_group(arena, 4);
+    push_white_quad(&group, 2.0f, 2.0f, 10.0f, 10.0f);   // tile (0, 0)
+    push_white_quad(&group, 20.0f, 20.0f, 40.0f, 24.0f); // tiles (1, 1) and (2, 1)
+    RenderGroup copy = copy_render_group(&group, &arena);
+
+    // The engine reuses its group memory as soon as render returns
+    memset(group.push_buffer, 0xCD, group.push_buffer_size);
+    group.bounds.min_x[1] = f32_max;
+
+    REQUIRE(copy.sort_keys.count() == 2);
+    i32 order[2] = { 0, 1 };
+    TileBins bins = bin_render_commands(&copy, order, &buffer, &arena);
+    CHECK(tile_bins_count(&bins, 0) == 1);
+    CHECK(tile_bins_count(&bins, 5) == 1);
+    CHECK(tile_bins_count(&bins, 6) == 1);
+    CHECK(tile_bins_count(&bins, 1) == 0);
+    auto* quad = (RenderEntryQuad*)(copy.push_buffer + copy.sort_entries_offset[1] + sizeof(RenderGroupEntryHeader));
+    CHECK(quad->quad.max_x == 40.0f);
+}
+
+TEST_CASE_FIXTURE(RendererArenaFixture, "bin_render_commands bins a bitmap batch by the bounds of all its instances") {
+    Framebuffer buffer = create_frame_buffer(arena, 64, 64);
+    buffer.tiles = generate_tiles(buffer.width, buffer.height, 16, 16, &arena);
+
+    RenderGroup group = create_render_group(arena, 4);
+    RenderEntryBitmapBatch entry = {};
+    entry.quad = { .bl = vec2(-0.5f, -0.5f), .tl = vec2(-0.5f, 0.5f), .tr = vec2(0.5f, 0.5f), .br = vec2(0.5f, -0.5f) };
+    entry.count = 2;
+    auto* batch = push_bitmap_batch(&group, entry, 0);
+    BitmapBatchInstances instances = get_bitmap_batch_instances(batch);
+    // One instance in tile (0, 0), one in tile (2, 0)
+    instances.offset_x[0] = 6.0f;
+    instances.offset_y[0] = 6.0f;
+    instances.offset_x[1] = 40.0f;
+    instances.offset_y[1] = 6.0f;
+    for (i32 i = 0; i < 2; i++) {
+        instances.scale_x[i] = 4.0f;
+        instances.scale_y[i] = 4.0f;
+    }
+    end_bitmap_batch(&group, batch);
+    REQUIRE(group.push_buffer_size == sizeof(RenderGroupEntryHeader) + sizeof(RenderEntryBitmapBatch) + bitmap_batch_instances_size(2));
+
+    i32 order[1] = { 0 };
+    TileBins bins = bin_render_commands(&group, order, &buffer, &arena);
+    // One command for the whole batch, the tiles between the instances included
+    CHECK(tile_bins_count(&bins, 0) == 1);
+    CHECK(tile_bins_count(&bins, 1) == 1);
+    CHECK(tile_bins_count(&bins, 2) == 1);
+    CHECK(tile_bins_count(&bins, 3) == 0);
+    CHECK(tile_bins_count(&bins, 4) == 0);
+}
+
+TEST_CASE_FIXTURE(RendererArenaFixture, "bin_render_commands bins a glyph run by the bounds of all its glyphs") {
+    Framebuffer buffer = create_frame_buffer(arena, 64, 64);
+    buffer.tiles = generate_tiles(buffer.width, buffer.height, 16, 16, &arena);
+
+    RenderGroup group = create_render_group(arena, 4);
+    auto* run = push_glyph_run(&group, { .color = vec4(1.0f, 1.0f, 1.0f, 1.0f), .texture_id = 1, .count = 2 }, 0);
+    GlyphRunGlyph* glyphs = get_glyph_run_glyphs(run);
+    // 8x14 glyphs, the second one reaches into tile (1, 1)
+    glyphs[0] = { .x = 2, .y = 2, .u_min = 0, .v_min = 0, .u_max = 8, .v_max = 14 };
+    glyphs[1] = { .x = 12, .y = 10, .u_min = 8, .v_min = 0, .u_max = 16, .v_max = 14 };
+    end_glyph_run(&group, run);
+    REQUIRE(group.push_buffer_size == sizeof(RenderGroupEntryHeader) + sizeof(RenderEntryGlyphRun) + 2 * sizeof(GlyphRunGlyph));
+
+    i32 order[1] = { 0 };
+    TileBins bins = bin_render_commands(&group, order, &buffer, &arena);
+    CHECK(tile_bins_count(&bins, 0) == 1);
+    CHECK(tile_bins_count(&bins, 1) == 1);
+    CHECK(tile_bins_count(&bins, 4) == 1);
+    CHECK(tile_bins_count(&bins, 5) == 1);
+    CHECK(tile_bins_count(&bins, 2) == 0);
+    CHECK(tile_bins_count(&bins, 8) == 0);
+}
+
+TEST_CASE_FIXTURE(RendererArenaFixture, "compute_tile_ranges SIMD path matches the scalar path") {
+    if (!cpu_supports_avx2()) {
+        return;
+    }
+    const i32 command_count = 203;
+    RenderGroup group = create_render_group(arena, command_count);
+    i32 order[command_count];
+    u32 random = 0x1234567;
+    for (i32 i = 0; i < command_count; i++) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        f32 x = (f32)(random % 1400) - 60.0f;
+        f32 y = (f32)((random >> 11) % 800) - 40.0f;
+        f32 size = (f32)((random >> 21) % 300);
+        Rectangle2f extents = { .min_x = x, .max_x = x + size, .min_y = y, .max_y = y + size * 0.5f };
+        // Full screen, empty, and on a tile edge
+        if (i % 17 == 0) {
+            extents = { .min_x = -f32_max, .max_x = f32_max, .min_y = -f32_max, .max_y = f32_max };
+        }
+        if (i % 19 == 0) {
+            extents = { .min_x = f32_max, .max_x = -f32_max, .min_y = f32_max, .max_y = -f32_max };
+        }
+        if (i % 23 == 0) {
+            extents = { .min_x = 65.0f, .max_x = 126.0f, .min_y = 33.0f, .max_y = 94.0f };
+        }
+        *group.bounds.min_x.push() = extents.min_x;
+        *group.bounds.max_x.push() = extents.max_x;
+        *group.bounds.min_y.push() = extents.min_y;
+        *group.bounds.max_y.push() = extents.max_y;
+        order[i] = (i * 5) % command_count;
+    }
+
+    TileGrid grid = { .width = 1280, .height = 720, .tile_width = 64, .tile_height = 32 };
+    CommandTileRanges expected = {};
+    CommandTileRanges actual = {};
+    for (CommandTileRanges* ranges : { &expected, &actual }) {
+        ranges->min_x = allocate<i32>(arena, 208);
+        ranges->max_x = allocate<i32>(arena, 208);
+        ranges->min_y = allocate<i32>(arena, 208);
+        ranges->max_y = allocate<i32>(arena, 208);
+    }
+    compute_tile_ranges_scalar(&group.bounds, order, command_count, grid, &expected);
+    compute_tile_ranges_AVX2(&group.bounds, order, command_count, grid, &actual);
+    for (i32 i = 0; i < command_count; i++) {
+        CAPTURE(i);
+        REQUIRE_EQ(actual.min_x[i], expected.min_x[i]);
+        REQUIRE_EQ(actual.max_x[i], expected.max_x[i]);
+        REQUIRE_EQ(actual.min_y[i], expected.min_y[i]);
+        REQUIRE_EQ(actual.max_y[i], expected.max_y[i]);
+    }
+
+    for (i32 i = 0; i < command_count; i++) {
+        if (order[i] == 17) {
+            CHECK(expected.min_x[i] == 0);
+            CHECK(expected.max_x[i] == 19);
+            CHECK(expected.min_y[i] == 0);
+            CHECK(expected.max_y[i] == 22);
+        }
+        if (order[i] == 19) {
+            CHECK(expected.min_x[i] > expected.max_x[i]);
+        }
+        if (order[i] == 23) {
+            CHECK(expected.min_x[i] == 1);
+            CHECK(expected.max_x[i] == 1);
+            CHECK(expected.min_y[i] == 1);
+            CHECK(expected.max_y[i] == 2);
+        }
+    }
+}
+
+TEST_CASE_FIXTURE(RendererArenaFixture, "hash_tile_commands only changes for the tiles a changed command touches") {
+    Framebuffer buffer = create_frame_buffer(arena, 64, 64);
+    buffer.tiles = generate_tiles(buffer.width, buffer.height, 16, 16, &arena);
+    i32 order[3] = { 0, 1, 2 };
+
+    RenderGroup previous = create_render_group(arena, 4);
+    push_clear(&previous, {}, 0);
+    push_white_quad(&previous, 2.0f, 2.0f, 10.0f, 10.0f);   // tile (0, 0)
+    push_white_quad(&previous, 20.0f, 20.0f, 24.0f, 24.0f); // tile (1, 1)
+
+    RenderGroup current = create_render_group(arena, 4);
+    push_clear(&current, {}, 0);
+    push_white_quad(&current, 2.0f, 2.0f, 10.0f, 10.0f);
+    push_white_quad(&current, 20.0f, 20.0f, 25.0f, 24.0f);
+
+    TileBins previous_bins = bin_render_commands(&previous, order, &buffer, &arena);
+    TileBins current_bins = bin_render_commands(&current, order, &buffer, &arena);
+    u64* previous_hashes = hash_render_commands(&previous, &arena);
+    u64* current_hashes = hash_render_commands(&current, &arena);
+
+    for (i32 i = 0; i < 16; i++) {
+        u64 previous_hash = hash_tile_commands(
+            previous_hashes, tile_bins_commands(&previous_bins, i), tile_bins_count(&previous_bins, i));
+        u64 current_hash = hash_tile_commands(
+            current_hashes, tile_bins_commands(&current_bins, i), tile_bins_count(&current_bins, i));
+        CHECK(previous_hash != 0);
+        if (i == 5) {
+            CHECK(previous_hash != current_hash);
+        }
+        else {
+            CHECK(previous_hash == current_hash);
+        }
+    }
+}
+
+TEST_CASE_FIXTURE(RendererArenaFixture, "hash_tile_commands depends on render order") {
+    RenderGroup group = create_render_group(arena, 4);
+    push_white_quad(&group, 2.0f, 2.0f, 4.0f, 4.0f);
+    push_white_quad(&group, 3.0f, 3.0f, 5.0f, 5.0f);
+    u64* hashes = hash_render_commands(&group, &arena);
+
+    i32 order_a[2] = { 0, 1 };
+    i32 order_b[2] = { 1, 0 };
+    CHECK(hash_tile_commands(hashes, order_a, 2) != hash_tile_commands(hashes, order_b, 2));
+}
+
+TEST_CASE_FIXTURE(RendererArenaFixture, "push helpers write the command bounds when they push") {
+    RenderGroup group = create_render_group(arena, 4);
+    push_clear(&group, {}, 0);
+    push_white_quad(&group, 2.0f, 3.0f, 10.0f, 12.0f);
+    push_filled_circle(&group, { .P = vec2(20.0f, 30.0f), .radius = 4.0f, .color = vec4(1.0f, 1.0f, 1.0f, 1.0f) }, 0);
+    REQUIRE(group.bounds.min_x.count() == 3);
+
+    CHECK(group.bounds.min_x[0] == -f32_max);
+    CHECK(group.bounds.max_y[0] == f32_max);
+    CHECK(group.bounds.min_x[1] == 2.0f);
+    CHECK(group.bounds.max_x[1] == 10.0f);
+    CHECK(group.bounds.min_y[1] == 3.0f);
+    CHECK(group.bounds.max_y[1] == 12.0f);
+    CHECK(group.bounds.min_x[2] == 16.0f);
+    CHECK(group.bounds.max_x[2] == 24.0f);
+    CHECK(group.bounds.min_y[2] == 26.0f);
+    CHECK(group.bounds.max_y[2] == 34.0f);
+}
+
+TEST_CASE_FIXTURE(RendererArenaFixture, "equal commands hash the same over a dirty push buffer") {
+    RenderGroup group = create_render_group(arena, 4);
+    // Left over from an earlier frame
+    memset(group.push_buffer, 0xCD, group.max_push_buffer_size);
+    push_white_quad(&group, 2.0f, 2.0f, 4.0f, 4.0f);
+    auto* first = push_glyph_run(&group, { .color = vec4(1.0f, 1.0f, 1.0f, 1.0f), .texture_id = 1, .count = 1 }, 0);
+    *get_glyph_run_glyphs(first) = { .x = 2, .y = 2, .u_min = 0, .v_min = 0, .u_max = 8, .v_max = 14 };
+    end_glyph_run(&group, first);
+
+    memset(group.push_buffer + group.push_buffer_size, 0xAB, group.max_push_buffer_size - group.push_buffer_size);
+    push_white_quad(&group, 2.0f, 2.0f, 4.0f, 4.0f);
+    auto* second = push_glyph_run(&group, { .color = vec4(1.0f, 1.0f, 1.0f, 1.0f), .texture_id = 1, .count = 1 }, 0);
+    *get_glyph_run_glyphs(second) = { .x = 2, .y = 2, .u_min = 0, .v_min = 0, .u_max = 8, .v_max = 14 };
+    end_glyph_run(&group, second);
+
+    u64* hashes = hash_render_commands(&group, &arena);
+    CHECK(hashes[0] == hashes[2]);
+    CHECK(hashes[1] == hashes[3]);
+    CHECK(hashes[0] != hashes[1]);
+}
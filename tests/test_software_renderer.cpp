@@ -0,0 +1,525 @@
+#include "doctest.h"
+
+static auto blend_span_kernels() -> Array<blend_span_fn> {
+    static blend_span_fn kernels[2] = {
+        blend_span_avx2,
+        blend_span_avx512,
+    };
+    return Array<blend_span_fn>(kernels, cpu_supports_avx512f() ? 2 : 1);
+}
+
+TEST_CASE("blend_span SIMD paths match the scalar path") {
+    // A span of count pixels with a border of sentinels on both sides, the border must not be touched.
+    const i32 border = AVX512_LANE_COUNT;
+    const i32 max_count = 67;
+    u32 expected[border + max_count + border];
+    u32 result[border + max_count + border];
+    const u32 sentinel = 0x12345678;
+
+    i32 counts[] = { 1, 7, 8, 9, 15, 16, 17, 31, 33, 67 };
+    f32 alphas[] = { 0.0f, 1.0f, 0.706f };
+    // Every value of every channel, then backgrounds whose blocks repeat: flat, a check pattern and zero
+    enum { Background_Varied, Background_Flat, Background_Check, Background_Zero, Background_Count };
+    for (i32 test_idx = 0; test_idx < Background_Count * ArrayCount(alphas) * ArrayCount(counts); test_idx++) {
+        i32 background = test_idx / (ArrayCount(alphas) * ArrayCount(counts));
+        f32 alpha = alphas[(test_idx / ArrayCount(counts)) % ArrayCount(alphas)];
+        i32 count = counts[test_idx % ArrayCount(counts)];
+        vec4 color = vec4(0.902f, 0.098f, 0.294f, alpha);
+        for (i32 i = 0; i < ArrayCount(expected); i++) {
+            u32 v = (u32)(i * 37 + count);
+            u32 pixel = ((v * 7) & 0xFF) << 24 | (v & 0xFF) << 16 | ((v * 3) & 0xFF) << 8 | ((v * 5) & 0xFF);
+            switch (background) {
+            case Background_Flat: pixel = 0xFF336699; break;
+            case Background_Check: pixel = i % 2 == 0 ? 0xFF1A1A1A : 0xFF333333; break;
+            case Background_Zero: pixel = 0; break;
+            }
+            expected[i] = i < border || i >= border + count ? sentinel : pixel;
+        }
+        memcpy(result, expected, sizeof(expected));
+        blend_span_scalar(expected + border, count, color);
+
+        for (auto blend : blend_span_kernels()) {
+            u32 dest[ArrayCount(result)];
+            memcpy(dest, result, sizeof(result));
+            blend(dest + border, count, color);
+            for (i32 i = 0; i < ArrayCount(expected); i++) {
+                REQUIRE_EQ(dest[i], expected[i]);
+            }
+        }
+    }
+}
+
+TEST_CASE("draw_rectangle gives a translucent border the same pixels with every blend_span") {
+    const i32 width = 48;
+    const i32 height = 40;
+    MemoryArena arena = {};
+    arena.init(malloc(MegaBytes(1)), MegaBytes(1));
+    Framebuffer expected = create_frame_buffer(arena, width, height);
+    Framebuffer result = create_frame_buffer(arena, width, height);
+    // Only part of the rectangle, so the border is clipped on two sides
+    Tile tile = {};
+    tile.rect = { 3, 41, 2, 37 };
+
+    blend_span_fn selected_blend_span = blend_span;
+    blend_span_fn kernels[3] = { blend_span_scalar, blend_span_avx2, blend_span_avx512 };
+    i32 kernel_count = cpu_supports_avx512f() ? 3 : 2;
+    for (i32 kernel_idx = 0; kernel_idx < kernel_count; kernel_idx++) {
+        Framebuffer* buffer = kernel_idx == 0 ? &expected : &result;
+        for (i32 i = 0; i < width * height; i++) {
+            ((u32*)buffer->memory)[i] = 0xFF000000 | (u32)(i * 2654435761u >> 8);
+        }
+        blend_span = kernels[kernel_idx];
+        Rectangle2f rect = { -5.0f, 30.0f, 6.0f, 50.0f };
+        draw_rectangle(rect, vec4(0.2f, 0.4f, 0.6f, 0.706f), 4.0f, vec4(1.0f, 0.5f, 0.0f, 0.5f), &tile, buffer);
+        if (kernel_idx > 0) {
+            REQUIRE_EQ(memcmp(expected.memory, result.memory, expected.memory_size), 0);
+        }
+    }
+    blend_span = selected_blend_span;
+    free(arena.m_memory);
+}
+
+// Every test that adds a texture uses its own id, textures live as long as the renderer
+const i32 Test_Texture_Mips = MaxTextureId - 1;
+const i32 Test_Texture_Alpha = MaxTextureId - 2;
+const i32 Test_Texture_Tint = MaxTextureId - 3;
+
+TEST_CASE("texel_index_v8 matches texel_index in both layouts") {
+    // Not a multiple of the block size, so the padded blocks are in there too
+    const i32 width = 13;
+    const i32 height = 10;
+    TextureLayout layouts[] = { TextureLayout_Linear, TextureLayout_Blocks4x4 };
+    for (TextureLayout layout : layouts) {
+        SWTexture texture = {};
+        texture.width = width;
+        texture.height = height;
+        texture.layout = layout;
+        texture.block_count_x = (width + TextureBlockDim - 1) / TextureBlockDim;
+        i32 block_count_y = (height + TextureBlockDim - 1) / TextureBlockDim;
+        i32 stored_count = layout == TextureLayout_Blocks4x4
+                               ? texture.block_count_x * block_count_y * TextureBlockDim * TextureBlockDim
+                               : width * height;
+
+        bool is_used[256] = {};
+        REQUIRE(stored_count <= ArrayCount(is_used));
+        for (i32 y = 0; y < height; y++) {
+            for (i32 x = 0; x < width; x += AVX2_LANE_COUNT) {
+                __m256i x_v8 = _mm256_add_epi32(_mm256_set1_epi32(x), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+                i32 indices[AVX2_LANE_COUNT];
+                _mm256_storeu_si256((__m256i*)indices, texel_index_v8(&texture, x_v8, _mm256_set1_epi32(y)));
+                for (i32 lane = 0; lane < AVX2_LANE_COUNT && x + lane < width; lane++) {
+                    i32 index = texel_index(&texture, x + lane, y);
+                    REQUIRE_EQ(indices[lane], index);
+                    REQUIRE(index < stored_count);
+                    REQUIRE_FALSE(is_used[index]);
+                    is_used[index] = true;
+                }
+            }
+        }
+        if (layout == TextureLayout_Blocks4x4) {
+            // A 4x4 block is 16 consecutive texels, one cache line
+            REQUIRE_EQ(texel_index(&texture, 3, 3), 15);
+            REQUIRE_EQ(texel_index(&texture, 4, 0), 16);
+            REQUIRE_EQ(texel_index(&texture, 0, 4), 16 * texture.block_count_x);
+        }
+    }
+}
+
+TEST_CASE("select_mip_level picks the largest level that is not magnified") {
+    // Left half black, right half white, so the levels can be told apart by their texels
+    const i32 dim = 32;
+    u32 rgba[dim * dim];
+    for (i32 y = 0; y < dim; y++) {
+        for (i32 x = 0; x < dim; x++) {
+            rgba[y * dim + x] = x < dim / 2 ? 0xFF000000 : 0xFFFFFFFF;
+        }
+    }
+    // Only added on the first run, doctest runs the test once per subcase
+    software_renderer_add_texture_with_layout(Test_Texture_Mips, rgba, dim, dim, BYTES_PER_PIXEL, PixelFormat_RGBA8,
+        TextureLayout_Blocks4x4);
+    SWTexture* texture = &state.textures[Test_Texture_Mips];
+    REQUIRE(texture->data);
+    // 16, 8, 4, 2 and 1 texels wide
+    REQUIRE_EQ(texture->mip_count, 5);
+    for (i32 level = 1; level <= texture->mip_count; level++) {
+        SWTexture* mip = &texture->mips[level - 1];
+        REQUIRE_EQ(mip->width, dim >> level);
+        REQUIRE_EQ(mip->layout, TextureLayout_Blocks4x4);
+    }
+    // The box filter keeps the edge between the halves where it was
+    SWTexture* level1 = &texture->mips[0];
+    REQUIRE_EQ(((u32*)level1->data)[texel_index(level1, 7, 3)], 0xFF000000);
+    REQUIRE_EQ(((u32*)level1->data)[texel_index(level1, 8, 3)], 0xFFFFFFFF);
+
+    SUBCASE("1x is the base level") {
+        MipSelection mip = select_mip_level(texture, vec2(1.0f, 0.0f), vec2(0.0f, 1.0f));
+        REQUIRE_EQ(mip.level, 0);
+        REQUIRE_EQ(mip.texture, texture);
+        REQUIRE_EQ(mip.scale, 1.0f);
+        // Just short of 2x, still the base level
+        REQUIRE_EQ(select_mip_level(texture, vec2(1.9f, 0.0f), vec2(0.0f, 1.0f)).level, 0);
+    }
+
+    SUBCASE("2x is level 1") {
+        // Rotated, so the steps are not along the axes. The larger one decides.
+        MipSelection mip = select_mip_level(texture, vec2(1.2f, 1.6f), vec2(-0.8f, 0.6f));
+        REQUIRE_EQ(mip.level, 1);
+        REQUIRE_EQ(mip.texture, &texture->mips[0]);
+        REQUIRE_EQ(mip.scale, 0.5f);
+
+        Rectangle2i rect = to_mip_texel_rect(mip, { 4, 11, 8, 15 });
+        REQUIRE_EQ(rect.min_x, 2);
+        REQUIRE_EQ(rect.max_x, 5);
+        REQUIRE_EQ(rect.min_y, 4);
+        REQUIRE_EQ(rect.max_y, 7);
+        // Texel centers stay on each other: base texel 0.5 is between level 1 texels 0 and 1
+        REQUIRE_EQ(to_mip_texel(0.5f, mip.scale), 0.0f);
+        REQUIRE_EQ(to_mip_texel(2.5f, mip.scale), 1.0f);
+    }
+
+    SUBCASE("4x is level 2") {
+        MipSelection mip = select_mip_level(texture, vec2(0.0f, 1.0f), vec2(4.0f, 0.0f));
+        REQUIRE_EQ(mip.level, 2);
+        REQUIRE_EQ(mip.texture, &texture->mips[1]);
+        REQUIRE_EQ(mip.scale, 0.25f);
+
+        Rectangle2i rect = to_mip_texel_rect(mip, { 4, 31, 8, 15 });
+        REQUIRE_EQ(rect.min_x, 1);
+        REQUIRE_EQ(rect.max_x, 7);
+        REQUIRE_EQ(rect.min_y, 2);
+        REQUIRE_EQ(rect.max_y, 3);
+    }
+
+    SUBCASE("past the smallest level") {
+        MipSelection mip = select_mip_level(texture, vec2(1000.0f, 0.0f), vec2(0.0f, 1000.0f));
+        REQUIRE_EQ(mip.level, texture->mip_count);
+        Rectangle2i rect = to_mip_texel_rect(mip, { 0, 31, 0, 31 });
+        REQUIRE_EQ(rect.max_x, 0);
+        REQUIRE_EQ(rect.max_y, 0);
+    }
+}
+
+TEST_CASE("draw_bitmap_avx2 skips hidden lanes, writes opaque ones and blends the rest like the scalar path") {
+    // Straight alpha RGBA bytes: transparent white, opaque blue and half transparent green bands
+    const i32 dim = 16;
+    u32 rgba[dim * dim];
+    for (i32 y = 0; y < dim; y++) {
+        for (i32 x = 0; x < dim; x++) {
+            rgba[y * dim + x] = x < 5 ? 0x00FFFFFF : x < 11 ? 0xFFC06020 : 0x8040E040;
+        }
+    }
+    software_renderer_add_texture_with_layout(Test_Texture_Alpha, rgba, dim, dim, BYTES_PER_PIXEL, PixelFormat_RGBA8,
+        TextureLayout_Blocks4x4);
+    SWTexture* texture = &state.textures[Test_Texture_Alpha];
+    REQUIRE(texture->data);
+    // Premultiplied when it is added, so a transparent texel is zero whatever its color was
+    REQUIRE_EQ(((u32*)texture->data)[texel_index(texture, 0, 0)], 0u);
+
+    const i32 width = 61;
+    const i32 height = 47;
+    MemoryArena arena = {};
+    arena.init(malloc(MegaBytes(1)), MegaBytes(1));
+    Framebuffer background = create_frame_buffer(arena, width, height);
+    Framebuffer expected = create_frame_buffer(arena, width, height);
+    Framebuffer result = create_frame_buffer(arena, width, height);
+    for (i32 i = 0; i < width * height; i++) {
+        // Not opaque, so the pixels an opaque texel wrote are the ones with alpha 255
+        ((u32*)background.memory)[i] = 0x40000000 | (u32)(i * 2654435761u >> 8);
+    }
+    Tile tile = {};
+    tile.rect = { 0, width, 0, height };
+    Quadrilateral quad = { .bl = vec2(-0.5f, -0.5f), .tl = vec2(-0.5f, 0.5f), .tr = vec2(0.5f, 0.5f), .br = vec2(0.5f, -0.5f) };
+    BitmapTexture bitmap = setup_bitmap_texture(Test_Texture_Alpha, ivec2(0, 0), ivec2(0, 0));
+
+    f32 rotations[] = { 0.0f, 0.4f };
+    for (f32 rotation : rotations) {
+        memcpy(expected.memory, background.memory, background.memory_size);
+        memcpy(result.memory, background.memory, background.memory_size);
+        BitmapInstance instance = setup_bitmap_instance(&bitmap, quad, vec2(30.0f, 23.0f), vec2(37.0f, 37.0f), rotation);
+        draw_bitmap_scalar(&bitmap, quad, &instance, vec4(1, 1, 1, 1), 0.0f, vec4(0, 0, 0, 0), &tile, &expected);
+        draw_bitmap_avx2(&bitmap, quad, &instance, vec4(1, 1, 1, 1), 0.0f, vec4(0, 0, 0, 0), &tile, &result);
+
+        i32 hidden_count = 0;
+        i32 opaque_count = 0;
+        i32 blended_count = 0;
+        for (i32 i = 0; i < width * height; i++) {
+            u32 before = ((u32*)background.memory)[i];
+            u32 scalar = ((u32*)expected.memory)[i];
+            u32 simd = ((u32*)result.memory)[i];
+            if (scalar == before) {
+                // Nothing covered it, or only transparent texels did
+                REQUIRE_EQ(simd, before);
+                hidden_count++;
+            }
+            else if (scalar >> 24 == 0xFF) {
+                REQUIRE_EQ(simd, scalar);
+                opaque_count++;
+            }
+            else {
+                // Partly covered. draw_bitmap_avx2 converts with gamma 2.0 instead of the sRGB tables, which is at most
+                // 10 levels off in the mid tones.
+                for (i32 shift = 0; shift < 32; shift += 8) {
+                    i32 difference = (i32)((scalar >> shift) & 0xFF) - (i32)((simd >> shift) & 0xFF);
+                    REQUIRE(abs(difference) <= 10);
+                }
+                blended_count++;
+            }
+        }
+        REQUIRE(hidden_count > 0);
+        REQUIRE(opaque_count > 0);
+        REQUIRE(blended_count > 0);
+    }
+    free(arena.m_memory);
+}
+
+TEST_CASE("setup_bitmap_instances sets up every lane like the mat2 math, and flags the ones that touch the clip rect") {
+    Quadrilateral quad = { .bl = vec2(-0.5f, -0.5f), .tl = vec2(-0.5f, 0.5f), .tr = vec2(0.5f, 0.5f), .br = vec2(0.5f, -0.5f) };
+    BitmapTexture bitmap = {};
+    bitmap.uv_rect = { 0, 15, 0, 7 };
+    // The last lane has no area, its inverse is the identity like the one of inverse()
+    f32 offset_x[8] = { 10.0f, 50.0f, -20.0f, 30.0f, 64.5f, 0.0f, 100.0f, 40.0f };
+    f32 offset_y[8] = { 10.0f, 20.0f, 30.0f, -15.0f, 24.0f, 0.0f, 10.0f, 40.0f };
+    f32 scale_x[8] = { 8.0f, 16.0f, 8.0f, 12.0f, 3.0f, 20.0f, 8.0f, 0.0f };
+    f32 scale_y[8] = { 8.0f, 4.0f, 8.0f, 12.0f, 5.0f, 20.0f, 8.0f, 0.0f };
+    f32 rotation[8] = { 0.0f, 0.3f, -1.2f, 2.0f, 3.1f, 0.7f, 0.0f, 0.0f };
+    Rectangle2i clip_rect = { 0, 64, 0, 48 };
+    BitmapInstance setups[8];
+    u32 overlap_bits = setup_bitmap_instances(&bitmap, quad, offset_x, offset_y, scale_x, scale_y, rotation, clip_rect, setups);
+
+    for (i32 i = 0; i < 8; i++) {
+        mat2 M = mat2_rotate(rotation[i]) * mat2_scale(vec2(scale_x[i], scale_y[i]));
+        mat2 M_inv = inverse(M);
+        BitmapInstance& setup = setups[i];
+        REQUIRE(fabsf(setup.screen_to_model.xx - M_inv.xx) < 1e-5f);
+        REQUIRE(fabsf(setup.screen_to_model.xy - M_inv.xy) < 1e-5f);
+        REQUIRE(fabsf(setup.screen_to_model.yx - M_inv.yx) < 1e-5f);
+        REQUIRE(fabsf(setup.screen_to_model.yy - M_inv.yy) < 1e-5f);
+
+        vec2 offset = vec2(offset_x[i], offset_y[i]);
+        vec2 corners[4] = { quad.bl * M + offset, quad.tl * M + offset, quad.tr * M + offset, quad.br * M + offset };
+        vec2 setup_corners[4] = { setup.bl, setup.tl, setup.tr, setup.br };
+        f32 min_x = corners[0].x, max_x = corners[0].x, min_y = corners[0].y, max_y = corners[0].y;
+        for (i32 j = 0; j < 4; j++) {
+            REQUIRE(fabsf(setup_corners[j].x - corners[j].x) < 1e-4f);
+            REQUIRE(fabsf(setup_corners[j].y - corners[j].y) < 1e-4f);
+            min_x = hm::min(min_x, corners[j].x);
+            max_x = hm::max(max_x, corners[j].x);
+            min_y = hm::min(min_y, corners[j].y);
+            max_y = hm::max(max_y, corners[j].y);
+        }
+        REQUIRE_EQ(setup.rect.min_x, round_f32_to_i32(min_x));
+        REQUIRE_EQ(setup.rect.max_x, round_f32_to_i32(max_x));
+        REQUIRE_EQ(setup.rect.min_y, round_f32_to_i32(min_y));
+        REQUIRE_EQ(setup.rect.max_y, round_f32_to_i32(max_y));
+        if (scale_x[i] != 0.0f) {
+            REQUIRE(fabsf(setup.texel_scale.x - 15.0f) < 1e-5f);
+            REQUIRE(fabsf(setup.texel_scale.y - 7.0f) < 1e-5f);
+        }
+
+        bool overlaps = hm::max(setup.rect.min_x, clip_rect.min_x) < hm::min(setup.rect.max_x, clip_rect.max_x) &&
+                        hm::max(setup.rect.min_y, clip_rect.min_y) < hm::min(setup.rect.max_y, clip_rect.max_y);
+        REQUIRE_EQ((overlap_bits >> i) & 1, (u32)overlaps);
+    }
+    // Off the left, the top and the right edge, and a quad with no area
+    REQUIRE_EQ(overlap_bits, 0b00110011u);
+}
+
+TEST_CASE("textured bitmaps are tinted by their color, and a batch draws like its instances one by one") {
+    // Straight alpha RGBA bytes: opaque white and half transparent grey bands
+    const i32 dim = 16;
+    u32 rgba[dim * dim];
+    for (i32 i = 0; i < dim * dim; i++) {
+        rgba[i] = i % dim < 8 ? 0xFFFFFFFF : 0x80808080;
+    }
+    software_renderer_add_texture_with_layout(Test_Texture_Tint, rgba, dim, dim, BYTES_PER_PIXEL, PixelFormat_RGBA8,
+        TextureLayout_Blocks4x4);
+    REQUIRE(state.textures[Test_Texture_Tint].data);
+
+    const i32 width = 64;
+    const i32 height = 48;
+    MemoryArena arena = {};
+    arena.init(malloc(MegaBytes(1)), MegaBytes(1));
+    Framebuffer expected = create_frame_buffer(arena, width, height);
+    Framebuffer result = create_frame_buffer(arena, width, height);
+    Tile tile = {};
+    tile.rect = { 0, width, 0, height };
+    Quadrilateral quad = { .bl = vec2(-0.5f, -0.5f), .tl = vec2(-0.5f, 0.5f), .tr = vec2(0.5f, 0.5f), .br = vec2(0.5f, -0.5f) };
+    BitmapTexture bitmap = setup_bitmap_texture(Test_Texture_Tint, ivec2(0, 0), ivec2(0, 0));
+
+    draw_bitmap_fn kernels[] = { draw_bitmap_scalar, draw_bitmap_avx2 };
+    BitmapInstance instance = setup_bitmap_instance(&bitmap, quad, vec2(32.0f, 24.0f), vec2(30.0f, 30.0f), 0.3f);
+    for (draw_bitmap_fn kernel : kernels) {
+        // Blue only keeps the blue channel, a transparent tint hides the texels
+        memset(result.memory, 0, result.memory_size);
+        kernel(&bitmap, quad, &instance, vec4(0, 0, 1, 1), 0.0f, vec4(0, 0, 0, 0), &tile, &result);
+        i32 written_count = 0;
+        for (i32 i = 0; i < width * height; i++) {
+            u32 pixel = ((u32*)result.memory)[i];
+            REQUIRE_EQ(pixel & 0x00FFFF00, 0u);
+            written_count += pixel != 0;
+        }
+        REQUIRE(written_count > 0);
+
+        memset(result.memory, 0, result.memory_size);
+        kernel(&bitmap, quad, &instance, vec4(1, 1, 1, 0), 0.0f, vec4(0, 0, 0, 0), &tile, &result);
+        for (i32 i = 0; i < width * height; i++) {
+            REQUIRE_EQ(((u32*)result.memory)[i], 0u);
+        }
+    }
+
+    // Overlapping instances, so the order they are drawn in shows
+    const i32 count = 3;
+    u32 batch_size = sizeof(RenderEntryBitmapBatch) + bitmap_batch_instances_size(count);
+    auto* batch = (RenderEntryBitmapBatch*)allocate<u8>(arena, batch_size);
+    memset(batch, 0, batch_size);
+    batch->quad = quad;
+    batch->texture_id = Test_Texture_Tint;
+    batch->count = count;
+    BitmapBatchInstances instances = get_bitmap_batch_instances(batch);
+    vec4 colors[count] = { vec4(1, 1, 1, 1), vec4(1.0f, 0.5f, 0.25f, 0.75f), vec4(0.2f, 0.9f, 0.4f, 1.0f) };
+    for (i32 i = 0; i < count; i++) {
+        instances.offset_x[i] = 20.0f + (f32)i * 12.0f;
+        instances.offset_y[i] = 18.0f + (f32)i * 6.0f;
+        instances.scale_x[i] = 24.0f;
+        instances.scale_y[i] = 20.0f + (f32)i * 4.0f;
+        instances.rotation[i] = (f32)i * 0.5f;
+        instances.color[i] = colors[i];
+    }
+
+    for (draw_bitmap_fn kernel : kernels) {
+        draw_bitmap = kernel;
+        memset(expected.memory, 0x20, expected.memory_size);
+        memset(result.memory, 0x20, result.memory_size);
+        for (i32 i = 0; i < count; i++) {
+            BitmapInstance one = setup_bitmap_instance(&bitmap, quad, vec2(instances.offset_x[i], instances.offset_y[i]),
+                vec2(instances.scale_x[i], instances.scale_y[i]), instances.rotation[i]);
+            draw_bitmap(&bitmap, quad, &one, instances.color[i], 0.0f, vec4(0, 0, 0, 0), &tile, &expected);
+        }
+        draw_bitmap_batch(batch, &tile, &result);
+        REQUIRE_EQ(memcmp(expected.memory, result.memory, expected.memory_size), 0);
+    }
+    software_renderer_select_kernels();
+    free(arena.m_memory);
+}
+
+// Two layers into the same framebuffer: the second is rendered over the first in the same frame. Part of each
+// layer stays still, so tiles are skipped from one frame to the next too.
+static auto push_frame_loop_layer(RenderGroup* group, i32 frame_index, i32 layer) -> void {
+    f32 t = (f32)frame_index;
+    if (layer == 0) {
+        // Marks every tile dirty. After a plain clear, a tile nothing else draws to is clean and is not composited,
+        // so the platform buffer would keep what earlier frames left there.
+        push_clear_check_pattern(
+            group, { .color1 = vec4(0.1f, 0.1f, 0.2f, 1.0f), .color2 = vec4(0.2f, 0.2f, 0.3f, 1.0f) }, 0);
+        // Slow to render, so the tiles of the second layer are queued while these are still being drawn
+        for (i32 i = 0; i < 48; i++) {
+            RenderEntryQuad veil = {};
+            veil.quad = { .min_x = 0.0f, .max_x = 640.0f, .min_y = 0.0f, .max_y = 360.0f };
+            veil.color = vec4(0.5f, 0.1f * (f32)(i % 8), 0.3f, 0.1f);
+            push_quad(group, veil, 1);
+        }
+        RenderEntryQuad still = {};
+        still.quad = { .min_x = 20.0f, .max_x = 140.0f, .min_y = 20.0f, .max_y = 90.0f };
+        still.color = vec4(0.9f, 0.6f, 0.1f, 1.0f);
+        push_quad(group, still, 1);
+        RenderEntryQuad moving = {};
+        moving.quad = { .min_x = 200.0f + 37.0f * t, .max_x = 290.0f + 37.0f * t, .min_y = 150.0f, .max_y = 260.0f };
+        moving.color = vec4(0.2f, 0.8f, 0.3f, 1.0f);
+        push_quad(group, moving, 1);
+    }
+    else {
+        RenderEntryQuad overlay = {};
+        overlay.quad = { .min_x = 500.0f - 29.0f * t, .max_x = 600.0f - 29.0f * t, .min_y = 100.0f, .max_y = 300.0f };
+        overlay.color = vec4(0.3f, 0.4f, 1.0f, 0.5f);
+        push_quad(group, overlay, 2);
+        RenderEntryFilledCircle circle = {};
+        circle.P = vec2(320.0f, 40.0f + 11.0f * t);
+        circle.radius = 25.0f;
+        circle.color = vec4(1.0f, 1.0f, 1.0f, 0.75f);
+        push_filled_circle(group, circle, 2);
+    }
+}
+
+// One engine frame: both layers rendered from the same group memory, which is reused as soon as render returns.
+static auto render_frame_loop_frame(FrameBufferHandle handle, i32 frame_index, MemoryArena* arena) -> void {
+    ThreadContext* thread_context = test_context.thread_context;
+    software_renderer_begin_frame(nullptr);
+    for (i32 layer = 0; layer < 2; layer++) {
+        arena->clear();
+        RenderGroup group = {};
+        group.max_push_buffer_size = KiloBytes(16);
+        group.push_buffer = allocate<u8>(*arena, group.max_push_buffer_size);
+        init_render_group_commands(&group, arena, 64);
+        push_frame_loop_layer(&group, frame_index, layer);
+        software_renderer_render(thread_context, true, &group, handle);
+        memset(group.push_buffer, 0xCD, group.max_push_buffer_size);
+    }
+    software_renderer_apply_framebuffer(thread_context, handle, ivec2(2, 2));
+    software_renderer_end_frame();
+}
+
+auto inline is_in_arena(void* memory, MemoryArena* arena) -> bool {
+    return (u8*)memory >= arena->m_memory && (u8*)memory < arena->m_memory + arena->m_capacity;
+}
+
+TEST_CASE("pipelined frames present the same pixels as direct ones, one frame later") {
+    const i32 frame_count = 8;
+    MemoryArena arena = {};
+    arena.init(malloc(MegaBytes(1)), MegaBytes(1));
+    FrameBufferHandle handle = software_renderer_create_framebuffer(CLIENT_WIDTH / 2, CLIENT_HEIGHT / 2);
+    u64 frame_size = state.platform_buffer.memory_size;
+    u8* direct = (u8*)malloc(frame_count * frame_size);
+    u8* presented = (u8*)malloc(frame_size);
+    REQUIRE(!state.is_pipelined);
+
+    // What the platform presents after each frame, rendered directly
+    for (i32 i = 0; i < frame_count; i++) {
+        render_frame_loop_frame(handle, i, &arena);
+        memcpy(direct + i * frame_size, state.platform_buffer.memory, frame_size);
+    }
+    REQUIRE_NE(memcmp(direct, direct + frame_size, frame_size), 0);
+
+    // The frame in flight is presented at the end of the next one. Until then the last direct frame stays.
+    software_renderer_set_pipelined(true);
+    u32 previous_arena_index = 0;
+    for (i32 i = 0; i < frame_count; i++) {
+        render_frame_loop_frame(handle, i, &arena);
+        REQUIRE(state.is_pipelined);
+        i32 presented_frame = i == 0 ? frame_count - 1 : i - 1;
+        REQUIRE_EQ(memcmp(direct + presented_frame * frame_size, state.platform_buffer.memory, frame_size), 0);
+
+        // Recorded into the other arena than the frame before, the one the frame in flight is still read from
+        REQUIRE_EQ(state.in_flight.render_count, 2);
+        MemoryArena* recording_arena = &state.frame_arenas[state.recording_arena_index];
+        for (i32 render_idx = 0; render_idx < state.in_flight.render_count; render_idx++) {
+            RenderGroup* group = &state.in_flight.renders[render_idx].group;
+            REQUIRE(is_in_arena(group->push_buffer, recording_arena));
+            REQUIRE(is_in_arena(group->sort_keys.data(), recording_arena));
+            REQUIRE(is_in_arena(group->bounds.min_x.data(), recording_arena));
+        }
+        if (i > 0) {
+            REQUIRE_NE(state.recording_arena_index, previous_arena_index);
+        }
+        previous_arena_index = state.recording_arena_index;
+    }
+
+    // Leaving pipelined mode composites the frame in flight, the frame after it is drawn over it and presented
+    software_renderer_set_pipelined(false);
+    render_frame_loop_frame(handle, frame_count - 1, &arena);
+    REQUIRE(!state.is_pipelined);
+    REQUIRE_EQ(memcmp(direct + (frame_count - 1) * frame_size, state.platform_buffer.memory, frame_size), 0);
+
+    // Toggled while running, a pipelined frame presents the one before it
+    for (i32 i = 0; i < frame_count; i++) {
+        bool is_pipelined = i >= 2 && i < 5;
+        software_renderer_set_pipelined(is_pipelined);
+        render_frame_loop_frame(handle, i, &arena);
+        memcpy(presented, state.platform_buffer.memory, frame_size);
+        i32 presented_frame = is_pipelined ? i - 1 : i;
+        REQUIRE_EQ(memcmp(direct + presented_frame * frame_size, presented, frame_size), 0);
+    }
+
+    free(presented);
+    free(direct);
+    free(arena.m_memory);
+}
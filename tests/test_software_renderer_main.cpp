@@ -0,0 +1,42 @@
+// Tests the software renderer's kernels and frame loop. A unity build of its own around the headless backend, as the
+// renderer brings its own copy of the core lib. Only builds on Linux.
+#define DOCTEST_CONFIG_IMPLEMENT
+#include "doctest.h"
+
+#include <renderers/headless_software_renderer.cpp>
+
+#include <linux_work_queue.hpp>
+
+struct SoftwareRendererTestContext {
+    PlatformApi platform;
+    PlatformWorkQueue queue;
+    StackArray<ThreadContext, TOTAL_THREAD_COUNT> thread_contexts;
+    StackArray<MemoryBlock, TOTAL_THREAD_COUNT> thread_memory;
+    ThreadContext* thread_context;
+};
+
+global_variable SoftwareRendererTestContext test_context = {};
+
+int main(int argc, char** argv) {
+    PlatformApi* platform = &test_context.platform;
+    platform->work_queue = &test_context.queue;
+    platform->add_work_queue_entry = linux_add_work_queue_entry;
+    platform->complete_all_work = linux_complete_all_work;
+    platform->print_stack_trace = linux_print_stack_trace;
+    platform->debug_table = (DebugTable*)allocate_pages(sizeof(DebugTable));
+
+    for (u32 i = 0; i < TOTAL_THREAD_COUNT; i++) {
+        test_context.thread_memory[i].size = MegaBytes(16);
+        test_context.thread_memory[i].data = allocate_pages(test_context.thread_memory[i].size);
+    }
+    linux_make_queue(platform, Array<ThreadContext>(test_context.thread_contexts.data(), TOTAL_THREAD_COUNT),
+        Array<MemoryBlock>(test_context.thread_memory.data(), TOTAL_THREAD_COUNT));
+    test_context.thread_context = &test_context.thread_contexts[MAIN_THREAD_IDX];
+
+    MemoryBlock renderer_memory = { allocate_pages(MegaBytes(64)), (u32)MegaBytes(64) };
+    headless_renderer_init(nullptr, platform, &renderer_memory);
+
+    return doctest::Context(argc, argv).run();
+}
+
+#include "test_software_renderer.cpp"
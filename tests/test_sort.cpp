@@ -190,3 +190,82 @@ TEST_CASE_FIXTURE(SingleArenaFixture, "merge_sort_indices: stable") {
     CHECK_EQ(indices[2], 2);
     CHECK_EQ(indices[3], 3);
 }
+
+TEST_CASE_FIXTURE(SingleArenaFixture, "radix_sort_indices: ") {
+    i32 list[4] = { 3, 2, 7, 1 };
+
+    i32* indices = radix_sort_indices(list, 4, &arena);
+
+    CHECK_EQ(indices[0], 3);
+    CHECK_EQ(indices[1], 1);
+    CHECK_EQ(indices[2], 0);
+    CHECK_EQ(indices[3], 2);
+    CHECK_EQ(list[0], 1);
+    CHECK_EQ(list[3], 7);
+}
+
+TEST_CASE_FIXTURE(SingleArenaFixture, "radix_sort_indices: negatives sort before positives") {
+    i32 list[5] = { 0, -1, 300, -70000, 2 };
+
+    i32* indices = radix_sort_indices(list, 5, &arena);
+
+    CHECK_EQ(list[0], -70000);
+    CHECK_EQ(list[1], -1);
+    CHECK_EQ(list[2], 0);
+    CHECK_EQ(list[3], 2);
+    CHECK_EQ(list[4], 300);
+    CHECK_EQ(indices[0], 3);
+    CHECK_EQ(indices[1], 1);
+    CHECK_EQ(indices[2], 0);
+    CHECK_EQ(indices[3], 4);
+    CHECK_EQ(indices[4], 2);
+}
+
+TEST_CASE_FIXTURE(SingleArenaFixture, "radix_sort_indices: stable") {
+    i32 list[6] = { 1, 0, 1, 0, 1, 0 };
+
+    i32* indices = radix_sort_indices(list, 6, &arena);
+
+    CHECK_EQ(indices[0], 1);
+    CHECK_EQ(indices[1], 3);
+    CHECK_EQ(indices[2], 5);
+    CHECK_EQ(indices[3], 0);
+    CHECK_EQ(indices[4], 2);
+    CHECK_EQ(indices[5], 4);
+}
+
+TEST_CASE_FIXTURE(SingleArenaFixture, "radix_sort_indices: single key returns identity") {
+    i32 list[4] = { 0, 0, 0, 0 };
+
+    i32* indices = radix_sort_indices(list, 4, &arena);
+
+    for (i32 i = 0; i < 4; i++) {
+        CHECK_EQ(indices[i], i);
+        CHECK_EQ(list[i], 0);
+    }
+}
+
+TEST_CASE("radix_sort_indices: matches merge_sort_indices") {
+    const size_t arena_size = KiloBytes(64);
+    MemoryArena arena;
+    arena.init(malloc(arena_size), arena_size);
+
+    const i32 count = 1000;
+    i32 radix_values[count];
+    i32 merge_values[count];
+    u32 seed = 1234;
+    for (i32 i = 0; i < count; i++) {
+        seed = seed * 1664525 + 1013904223;
+        radix_values[i] = (i32)seed >> (i % 24);
+        merge_values[i] = radix_values[i];
+    }
+
+    i32* radix_indices = radix_sort_indices(radix_values, count, &arena);
+    i32* merge_indices = merge_sort_indices(merge_values, count, &arena);
+    for (i32 i = 0; i < count; i++) {
+        REQUIRE_EQ(radix_values[i], merge_values[i]);
+        REQUIRE_EQ(radix_indices[i], merge_indices[i]);
+    }
+
+    free(arena.m_memory);
+}
@@ -0,0 +1,46 @@
+#include "doctest.h"
+
+#include <renderers/texture_format.hpp>
+
+TEST_CASE("Texture format, 4x4 blocks") {
+    // 6x5 texels is 2x2 blocks, the partial ones padded
+    REQUIRE_EQ(blocks4x4_texel_count(6, 5), 64);
+    REQUIRE_EQ(pixel_format_size(PixelFormat_SoftwareNative, 6, 5), 64 * sizeof(u32));
+    REQUIRE_EQ(pixel_format_size(PixelFormat_RGBA8, 6, 5), 30 * sizeof(u32));
+
+    REQUIRE_EQ(blocks4x4_texel_index(0, 0, 2), 0);
+    REQUIRE_EQ(blocks4x4_texel_index(3, 0, 2), 3);
+    REQUIRE_EQ(blocks4x4_texel_index(0, 1, 2), 4);
+    REQUIRE_EQ(blocks4x4_texel_index(4, 0, 2), 16);
+    REQUIRE_EQ(blocks4x4_texel_index(0, 4, 2), 32);
+    REQUIRE_EQ(blocks4x4_texel_index(5, 4, 2), 49);
+}
+
+TEST_CASE("Texture format, RGBA8 to software native and back") {
+    const i32 width = 6;
+    const i32 height = 5;
+    // Channels the 8 bit sRGB lookup tables round trip exactly
+    const u32 channels[3] = { 0x00, 0x80, 0xFF };
+    u32 rgba[width * height];
+    for (i32 i = 0; i < width * height; i++) {
+        // R G B A bytes, opaque except for the last row
+        u32 alpha = i < width * (height - 1) ? 0xFF : 0x00;
+        rgba[i] = alpha << 24 | channels[(i + 2) % 3] << 16 | channels[(i + 1) % 3] << 8 | channels[i % 3];
+    }
+
+    u32 native[64];
+    convert_rgba8_to_software_native(rgba, width, height, native);
+
+    // ARGB, at its place in the block
+    REQUIRE_EQ(native[blocks4x4_texel_index(1, 0, 2)], 0xFF80FF00u);
+    REQUIRE_EQ(native[blocks4x4_texel_index(5, 2, 2)], rgba8_to_software_native_texel(rgba[2 * width + 5]));
+    // Transparent is premultiplied to zero, the padding is zero too
+    REQUIRE_EQ(native[blocks4x4_texel_index(2, 4, 2)], 0u);
+    REQUIRE_EQ(native[blocks4x4_texel_index(7, 7, 2)], 0u);
+
+    u32 round_trip[width * height];
+    convert_software_native_to_rgba8(native, width, height, round_trip);
+    for (i32 i = 0; i < width * (height - 1); i++) {
+        REQUIRE_EQ(round_trip[i], rgba[i]);
+    }
+}